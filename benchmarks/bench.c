@@ -0,0 +1,161 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This benchmark driver times the stages of an ensemble's life cycle using
+// Skywalker's C interface: loading, traversal (with input gets and output
+// sets), writing, and freeing. It reports its results as a line of JSON.
+
+#include <skywalker.h>
+
+#include "bench_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PARAMS 64
+#define NAME_LEN   16
+
+static void usage(void) {
+  fprintf(stderr, "bench_c: times ensemble operations with Skywalker's C "
+                  "interface.\n");
+  fprintf(stderr, "bench_c: usage:\n");
+  fprintf(stderr, "bench_c <input.yaml>\n");
+  exit(-1);
+}
+
+// Retrieves the integer-valued setting with the given name, exiting on
+// failure.
+static int get_setting(sw_settings_t *settings, const char *name) {
+  sw_settings_result_t result = sw_settings_get(settings, name);
+  if (result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "bench_c: %s\n", result.error_message);
+    exit(-1);
+  }
+  int value = atoi(result.value);
+  if ((value < 0) || (value > MAX_PARAMS)) {
+    fprintf(stderr, "bench_c: invalid %s: %d\n", name, value);
+    exit(-1);
+  }
+  return value;
+}
+
+// Determines the name of the input (the base name of the input file without
+// its suffix) and the name of the corresponding output file.
+static void get_names(const char *input_file, char *input_name,
+                      char *output_file) {
+  const char *base = strrchr(input_file, '/');
+  base = base ? base + 1 : input_file;
+  size_t len = strcspn(base, ".");
+  if (len >= FILENAME_MAX/2) len = FILENAME_MAX/2 - 1;
+  memcpy(input_name, base, len);
+  input_name[len] = '\0';
+  snprintf(output_file, FILENAME_MAX, "bench_%s_c.py", input_name);
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    usage();
+  }
+  const char *input_file = argv[1];
+  char input_name[FILENAME_MAX/2], output_file[FILENAME_MAX];
+  get_names(input_file, input_name, output_file);
+
+  double times[BENCH_NUM_STAGES];
+
+  // Load the ensemble.
+  double t0 = bench_time();
+  sw_ensemble_result_t load_result = sw_load_ensemble(input_file, "settings");
+  times[BENCH_LOAD] = bench_time() - t0;
+  if (load_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "bench_c: %s", load_result.error_message);
+    exit(-1);
+  }
+  sw_ensemble_t *ensemble = load_result.ensemble;
+  size_t num_members = sw_ensemble_size(ensemble);
+
+  // Generate the names of the parameters described by the settings.
+  int num_params = get_setting(load_result.settings, "num_params");
+  int num_arrays = get_setting(load_result.settings, "num_arrays");
+  char params[MAX_PARAMS][NAME_LEN], arrays[MAX_PARAMS][NAME_LEN];
+  for (int p = 0; p < num_params; ++p) {
+    snprintf(params[p], NAME_LEN, "p%d", p);
+  }
+  for (int p = 0; p < num_arrays; ++p) {
+    snprintf(arrays[p], NAME_LEN, "a%d", p);
+  }
+
+  // Iterate over all members, fetching every input parameter and setting a
+  // scalar and an array output quantity.
+  t0 = bench_time();
+  sw_input_t *input;
+  sw_output_t *output;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_real_t sum = sw_input_get(input, "f0").value;
+    for (int p = 0; p < num_params; ++p) {
+      sum += sw_input_get(input, params[p]).value;
+    }
+    sw_real_t firsts[MAX_PARAMS + 1] = {sum};
+    for (int p = 0; p < num_arrays; ++p) {
+      sw_input_array_result_t result = sw_input_get_array(input, arrays[p]);
+      for (size_t i = 0; i < result.size; ++i) {
+        sum += result.values[i];
+      }
+      firsts[p + 1] = result.values[0];
+    }
+    sw_output_set(output, "sum", sum);
+    sw_output_set_array(output, "firsts", firsts, num_arrays + 1);
+  }
+  times[BENCH_TRAVERSE] = bench_time() - t0;
+
+  // Write out a Python module.
+  t0 = bench_time();
+  sw_write_result_t w_result = sw_ensemble_write(ensemble, output_file);
+  times[BENCH_WRITE] = bench_time() - t0;
+  if (w_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "bench_c: %s\n", w_result.error_message);
+    exit(-1);
+  }
+  size_t peak_memory = bench_peak_memory();
+
+  // Clean up.
+  t0 = bench_time();
+  sw_ensemble_free(ensemble);
+  times[BENCH_FREE] = bench_time() - t0;
+
+  bench_report("c", input_name, num_members, times,
+               bench_file_size(output_file), peak_memory);
+  return 0;
+}
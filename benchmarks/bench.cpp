@@ -0,0 +1,141 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This benchmark driver times the stages of an ensemble's life cycle using
+// Skywalker's C++ interface: loading, traversal (with input gets and output
+// sets), writing, and freeing. It reports its results as a line of JSON.
+
+#include <skywalker.hpp>
+
+#include "bench_util.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace skywalker;
+
+void usage() {
+  std::cerr << "bench_cpp: times ensemble operations with Skywalker's C++ "
+               "interface." << std::endl;
+  std::cerr << "bench_cpp: usage:" << std::endl;
+  std::cerr << "bench_cpp <input.yaml>" << std::endl;
+  exit(-1);
+}
+
+// Returns the name of the input: the base name of the input file without its
+// suffix.
+std::string input_name(const std::string& input_file) {
+  size_t slash = input_file.rfind('/');
+  std::string base = (slash == std::string::npos) ?
+                     input_file : input_file.substr(slash + 1);
+  return base.substr(0, base.find('.'));
+}
+
+// Returns the names of the parameters with the given prefix and count.
+std::vector<std::string> param_names(const std::string& prefix, int count) {
+  std::vector<std::string> names;
+  for (int p = 0; p < count; ++p) {
+    names.push_back(prefix + std::to_string(p));
+  }
+  return names;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    usage();
+  }
+  std::string input_file(argv[1]);
+  std::string name = input_name(input_file);
+  std::string output_file = "bench_" + name + "_cpp.py";
+
+  double times[BENCH_NUM_STAGES];
+
+  try {
+    // Load the ensemble.
+    double t0 = bench_time();
+    Ensemble *ensemble = load_ensemble(input_file, "settings");
+    times[BENCH_LOAD] = bench_time() - t0;
+    size_t num_members = ensemble->size();
+
+    // Generate the names of the parameters described by the settings.
+    const Settings& settings = ensemble->settings();
+    auto params = param_names("p", std::stoi(settings.get("num_params")));
+    auto arrays = param_names("a", std::stoi(settings.get("num_arrays")));
+
+    // Iterate over all members, fetching every input parameter and setting a
+    // scalar and an array output quantity.
+    t0 = bench_time();
+    std::vector<Real> firsts(arrays.size() + 1);
+    ensemble->process([&](const Input& input, Output& output) {
+      Real sum = input.get("f0");
+      for (const auto& param: params) {
+        sum += input.get(param);
+      }
+      firsts[0] = sum;
+      for (size_t p = 0; p < arrays.size(); ++p) {
+        ArrayView values = input.get_array_view(arrays[p]);
+        for (size_t i = 0; i < values.size(); ++i) {
+          sum += values[i];
+        }
+        firsts[p + 1] = values[0];
+      }
+      output.set("sum", sum);
+      output.set("firsts", firsts);
+    });
+    times[BENCH_TRAVERSE] = bench_time() - t0;
+
+    // Write out a Python module.
+    t0 = bench_time();
+    ensemble->write(output_file);
+    times[BENCH_WRITE] = bench_time() - t0;
+    size_t peak_memory = bench_peak_memory();
+
+    // Clean up.
+    t0 = bench_time();
+    delete ensemble;
+    times[BENCH_FREE] = bench_time() - t0;
+
+    bench_report("cpp", name.c_str(), num_members, times,
+                 bench_file_size(output_file.c_str()), peak_memory);
+  } catch (Exception& e) {
+    std::cerr << "bench_cpp: " << e.what() << std::endl;
+    exit(-1);
+  }
+  return 0;
+}
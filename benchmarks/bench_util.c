@@ -0,0 +1,104 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+#include "bench_util.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#endif
+
+double bench_time(void) {
+#ifdef _WIN32
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (double)count.QuadPart / (double)frequency.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec + 1e-9 * (double)t.tv_nsec;
+#endif
+}
+
+size_t bench_peak_memory(void) {
+#ifdef _WIN32
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage)) return 0;
+#ifdef __APPLE__
+  return (size_t)usage.ru_maxrss; // bytes
+#else
+  return (size_t)usage.ru_maxrss * 1024; // kilobytes
+#endif
+#endif
+}
+
+size_t bench_file_size(const char *filename) {
+  FILE *file = fopen(filename, "rb");
+  if (!file) return 0;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  return (size > 0) ? (size_t)size : 0;
+}
+
+void bench_report(const char *binding, const char *input, size_t num_members,
+                  const double *stage_times, size_t module_size,
+                  size_t peak_memory) {
+  static const char *stage_names[BENCH_NUM_STAGES] = {
+    "load", "traverse", "write", "free"
+  };
+  printf("{\"binding\": \"%s\", \"input\": \"%s\", \"members\": %zu",
+         binding, input, num_members);
+  for (int s = 0; s < BENCH_NUM_STAGES; ++s) {
+    double rate = (stage_times[s] > 0.0) ?
+                  (double)num_members / stage_times[s] : 0.0;
+    printf(", \"%s_seconds\": %.6f, \"%s_members_per_s\": %.1f",
+           stage_names[s], stage_times[s], stage_names[s], rate);
+  }
+  printf(", \"module_bytes_per_member\": %.1f, "
+         "\"peak_memory_bytes_per_member\": %.1f}\n",
+         (double)module_size / (double)num_members,
+         (double)peak_memory / (double)num_members);
+  fflush(stdout);
+}
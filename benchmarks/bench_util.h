@@ -0,0 +1,80 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+#ifndef SKYWALKER_BENCH_UTIL_H
+#define SKYWALKER_BENCH_UTIL_H
+
+// These functions time the stages of a benchmark and report the results in
+// the same form for drivers written in C, C++, and Fortran.
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Stages of a benchmark, timed separately
+typedef enum bench_stage_t {
+  BENCH_LOAD = 0, // sw_load_ensemble
+  BENCH_TRAVERSE, // sw_ensemble_next, with input gets and output sets
+  BENCH_WRITE,    // sw_ensemble_write
+  BENCH_FREE,     // sw_ensemble_free
+  BENCH_NUM_STAGES
+} bench_stage_t;
+
+// Returns a monotonically increasing time in seconds.
+double bench_time(void);
+
+// Returns the peak memory (resident set size) used by the process so far, in
+// bytes, or 0 if it can't be determined.
+size_t bench_peak_memory(void);
+
+// Returns the size of the file with the given name in bytes, or 0 if it
+// doesn't exist.
+size_t bench_file_size(const char *filename);
+
+// Writes a line of JSON to stdout reporting the results of a benchmark for
+// the given language binding and input: the number of members in the
+// ensemble, the time spent in each stage (indexed by bench_stage_t), the
+// size of the ensemble's output module, and the peak memory used.
+void bench_report(const char *binding, const char *input, size_t num_members,
+                  const double *stage_times, size_t module_size,
+                  size_t peak_memory);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
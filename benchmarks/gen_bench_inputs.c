@@ -0,0 +1,143 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program generates the synthetic input files used by Skywalker's
+// benchmarks:
+//   lattice.yaml    - a large lattice ensemble (5 parameters x 10 values)
+//   enumerated.yaml - a wide enumerated ensemble (10 parameters x 100000
+//                     values)
+//   arrays.yaml     - an enumerated ensemble with long array parameters
+//                     (4 parameters x 10000 values of length 64)
+// Each file's settings tell the benchmark drivers how many scalar and array
+// parameters its members have. The parameters are named p0, p1, ... and
+// a0, a1, ..., respectively.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static void usage(void) {
+  fprintf(stderr, "gen_bench_inputs: generates input files for Skywalker's "
+                  "benchmarks.\n");
+  fprintf(stderr, "gen_bench_inputs: usage:\n");
+  fprintf(stderr, "gen_bench_inputs [directory]\n");
+  exit(-1);
+}
+
+// Opens the file with the given name in the given directory for writing,
+// exiting on failure.
+static FILE *open_input(const char *dir, const char *name) {
+  char path[FILENAME_MAX];
+  snprintf(path, FILENAME_MAX, "%s/%s", dir, name);
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    fprintf(stderr, "gen_bench_inputs: couldn't open %s for writing.\n", path);
+    exit(-1);
+  }
+  return file;
+}
+
+// Writes the header and settings block shared by all benchmark inputs.
+static void write_settings(FILE *file, const char *description,
+                           int num_params, int num_arrays) {
+  fprintf(file, "# This file was generated by gen_bench_inputs. It contains "
+                "%s.\n\n", description);
+  fprintf(file, "settings:\n");
+  fprintf(file, "  num_params: %d\n", num_params);
+  fprintf(file, "  num_arrays: %d\n\n", num_arrays);
+  fprintf(file, "input:\n");
+  fprintf(file, "  fixed:\n");
+  fprintf(file, "    f0: 1\n");
+}
+
+static void write_lattice(const char *dir) {
+  static const int num_params = 5, num_values = 10;
+  FILE *file = open_input(dir, "lattice.yaml");
+  write_settings(file, "a large lattice ensemble", num_params, 0);
+  fprintf(file, "  lattice:\n");
+  for (int p = 0; p < num_params; ++p) {
+    fprintf(file, "    p%d: [%d, %d, 1]\n", p, p, p + num_values - 1);
+  }
+  fclose(file);
+}
+
+static void write_enumerated(const char *dir) {
+  static const int num_params = 10, num_values = 100000;
+  FILE *file = open_input(dir, "enumerated.yaml");
+  write_settings(file, "a wide enumerated ensemble", num_params, 0);
+  fprintf(file, "  enumerated:\n");
+  for (int p = 0; p < num_params; ++p) {
+    fprintf(file, "    p%d: [", p);
+    for (int i = 0; i < num_values; ++i) {
+      fprintf(file, (i == 0) ? "%g" : ", %g", p + 1e-5 * i);
+    }
+    fprintf(file, "]\n");
+  }
+  fclose(file);
+}
+
+static void write_arrays(const char *dir) {
+  static const int num_arrays = 4, num_values = 10000, array_length = 64;
+  FILE *file = open_input(dir, "arrays.yaml");
+  write_settings(file, "long array parameters", 1, num_arrays);
+  fprintf(file, "  enumerated:\n");
+  fprintf(file, "    p0: [");
+  for (int i = 0; i < num_values; ++i) {
+    fprintf(file, (i == 0) ? "%d" : ", %d", i);
+  }
+  fprintf(file, "]\n");
+  for (int p = 0; p < num_arrays; ++p) {
+    fprintf(file, "    a%d: [", p);
+    for (int i = 0; i < num_values; ++i) {
+      fprintf(file, (i == 0) ? "[" : ", [");
+      for (int j = 0; j < array_length; ++j) {
+        fprintf(file, (j == 0) ? "%d" : ", %d", p + i + j);
+      }
+      fprintf(file, "]");
+    }
+    fprintf(file, "]\n");
+  }
+  fclose(file);
+}
+
+int main(int argc, char **argv) {
+  if (argc > 2) {
+    usage();
+  }
+  const char *dir = (argc == 2) ? argv[1] : ".";
+  write_lattice(dir);
+  write_enumerated(dir);
+  write_arrays(dir);
+  return 0;
+}
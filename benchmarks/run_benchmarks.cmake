@@ -0,0 +1,25 @@
+# This script runs each of the given benchmark drivers on each of the given
+# inputs in the current directory, writing the lines of JSON they report to
+# the given results file and to the terminal. It's run by the bench target:
+#
+# cmake -DDRIVERS=/path/to/bench_c,... -DINPUTS=lattice,... -DRESULTS=file \
+#       -P run_benchmarks.cmake
+
+string(REPLACE "," ";" DRIVERS "${DRIVERS}")
+string(REPLACE "," ";" INPUTS "${INPUTS}")
+file(WRITE ${RESULTS} "")
+foreach (input ${INPUTS})
+  foreach (driver ${DRIVERS})
+    execute_process(COMMAND ${driver} ${input}.yaml
+                    OUTPUT_VARIABLE result
+                    ERROR_VARIABLE error
+                    RESULT_VARIABLE status)
+    if (NOT status EQUAL 0)
+      message(FATAL_ERROR "${driver} failed for ${input}.yaml:\n${error}")
+    endif()
+    file(APPEND ${RESULTS} "${result}")
+    string(STRIP "${result}" result)
+    message("${result}")
+  endforeach()
+endforeach()
+message("Benchmark results written to ${RESULTS}.")
@@ -38,9 +38,12 @@
 
 #include <skywalker.h>
 
+#include <algorithm>
 #include <exception>
 #include <functional>
+#include <limits>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace skywalker {
@@ -67,6 +70,50 @@ inline void print_banner() {
 // Precision of real numbers
 using Real = sw_real_t;
 
+// Integer handle identifying a named input parameter or output quantity
+using Handle = sw_handle_t;
+
+// Timing and memory statistics for an ensemble (see sw_ensemble_stats_t)
+using Stats = sw_ensemble_stats_t;
+
+// Options controlling which of an ensemble's data are written, and how (see
+// sw_write_options_t)
+using WriteOptions = sw_write_options_t;
+
+// A read-only view of an array of real numbers stored by Skywalker, such as
+// the values of an input array parameter. A view doesn't copy the values, and
+// is valid for the lifetime of the ensemble that stores them.
+class ArrayView final {
+ public:
+  ArrayView(): data_(nullptr), size_(0) {}
+  ArrayView(const Real *data, size_t size): data_(data), size_(size) {}
+
+  // Returns a pointer to the first value.
+  const Real* data() const { return data_; }
+
+  // Returns the number of values.
+  size_t size() const { return size_; }
+
+  // Returns true if the view has no values, false otherwise.
+  bool empty() const { return (size_ == 0); }
+
+  // Returns the value at the given index (not checked).
+  const Real& operator[](size_t i) const { return data_[i]; }
+
+  // Iterators for range-based for loops and algorithms.
+  const Real* begin() const { return data_; }
+  const Real* end() const { return data_ + size_; }
+
+  // Returns a copy of the values.
+  std::vector<Real> to_vector() const {
+    return std::vector<Real>(data_, data_ + size_);
+  }
+
+ private:
+  const Real *data_;
+  size_t size_;
+};
+
 // A table of string-valued settings, read from a settings block in a YAML
 // file.
 class Settings final {
@@ -141,18 +188,54 @@ class Input final {
     }
   }
 
+  // Retrieves a (real-valued) parameter with the given handle (obtained from
+  // Ensemble::input_handle), throwing an exception if it's invalid.
+  Real get(Handle handle) const {
+    auto result = sw_input_get_h(input_, handle);
+    if (result.error_code == SW_SUCCESS) {
+      return result.value;
+    } else {
+      throw Exception(result.error_message);
+    }
+  }
+
   // Returns true if an input array parameter with the given name exists within
   // the given input instance, false otherwise.
   bool has_array(const std::string& name) const {
     return sw_input_has_array(input_, name.c_str());
   }
 
-  // Retrieves a (real-valued) array parameter with the given name, throwing an
-  // exception if it doesn't exist.
+  // Retrieves a copy of the (real-valued) array parameter with the given name,
+  // throwing an exception if it doesn't exist.
   std::vector<Real> get_array(const std::string& name) const {
+    return get_array_view(name).to_vector();
+  }
+
+  // Retrieves a copy of the (real-valued) array parameter with the given handle
+  // (obtained from Ensemble::input_array_handle), throwing an exception if it's
+  // invalid.
+  std::vector<Real> get_array(Handle handle) const {
+    return get_array_view(handle).to_vector();
+  }
+
+  // Retrieves a view of the (real-valued) array parameter with the given name
+  // without copying its values, throwing an exception if it doesn't exist.
+  ArrayView get_array_view(const std::string& name) const {
     auto result = sw_input_get_array(input_, name.c_str());
     if (result.error_code == SW_SUCCESS) {
-      return std::vector<Real>(result.values, result.values + result.size);
+      return ArrayView(result.values, result.size);
+    } else {
+      throw Exception(result.error_message);
+    }
+  }
+
+  // Retrieves a view of the (real-valued) array parameter with the given handle
+  // (obtained from Ensemble::input_array_handle) without copying its values,
+  // throwing an exception if it's invalid.
+  ArrayView get_array_view(Handle handle) const {
+    auto result = sw_input_get_array_h(input_, handle);
+    if (result.error_code == SW_SUCCESS) {
+      return ArrayView(result.values, result.size);
     } else {
       throw Exception(result.error_message);
     }
@@ -162,6 +245,7 @@ class Input final {
   explicit Input(sw_input_t *i): input_(i) {}
   sw_input_t *input_;
   friend class Ensemble;
+  friend class Batch;
 };
 
 // A set of named, real-valued output parameters corresponding to a single
@@ -191,10 +275,176 @@ class Output final {
     sw_output_set_array(output_, name.c_str(), values.data(), values.size());
   }
 
+  // Sets a (real-valued) parameter with the given handle (obtained from
+  // Ensemble::output_handle).
+  void set(Handle handle, Real value) const {
+    sw_output_set_h(output_, handle, value);
+  }
+
+  // Sets (real-valued) parameters in an array with the given handle (obtained
+  // from Ensemble::output_array_handle).
+  void set(Handle handle, const std::vector<Real> &values) const {
+    sw_output_set_array_h(output_, handle, values.data(), values.size());
+  }
+
+  // Reserves storage for an array of the given number of (real-valued)
+  // parameters with the given name, returning a pointer to it so the values
+  // can be computed in place instead of copied from a vector. Every value must
+  // be written. The pointer is valid until the array is set or reserved again.
+  Real* reserve_array(const std::string& name, size_t size) const {
+    return sw_output_reserve_array(output_, name.c_str(), size);
+  }
+
+  // Reserves storage for the array of (real-valued) parameters with the given
+  // handle (obtained from Ensemble::output_array_handle), as the name-based
+  // version does. Returns nullptr if the handle is invalid.
+  Real* reserve_array(Handle handle, size_t size) const {
+    return sw_output_reserve_array_h(output_, handle, size);
+  }
+
  private:
   explicit Output(sw_output_t *o): output_(o) {}
   sw_output_t *output_;
   friend class Ensemble;
+  friend class Batch;
+};
+
+// A batch of consecutive ensemble members, whose (real-valued) input
+// parameters and output quantities are accessed as contiguous arrays with one
+// element per member. A batch is valid only within the function that
+// processes it (see Ensemble::process_batch).
+class Batch final {
+ public:
+  Batch() = default;
+  Batch(const Batch& rhs): batch_(rhs.batch_) {}
+  Batch& operator=(const Batch& rhs) {
+    if (&rhs != this) {
+      batch_ = rhs.batch_;
+    }
+    return *this;
+  }
+
+  ~Batch() = default;
+
+  // Returns the number of members in the batch.
+  size_t size() const { return sw_batch_size(batch_); }
+
+  // Returns the index of the batch's first member within the ensemble.
+  size_t begin() const { return sw_batch_begin(batch_); }
+
+  // Retrieves a view of the values of the (real-valued) input parameter with
+  // the given name for the batch's members, throwing an exception if it
+  // doesn't exist.
+  ArrayView get_input(const std::string& name) const {
+    auto result = sw_batch_input_get(batch_, name.c_str());
+    if (result.error_code == SW_SUCCESS) {
+      return ArrayView(result.values, result.size);
+    } else {
+      throw Exception(result.error_message);
+    }
+  }
+
+  // Retrieves a view of the values of the (real-valued) input parameter with
+  // the given handle (obtained from Ensemble::input_handle) for the batch's
+  // members, throwing an exception if it's invalid.
+  ArrayView get_input(Handle handle) const {
+    auto result = sw_batch_input_get_h(batch_, handle);
+    if (result.error_code == SW_SUCCESS) {
+      return ArrayView(result.values, result.size);
+    } else {
+      throw Exception(result.error_message);
+    }
+  }
+
+  // Returns a pointer to the array (of length size()) in which the
+  // (real-valued) output quantity with the given name is stored for the
+  // batch's members, so the values can be computed in place.
+  Real* reserve_output(const std::string& name) const {
+    return sw_batch_output_reserve(batch_, name.c_str());
+  }
+
+  // Returns a pointer to the array in which the (real-valued) output quantity
+  // with the given handle (obtained from Ensemble::output_handle) is stored
+  // for the batch's members, or nullptr if the handle is invalid.
+  Real* reserve_output(Handle handle) const {
+    return sw_batch_output_reserve_h(batch_, handle);
+  }
+
+  // Retrieves the input and output of the member with the given index within
+  // the batch (for access to array-valued parameters and quantities),
+  // returning false if the index is invalid.
+  bool get(size_t i, Input& input, Output& output) const {
+    return sw_batch_get(batch_, i, &(input.input_), &(output.output_));
+  }
+
+ private:
+  explicit Batch(sw_batch_t *b): batch_(b) {}
+  sw_batch_t *batch_;
+  friend class Ensemble;
+};
+
+// A schema that maps the fields of a struct T to an ensemble's input
+// parameters, so a driver can declare the inputs it uses once and read them
+// as struct members. Scalar parameters are stored in Real fields and array
+// parameters in ArrayView fields:
+//
+//   struct GasInput { Real temperature, pressure; };
+//   auto schema = InputSchema<GasInput>().add("T", &GasInput::temperature)
+//                                        .add("p", &GasInput::pressure);
+template <typename T>
+class InputSchema final {
+ public:
+  // Adds the scalar input parameter with the given name, stored in the given
+  // field.
+  InputSchema& add(const std::string& name, Real T::*field) {
+    names_.push_back(name);
+    fields_.push_back(field);
+    return *this;
+  }
+
+  // Adds the input array parameter with the given name, stored in the given
+  // field.
+  InputSchema& add(const std::string& name, ArrayView T::*field) {
+    array_names_.push_back(name);
+    array_fields_.push_back(field);
+    return *this;
+  }
+
+ private:
+  std::vector<std::string> names_, array_names_;
+  std::vector<Real T::*> fields_;
+  std::vector<ArrayView T::*> array_fields_;
+  friend class Ensemble;
+};
+
+// A schema that maps the fields of a struct T to an ensemble's output
+// quantities. Scalar quantities are stored from Real fields, and array
+// quantities from std::vector<Real> fields. A scalar field left NaN (or an
+// array left empty) doesn't set its quantity.
+template <typename T>
+class OutputSchema final {
+ public:
+  // Adds the scalar output quantity with the given name, stored from the
+  // given field.
+  OutputSchema& add(const std::string& name, Real T::*field) {
+    names_.push_back(name);
+    fields_.push_back(field);
+    return *this;
+  }
+
+  // Adds the output array quantity with the given name, stored from the given
+  // field.
+  OutputSchema& add(const std::string& name, std::vector<Real> T::*field) {
+    array_names_.push_back(name);
+    array_fields_.push_back(field);
+    return *this;
+  }
+
+ private:
+  std::vector<std::string> names_, array_names_;
+  std::vector<Real T::*> fields_;
+  std::vector<std::vector<Real> T::*> array_fields_;
+  friend class Ensemble;
 };
 
 // An ensemble that has been loaded from a skywalker input file.
@@ -213,8 +463,9 @@ class Ensemble final {
   const Settings& settings() const { return settings_; }
 
   // Iterates over all ensemble members, applying the given function f to
-  // each input/output pair.
-  void process(std::function<void(const Input&, Output&)> f) {
+  // each input/output pair. f is called as f(const Input&, Output&).
+  template <typename F>
+  void process(F f) {
     Input i;
     Output o;
     while (sw_ensemble_next(ensemble_, &(i.input_), &(o.output_))) {
@@ -222,9 +473,208 @@ class Ensemble final {
     }
   }
 
+  // Iterates over all ensemble members, applying the given function f to the
+  // fields of each member's inputs and outputs, described by the given
+  // schemas. f is called as f(const In&, Out&). Names in the schemas are
+  // resolved before processing begins, and members are fetched in batches, so
+  // reading an input or writing an output is a load or store, and f can be
+  // inlined. Throws an exception if an input parameter in the input schema
+  // doesn't exist.
+  template <typename In, typename Out, typename F>
+  void process(const InputSchema<In>& input_schema,
+               const OutputSchema<Out>& output_schema, F f) {
+    std::vector<Handle> inputs, input_arrays, outputs, output_arrays;
+    for (const auto& name: input_schema.names_) {
+      inputs.push_back(input_handle(name));
+    }
+    for (const auto& name: input_schema.array_names_) {
+      input_arrays.push_back(input_array_handle(name));
+    }
+    for (const auto& name: output_schema.names_) {
+      outputs.push_back(output_handle(name));
+    }
+    for (const auto& name: output_schema.array_names_) {
+      output_arrays.push_back(output_array_handle(name));
+    }
+    bool has_arrays = !(input_arrays.empty() && output_arrays.empty());
+
+    const size_t batch_size = 256;
+    std::vector<const Real*> input_values(inputs.size());
+    std::vector<Real*> output_values(outputs.size());
+    In in = In();
+    Out out = Out();
+    Batch batch;
+    Input i;
+    Output o;
+    while (sw_ensemble_next_batch(ensemble_, batch_size, &(batch.batch_))) {
+      for (size_t k = 0; k < inputs.size(); ++k) {
+        input_values[k] = batch.get_input(inputs[k]).data();
+      }
+      for (size_t k = 0; k < outputs.size(); ++k) {
+        output_values[k] = batch.reserve_output(outputs[k]);
+      }
+      size_t n = batch.size();
+      for (size_t m = 0; m < n; ++m) {
+        for (size_t k = 0; k < inputs.size(); ++k) {
+          in.*(input_schema.fields_[k]) = input_values[k][m];
+        }
+        for (size_t k = 0; k < outputs.size(); ++k) {
+          out.*(output_schema.fields_[k]) =
+            std::numeric_limits<Real>::quiet_NaN();
+        }
+        for (size_t k = 0; k < output_arrays.size(); ++k) {
+          (out.*(output_schema.array_fields_[k])).clear();
+        }
+        if (has_arrays) {
+          batch.get(m, i, o);
+          for (size_t k = 0; k < input_arrays.size(); ++k) {
+            in.*(input_schema.array_fields_[k]) =
+              i.get_array_view(input_arrays[k]);
+          }
+        }
+
+        f(static_cast<const In&>(in), out);
+
+        for (size_t k = 0; k < outputs.size(); ++k) {
+          output_values[k][m] = out.*(output_schema.fields_[k]);
+        }
+        for (size_t k = 0; k < output_arrays.size(); ++k) {
+          const auto& values = out.*(output_schema.array_fields_[k]);
+          if (!values.empty()) o.set(output_arrays[k], values);
+        }
+      }
+    }
+  }
+
+  // Iterates over the ensemble's members in batches of (at most) the given
+  // size, applying the given function f to each batch. f can process all of a
+  // batch's members at once, for example within a single vectorized loop or
+  // kernel launch. f is called as f(const Batch&).
+  template <typename F>
+  void process_batch(size_t batch_size, F f) {
+    Batch b;
+    while (sw_ensemble_next_batch(ensemble_, batch_size, &(b.batch_))) {
+      f(b);
+    }
+  }
+
+  // Applies the given function f to each input/output pair, dividing the
+  // ensemble's members into contiguous ranges that are processed concurrently
+  // by the given number of threads (by default, one per hardware thread). f
+  // must be safe to call from several threads at once. If f throws an
+  // exception, it is rethrown once all threads have finished.
+  template <typename F>
+  void process_parallel(F f, unsigned int num_threads = 0) {
+    size_t n = size();
+    if (num_threads == 0) {
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (num_threads > n) num_threads = static_cast<unsigned int>(n);
+    if (num_threads == 0) return;
+    size_t chunk_size = (n + num_threads - 1) / num_threads;
+    std::vector<std::exception_ptr> errors(num_threads);
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&, t]() {
+        try {
+          auto range = sw_ensemble_range(ensemble_, t * chunk_size,
+                                         (t + 1) * chunk_size);
+          Input i;
+          Output o;
+          while (sw_ensemble_range_next(&range, &(i.input_), &(o.output_))) {
+            f(i, o);
+          }
+        } catch (...) {
+          errors[t] = std::current_exception();
+        }
+      });
+    }
+    for (auto& thread: threads) {
+      thread.join();
+    }
+    for (auto& error: errors) {
+      if (error) std::rethrow_exception(error);
+    }
+  }
+
   // Returns the size of the ensemble (number of members).
   size_t size() const { return sw_ensemble_size(ensemble_); }
 
+  // Returns the index of the ensemble's first member within the full ensemble
+  // (nonzero only for an ensemble distributed across MPI processes).
+  size_t offset() const { return sw_ensemble_offset(ensemble_); }
+
+  // Retrieves a handle for the (real-valued) input parameter with the given
+  // name, throwing an exception if it doesn't exist.
+  Handle input_handle(const std::string& name) const {
+    auto result = sw_input_handle(ensemble_, name.c_str());
+    if (result.error_code == SW_SUCCESS) {
+      return result.handle;
+    } else {
+      throw Exception(result.error_message);
+    }
+  }
+
+  // Retrieves a handle for the (real-valued) input array parameter with the
+  // given name, throwing an exception if it doesn't exist.
+  Handle input_array_handle(const std::string& name) const {
+    auto result = sw_input_array_handle(ensemble_, name.c_str());
+    if (result.error_code == SW_SUCCESS) {
+      return result.handle;
+    } else {
+      throw Exception(result.error_message);
+    }
+  }
+
+  // Returns a handle for the (real-valued) output quantity with the given name.
+  Handle output_handle(const std::string& name) {
+    return sw_output_handle(ensemble_, name.c_str());
+  }
+
+  // Returns a handle for the (real-valued) output array with the given name.
+  Handle output_array_handle(const std::string& name) {
+    return sw_output_array_handle(ensemble_, name.c_str());
+  }
+
+  // Copies the values of the (real-valued) input parameters with the given
+  // names for all members into the given buffer, which must hold
+  // names.size() * size() values. Each parameter's values are stored
+  // contiguously, one per member, so the buffer can be copied to an
+  // accelerator's memory in a single transfer (see sw_ensemble_export_inputs).
+  // Throws an exception if any parameter doesn't exist.
+  void export_inputs(const std::vector<std::string>& names,
+                     Real* values) const {
+    auto c_names = c_strings(names);
+    auto result = sw_ensemble_export_inputs(ensemble_, c_names.size(),
+                                            c_names.data(), values);
+    if (result.error_code != SW_SUCCESS) {
+      throw Exception(result.error_message);
+    }
+  }
+
+  // Returns a buffer containing the values of the (real-valued) input
+  // parameters with the given names for all members, as the pointer-based
+  // version fills it.
+  std::vector<Real> export_inputs(const std::vector<std::string>& names) const {
+    std::vector<Real> values(names.size() * size());
+    export_inputs(names, values.data());
+    return values;
+  }
+
+  // Sets the (real-valued) quantities with the given names for all members to
+  // the values in the given buffer, laid out as export_inputs lays out its
+  // buffer (see sw_ensemble_import_outputs). Throws an exception if the
+  // ensemble's outputs are being streamed.
+  void import_outputs(const std::vector<std::string>& names,
+                      const Real* values) {
+    auto c_names = c_strings(names);
+    auto result = sw_ensemble_import_outputs(ensemble_, c_names.size(),
+                                             c_names.data(), values);
+    if (result.error_code != SW_SUCCESS) {
+      throw Exception(result.error_message);
+    }
+  }
+
   // Writes input and output data within the ensemble to a Python module stored
   // in the file with the given name.
   void write(const std::string& module_filename) const {
@@ -234,15 +684,102 @@ class Ensemble final {
     }
   }
 
+  // Streams the ensemble's data to a Python module in the file with the given
+  // name, writing the outputs of each chunk of members as it's processed (see
+  // sw_ensemble_stream). Call this before processing the ensemble.
+  void stream(const std::string& module_filename, size_t chunk_size) {
+    auto result = sw_ensemble_stream(ensemble_, module_filename.c_str(),
+                                     chunk_size);
+    if (result.error_code != SW_SUCCESS) {
+      throw Exception(result.error_message);
+    }
+  }
+
+  // Restarts the stream of the ensemble's data to the Python module in the file
+  // with the given name, keeping the outputs of members completed by an
+  // earlier run and skipping them during processing (see sw_ensemble_restart).
+  // Call this before processing the ensemble.
+  void restart(const std::string& module_filename, size_t chunk_size) {
+    auto result = sw_ensemble_restart(ensemble_, module_filename.c_str(),
+                                      chunk_size);
+    if (result.error_code != SW_SUCCESS) {
+      throw Exception(result.error_message);
+    }
+  }
+
+  // Memoizes the ensemble's members in the memo file with the given name, so
+  // that process skips members whose outputs it holds and fills those outputs
+  // from it (see sw_ensemble_memoize). Only process without an input schema
+  // uses the memo. Call this before processing the ensemble.
+  void memoize(const std::string& memo_filename) {
+    auto result = sw_ensemble_memoize(ensemble_, memo_filename.c_str());
+    if (result.error_code != SW_SUCCESS) {
+      throw Exception(result.error_message);
+    }
+  }
+
+  // Writes input and output data within the ensemble to the file with the
+  // given name in the given format.
+  void write(const std::string& filename, sw_write_format_t format) const {
+    auto result = sw_ensemble_write_format(ensemble_, filename.c_str(), format);
+    if (result.error_code != SW_SUCCESS) {
+      throw Exception(result.error_message);
+    }
+  }
+
+  // Writes data within the ensemble to the file with the given name with the
+  // given options (see sw_ensemble_write_options).
+  void write(const std::string& filename, const WriteOptions& options) const {
+    auto result = sw_ensemble_write_options(ensemble_, filename.c_str(),
+                                            &options);
+    if (result.error_code != SW_SUCCESS) {
+      throw Exception(result.error_message);
+    }
+  }
+
+  // Starts timing the processing of the ensemble's members, and writing the
+  // ensemble's statistics to its modules (see sw_ensemble_collect_stats).
+  // Only process and process_batch are timed.
+  void collect_stats() {
+    sw_ensemble_collect_stats(ensemble_);
+  }
+
+  // Starts recording the time spent processing each member by process in the
+  // member's output quantity skywalker_time (see sw_ensemble_profile).
+  void profile() {
+    sw_ensemble_profile(ensemble_);
+  }
+
+  // Returns statistics describing the time spent loading, processing, and
+  // writing the ensemble so far, and the memory it uses.
+  Stats stats() const {
+    return sw_ensemble_stats(ensemble_);
+  }
+
  private:
   Ensemble(sw_ensemble_t *e, sw_settings_t* s):
     ensemble_(e), settings_(Settings(s)) {}
 
+  // Returns pointers to the given strings' characters.
+  static std::vector<const char*> c_strings(
+    const std::vector<std::string>& strings) {
+    std::vector<const char*> c_strings;
+    for (const auto& s: strings) {
+      c_strings.push_back(s.c_str());
+    }
+    return c_strings;
+  }
+
   sw_ensemble_t *ensemble_;
   Settings settings_;
 
   friend Ensemble* load_ensemble(const std::string& yaml_file,
                                  const std::string& settings_block);
+#ifdef SKYWALKER_HAVE_MPI
+  friend Ensemble* load_ensemble_mpi(const std::string& yaml_file,
+                                     const std::string& settings_block,
+                                     MPI_Comm comm);
+#endif
 };
 
 // Loads an ensemble from the given YAML file, using the block with the given
@@ -257,6 +794,53 @@ inline Ensemble* load_ensemble(const std::string& yaml_file,
   }
 }
 
+#ifdef SKYWALKER_HAVE_MPI
+// Loads an ensemble from the given YAML file on every process in the given MPI
+// communicator, giving each process a contiguous block of the ensemble's
+// members. Writing the ensemble gathers all members' outputs into a single
+// module. This function must be called by all processes in the communicator.
+inline Ensemble* load_ensemble_mpi(const std::string& yaml_file,
+                                   const std::string& settings_block,
+                                   MPI_Comm comm) {
+  auto result = sw_load_ensemble_mpi(yaml_file.c_str(),
+                                     settings_block.c_str(), comm);
+  if (result.error_code == SW_SUCCESS) {
+    return new Ensemble(result.ensemble, result.settings);
+  } else {
+    throw Exception(result.error_message);
+  }
+}
+#endif
+
+// Merges the NumPy archives in the files with the given names, written for
+// ensembles with the same settings, inputs, and outputs, into a single archive
+// in the file with the given name (see sw_archive_merge).
+inline void merge_archives(const std::vector<std::string>& archive_filenames,
+                           const std::string& merged_filename) {
+  std::vector<const char*> filenames;
+  for (const auto& filename: archive_filenames) {
+    filenames.push_back(filename.c_str());
+  }
+  auto result = sw_archive_merge(filenames.size(), filenames.data(),
+                                 merged_filename.c_str());
+  if (result.error_code != SW_SUCCESS) {
+    throw Exception(result.error_message);
+  }
+}
+
+// Writes the data for members [begin, end) of the NumPy archive in the file
+// with the given name to a new archive in the file with the given name (see
+// sw_archive_slice).
+inline void slice_archive(const std::string& archive_filename,
+                          size_t begin, size_t end,
+                          const std::string& sliced_filename) {
+  auto result = sw_archive_slice(archive_filename.c_str(), begin, end,
+                                 sliced_filename.c_str());
+  if (result.error_code != SW_SUCCESS) {
+    throw Exception(result.error_message);
+  }
+}
+
 } // namespace skywalker
 
 #endif
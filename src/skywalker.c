@@ -36,17 +36,34 @@
 #include <skywalker.h>
 
 #include <khash.h>
-#include <klist.h>
 #include <kvec.h>
 #include <yaml.h>
+#ifdef SKYWALKER_HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 #include <assert.h>
 #include <ctype.h>
+#include <limits.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -58,9 +75,8 @@ void sw_print_banner() {
 
 // Some basic data structures.
 
-// A list of C strings.
-#define free_string(x) free((char*)x->data)
-KLIST_INIT(string_list, const char*, free_string)
+// A set of C strings.
+KHASH_SET_INIT_STR(string_set)
 
 // A hash table whose keys are C strings and whose values are also C strings.
 KHASH_MAP_INIT_STR(string_map, const char*)
@@ -72,23 +88,178 @@ KHASH_MAP_INIT_STR(param_map, sw_real_t)
 typedef kvec_t(sw_real_t) real_vec_t;
 KHASH_MAP_INIT_STR(array_param_map, real_vec_t)
 
-// A list of strings to be deallocated by skywalker.
-static klist_t(string_list)* sw_strings_ = NULL;
+// Ensembles can be traversed by several threads at once, and streamed outputs
+// are written by a background thread, so some of our data structures need a
+// little synchronization. Here are the portable mutexes, condition variables,
+// threads, and atomic pointer operations we use for this.
+#ifdef _WIN32
 
-// This function cleans up all maintained strings at the end of a process.
-static void free_strings() {
-  kl_destroy(string_list, sw_strings_);
+typedef SRWLOCK sw_mutex_t;
+#define SW_MUTEX_INITIALIZER SRWLOCK_INIT
+
+static void sw_mutex_init(sw_mutex_t *mutex) {
+  InitializeSRWLock(mutex);
 }
 
-// This function appends a string to the list of maintained strings, setting
-// things up when it's called for the first time.
-static void append_string(const char *s) {
-  if (!sw_strings_) {
-    sw_strings_ = kl_init(string_list);
-    atexit(free_strings);
-  }
-  const char ** s_p = kl_pushp(string_list, sw_strings_);
-  *s_p = s;
+static void sw_mutex_destroy(sw_mutex_t *mutex) {
+}
+
+static void sw_mutex_lock(sw_mutex_t *mutex) {
+  AcquireSRWLockExclusive(mutex);
+}
+
+static void sw_mutex_unlock(sw_mutex_t *mutex) {
+  ReleaseSRWLockExclusive(mutex);
+}
+
+typedef CONDITION_VARIABLE sw_cond_t;
+
+static void sw_cond_init(sw_cond_t *cond) {
+  InitializeConditionVariable(cond);
+}
+
+static void sw_cond_destroy(sw_cond_t *cond) {
+}
+
+// Waits for the condition to be signaled, releasing the given (locked) mutex
+// while waiting.
+static void sw_cond_wait(sw_cond_t *cond, sw_mutex_t *mutex) {
+  SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+}
+
+static void sw_cond_broadcast(sw_cond_t *cond) {
+  WakeAllConditionVariable(cond);
+}
+
+// A thread that calls a function with an argument.
+typedef struct sw_thread_t {
+  HANDLE handle;
+  void (*func)(void*);
+  void *arg;
+} sw_thread_t;
+
+static DWORD WINAPI sw_thread_main(LPVOID thread) {
+  ((sw_thread_t*)thread)->func(((sw_thread_t*)thread)->arg);
+  return 0;
+}
+
+// Starts the given thread, which calls func(arg), returning false if it can't
+// be started.
+static bool sw_thread_start(sw_thread_t *thread, void (*func)(void*),
+                            void *arg) {
+  thread->func = func;
+  thread->arg = arg;
+  thread->handle = CreateThread(NULL, 0, sw_thread_main, thread, 0, NULL);
+  return (thread->handle != NULL);
+}
+
+// Waits for the given thread to finish.
+static void sw_thread_join(sw_thread_t *thread) {
+  WaitForSingleObject(thread->handle, INFINITE);
+  CloseHandle(thread->handle);
+}
+
+// Loads the pointer stored at p, acquiring anything published with it.
+static void *sw_load_ptr(void *const *p) {
+  return InterlockedCompareExchangePointer((PVOID volatile*)p, NULL, NULL);
+}
+
+// Stores the pointer value at p, publishing everything written before it.
+static void sw_store_ptr(void **p, void *value) {
+  InterlockedExchangePointer((PVOID volatile*)p, value);
+}
+
+#else
+
+typedef pthread_mutex_t sw_mutex_t;
+#define SW_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+
+static void sw_mutex_init(sw_mutex_t *mutex) {
+  pthread_mutex_init(mutex, NULL);
+}
+
+static void sw_mutex_destroy(sw_mutex_t *mutex) {
+  pthread_mutex_destroy(mutex);
+}
+
+static void sw_mutex_lock(sw_mutex_t *mutex) {
+  pthread_mutex_lock(mutex);
+}
+
+static void sw_mutex_unlock(sw_mutex_t *mutex) {
+  pthread_mutex_unlock(mutex);
+}
+
+typedef pthread_cond_t sw_cond_t;
+
+static void sw_cond_init(sw_cond_t *cond) {
+  pthread_cond_init(cond, NULL);
+}
+
+static void sw_cond_destroy(sw_cond_t *cond) {
+  pthread_cond_destroy(cond);
+}
+
+// Waits for the condition to be signaled, releasing the given (locked) mutex
+// while waiting.
+static void sw_cond_wait(sw_cond_t *cond, sw_mutex_t *mutex) {
+  pthread_cond_wait(cond, mutex);
+}
+
+static void sw_cond_broadcast(sw_cond_t *cond) {
+  pthread_cond_broadcast(cond);
+}
+
+// A thread that calls a function with an argument.
+typedef struct sw_thread_t {
+  pthread_t thread;
+  void (*func)(void*);
+  void *arg;
+} sw_thread_t;
+
+static void *sw_thread_main(void *thread) {
+  ((sw_thread_t*)thread)->func(((sw_thread_t*)thread)->arg);
+  return NULL;
+}
+
+// Starts the given thread, which calls func(arg), returning false if it can't
+// be started.
+static bool sw_thread_start(sw_thread_t *thread, void (*func)(void*),
+                            void *arg) {
+  thread->func = func;
+  thread->arg = arg;
+  return !pthread_create(&thread->thread, NULL, sw_thread_main, thread);
+}
+
+// Waits for the given thread to finish.
+static void sw_thread_join(sw_thread_t *thread) {
+  pthread_join(thread->thread, NULL);
+}
+
+// Loads the pointer stored at p, acquiring anything published with it.
+static void *sw_load_ptr(void *const *p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+// Stores the pointer value at p, publishing everything written before it.
+static void sw_store_ptr(void **p, void *value) {
+  __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+#endif
+
+// Returns the time in seconds on a monotonic clock, for ensemble statistics.
+static double sw_clock(void) {
+#ifdef _WIN32
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (double)count.QuadPart / (double)frequency.QuadPart;
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec + 1e-9 * (double)t.tv_nsec;
+#endif
 }
 
 // Here we implement a portable version of the non-standard vasprintf
@@ -117,50 +288,216 @@ static int sw_vasprintf(char **strp, const char *format, va_list ap) {
   return retval;
 }
 
-// This function constructs a string in the manner of sprintf, but allocates
-// and returns a string of sufficient size. Strings created this way are freed
-// when the program exits,
-static const char* new_string(const char *fmt, ...) {
+// This function returns a newly-allocated copy of the given string, which must
+// be freed by the caller.
+static const char* copy_string(const char *s) {
+  size_t len = strlen(s);
+  char *dup = malloc(sizeof(char)*(len+1));
+  strcpy(dup, s);
+  return (const char*)dup;
+}
+
+// An arena hands out memory from a few large blocks, all of which are freed
+// at once when the arena is freed. Arenas store data that lives as long as
+// the ensemble that owns them (names and arrays of parameter values), so that
+// loading an ensemble makes few allocations and freeing it doesn't have to
+// visit each of them. Arenas aren't thread-safe.
+typedef struct arena_block_t {
+  struct arena_block_t *next;
+  size_t size, capacity; // bytes used and available in the block
+} arena_block_t;
+
+typedef struct arena_t {
+  arena_block_t *blocks; // the block in use comes first
+} arena_t;
+
+// Alignment of memory handed out by arenas, suitable for any data we store.
+#define ARENA_ALIGNMENT 16
+
+// Size of the header at the start of each block.
+#define ARENA_HEADER_SIZE \
+  ((sizeof(arena_block_t) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+// Blocks start small and double in size up to a maximum.
+#define ARENA_MIN_BLOCK_SIZE (1 << 12)
+#define ARENA_MAX_BLOCK_SIZE (1 << 24)
+
+static arena_t *arena_new() {
+  arena_t *arena = malloc(sizeof(arena_t));
+  arena->blocks = NULL;
+  return arena;
+}
+
+static void arena_free(arena_t *arena) {
+  for (arena_block_t *block = arena->blocks; block;) {
+    arena_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+  free(arena);
+}
+
+// Returns a pointer to size bytes of memory allocated in the given arena.
+static void *arena_alloc(arena_t *arena, size_t size) {
+  size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+  arena_block_t *block = arena->blocks;
+  if (!block || (block->size + size > block->capacity)) {
+    size_t capacity = (block) ? 2 * block->capacity : ARENA_MIN_BLOCK_SIZE;
+    if (capacity > ARENA_MAX_BLOCK_SIZE) capacity = ARENA_MAX_BLOCK_SIZE;
+    if (capacity < size) capacity = size;
+    arena_block_t *new_block = malloc(ARENA_HEADER_SIZE + capacity);
+    new_block->size = 0;
+    new_block->capacity = capacity;
+    if (block && (capacity == size)) {
+      // This block is used up by this allocation, so keep using the current
+      // one afterward.
+      new_block->next = block->next;
+      block->next = new_block;
+    } else {
+      new_block->next = block;
+      arena->blocks = new_block;
+    }
+    block = new_block;
+  }
+  void *p = (char*)block + ARENA_HEADER_SIZE + block->size;
+  block->size += size;
+  return p;
+}
+
+// Returns the number of bytes allocated for the given arena's blocks.
+static size_t arena_size(const arena_t *arena) {
+  size_t size = 0;
+  for (const arena_block_t *block = arena->blocks; block; block = block->next)
+    size += ARENA_HEADER_SIZE + block->capacity;
+  return size;
+}
+
+// Returns a copy of the given string allocated in the given arena.
+static const char *arena_copy_string(arena_t *arena, const char *s) {
+  size_t len = strlen(s);
+  char *copy = arena_alloc(arena, len + 1);
+  memcpy(copy, s, len + 1);
+  return copy;
+}
+
+// A string pool stores strings that live as long as the object that owns the
+// pool, keeping one copy of each distinct string. Error messages are stored in
+// pools, so a lookup that fails repeatedly (e.g. a probe for an optional
+// parameter) doesn't use more memory each time. Pools are thread-safe.
+typedef struct string_pool_t {
+  khash_t(string_set) *strings;
+  arena_t *arena;
+  sw_mutex_t mutex;
+} string_pool_t;
+
+static string_pool_t *string_pool_new() {
+  string_pool_t *pool = malloc(sizeof(string_pool_t));
+  pool->strings = kh_init(string_set);
+  pool->arena = arena_new();
+  sw_mutex_init(&pool->mutex);
+  return pool;
+}
+
+static void string_pool_free(string_pool_t *pool) {
+  sw_mutex_destroy(&pool->mutex);
+  arena_free(pool->arena);
+  kh_destroy(string_set, pool->strings);
+  free(pool);
+}
+
+// Returns the given pool's copy of the given string, adding one if needed.
+static const char *pool_string(string_pool_t *pool, const char *s) {
+  sw_mutex_lock(&pool->mutex);
+  const char *pooled;
+  khiter_t iter = kh_get(string_set, pool->strings, s);
+  if (iter != kh_end(pool->strings)) {
+    pooled = kh_key(pool->strings, iter);
+  } else {
+    pooled = arena_copy_string(pool->arena, s);
+    int ret;
+    kh_put(string_set, pool->strings, pooled, &ret);
+  }
+  sw_mutex_unlock(&pool->mutex);
+  return pooled;
+}
+
+static const char *pool_vformat(string_pool_t *pool, const char *fmt,
+                                va_list ap) {
+  // Most messages fit into a small buffer on the stack.
+  char buffer[256];
+  va_list ap_copy;
+  va_copy(ap_copy, ap);
+  int len = vsnprintf(buffer, sizeof(buffer), fmt, ap_copy);
+  va_end(ap_copy);
+  if (len < 0) return pool_string(pool, fmt);
+  if ((size_t)len < sizeof(buffer)) return pool_string(pool, buffer);
   char *s;
+  if (sw_vasprintf(&s, fmt, ap) == -1) return pool_string(pool, fmt);
+  const char *pooled = pool_string(pool, s);
+  free(s);
+  return pooled;
+}
+
+// This function constructs a string in the manner of sprintf and returns the
+// given pool's copy of it.
+static const char *pool_format(string_pool_t *pool, const char *fmt, ...) {
   va_list ap;
   va_start(ap, fmt);
-  sw_vasprintf(&s, fmt, ap);
+  const char *s = pool_vformat(pool, fmt, ap);
   va_end(ap);
-  append_string(s);
   return s;
 }
 
-// This function duplicates the given string and appends it to the list of
-// strings to be freed when the program exits.
-static const char* dup_string(const char *s) {
-  size_t len = strlen(s);
-  char *dup = malloc(sizeof(char)*(len+1));
-  strcpy(dup, s);
-  append_string(dup);
-  return (const char*)dup;
+// Messages for errors that occur when no ensemble exists to own them (i.e.
+// while loading one) are stored in this pool, which is freed when the program
+// exits, and a mutex protects its creation.
+static string_pool_t *sw_strings_ = NULL;
+static sw_mutex_t sw_strings_mutex_ = SW_MUTEX_INITIALIZER;
+
+static void free_strings() {
+  string_pool_free(sw_strings_);
+}
+
+// This function constructs a string in the manner of sprintf and stores it in
+// the pool of strings freed when the program exits.
+static const char* new_string(const char *fmt, ...) {
+  sw_mutex_lock(&sw_strings_mutex_);
+  if (!sw_strings_) {
+    sw_strings_ = string_pool_new();
+    atexit(free_strings);
+  }
+  sw_mutex_unlock(&sw_strings_mutex_);
+  va_list ap;
+  va_start(ap, fmt);
+  const char *s = pool_vformat(sw_strings_, fmt, ap);
+  va_end(ap);
+  return s;
 }
 
 struct sw_settings_t {
   khash_t(string_map) *params;
+  string_pool_t *strings; // names, values, and error messages
 };
 
 // Creates a settings instance.
 static sw_settings_t *sw_settings_new() {
   sw_settings_t *settings = malloc(sizeof(sw_settings_t));
   settings->params = kh_init(string_map);
+  settings->strings = string_pool_new();
   return settings;
 }
 
 // Destroys a settings instance, freeing all allocated resources.
 static void sw_settings_free(sw_settings_t *settings) {
   kh_destroy(string_map, settings->params);
+  string_pool_free(settings->strings);
   free(settings);
 }
 
 static void sw_settings_set(sw_settings_t *settings, const char *name,
                             const char *value) {
-  const char* n = dup_string(name);
-  const char* v = dup_string(value);
+  const char* n = pool_string(settings->strings, name);
+  const char* v = pool_string(settings->strings, value);
   int ret;
   khiter_t iter = kh_put(string_map, settings->params, n, &ret);
   assert(ret == 1);
@@ -180,146 +517,538 @@ sw_settings_result_t sw_settings_get(sw_settings_t *settings,
     result.value = kh_val(settings->params, iter);
   } else {
     result.error_code = SW_PARAM_NOT_FOUND;
-    const char *s = new_string("The setting '%s' was not found.", name);
+    const char *s = pool_format(settings->strings,
+                                "The setting '%s' was not found.", name);
     result.error_message = s;
   }
   return result;
 }
 
-struct sw_input_t {
-  khash_t(param_map) *params;
-  khash_t(array_param_map) *array_params;
-};
+// A hash table whose keys are C strings and whose values are integer handles.
+KHASH_MAP_INIT_STR(handle_map, sw_handle_t)
+
+// A vector of C strings.
+typedef kvec_t(const char*) string_vec_t;
+
+// A name table interns a set of names, assigning to each a handle equal to its
+// position in the table. Names are not copied, so they must outlive the table.
+typedef struct name_table_t {
+  khash_t(handle_map) *handles;
+  string_vec_t names;
+} name_table_t;
+
+static void name_table_init(name_table_t *table) {
+  table->handles = kh_init(handle_map);
+  kv_init(table->names);
+}
 
-static void sw_input_set(sw_input_t *input, const char *name, sw_real_t value) {
-  const char* n = dup_string(name);
+static void name_table_destroy(name_table_t *table) {
+  kh_destroy(handle_map, table->handles);
+  kv_destroy(table->names);
+}
+
+// Returns the number of names in the given table.
+static size_t name_table_size(const name_table_t *table) {
+  return kv_size(table->names);
+}
+
+// Returns the handle for the given name, or -1 if the name isn't in the table.
+static sw_handle_t name_table_find(const name_table_t *table, const char *name) {
+  khiter_t iter = kh_get(handle_map, table->handles, name);
+  return (iter != kh_end(table->handles)) ? kh_val(table->handles, iter) : -1;
+}
+
+// Adds the given name to the table, returning its new handle.
+static sw_handle_t name_table_add(name_table_t *table, const char *name) {
+  sw_handle_t handle = (sw_handle_t)kv_size(table->names);
   int ret;
-  khiter_t iter = kh_put(param_map, input->params, n, &ret);
+  khiter_t iter = kh_put(handle_map, table->handles, name, &ret);
   assert(ret == 1);
-  kh_value(input->params, iter) = value;
+  kh_value(table->handles, iter) = handle;
+  kv_push(const char*, table->names, name);
+  return handle;
 }
 
-static void sw_input_set_array(sw_input_t *input, const char *name,
-                               real_vec_t values) {
-  const char* n = dup_string(name);
-  int ret;
-  // Make a copy of the array values.
-  real_vec_t my_values;
-  kv_init(my_values);
-  for (size_t i = 0; i < kv_size(values); ++i) {
-    kv_push(sw_real_t, my_values, kv_A(values, i));
+// Returns true if the given handle belongs to the given name table.
+static bool name_table_has(const name_table_t *table, sw_handle_t handle) {
+  return (handle >= 0) && ((size_t)handle < kv_size(table->names));
+}
+
+// This type describes how an input parameter's values vary across the members
+// of an ensemble: member l is assigned value number (l / stride) % count.
+// Values belong to the ensemble's parsed parameter data.
+typedef struct input_param_t {
+  const sw_real_t *values;  // scalar values (NULL for arrays)
+  const real_vec_t *arrays; // array values (NULL for scalars)
+  size_t stride, count;
+} input_param_t;
+
+typedef kvec_t(input_param_t) input_param_vec_t;
+
+// Returns the index of the value of the given parameter for member l.
+static size_t param_index(const input_param_t *param, size_t l) {
+  return (l / param->stride) % param->count;
+}
+
+// Copies the values of the given scalar parameter for the n members starting
+// with member l into the given array.
+static void gather_param_values(const input_param_t *param, size_t l,
+                                size_t n, sw_real_t *values) {
+  // Each value is shared by a run of stride members.
+  size_t k = param_index(param, l), r = l % param->stride;
+  for (size_t i = 0; i < n; ++i) {
+    values[i] = param->values[k];
+    if (++r == param->stride) {
+      r = 0;
+      if (++k == param->count) k = 0;
+    }
   }
+}
 
-  // Insert the copy.
-  khiter_t iter = kh_put(array_param_map, input->array_params, n, &ret);
-  assert(ret == 1);
-  kh_value(input->array_params, iter) = my_values;
+// An input layout assigns handles to the names of an ensemble's input
+// parameters (scalars and arrays separately), and describes the values of
+// the parameter for each handle.
+typedef struct input_layout_t {
+  name_table_t params, array_params;
+  input_param_vec_t param_info, array_param_info;
+  string_pool_t *errors; // the ensemble's pool, for error messages
+} input_layout_t;
+
+static void input_layout_init(input_layout_t *layout) {
+  name_table_init(&layout->params);
+  name_table_init(&layout->array_params);
+  kv_init(layout->param_info);
+  kv_init(layout->array_param_info);
+  layout->errors = NULL;
+}
+
+static void input_layout_destroy(input_layout_t *layout) {
+  name_table_destroy(&layout->params);
+  name_table_destroy(&layout->array_params);
+  kv_destroy(layout->param_info);
+  kv_destroy(layout->array_param_info);
+}
+
+// Adds a scalar parameter with the given name and values to the layout.
+static void add_input_param(input_layout_t *layout, const char *name,
+                            const sw_real_t *values, size_t stride,
+                            size_t count) {
+  name_table_add(&layout->params, name);
+  input_param_t param = {.values = values, .stride = stride, .count = count};
+  kv_push(input_param_t, layout->param_info, param);
+}
+
+// Adds an array parameter with the given name and values to the layout.
+static void add_input_array_param(input_layout_t *layout, const char *name,
+                                  const real_vec_t *arrays, size_t stride,
+                                  size_t count) {
+  name_table_add(&layout->array_params, name);
+  input_param_t param = {.arrays = arrays, .stride = stride, .count = count};
+  kv_push(input_param_t, layout->array_param_info, param);
+}
+
+// An input is a view of one ensemble member's parameters. Values aren't
+// stored per member: they're looked up from the layout using the member's
+// index.
+struct sw_input_t {
+  const input_layout_t *layout;
+  size_t index;
+};
+
+// Returns the value of the scalar input parameter with the given (valid)
+// handle.
+static sw_real_t input_value(const sw_input_t *input, sw_handle_t handle) {
+  const input_param_t *param = &kv_A(input->layout->param_info, handle);
+  return param->values[param_index(param, input->index)];
+}
+
+// Returns the values of the input array parameter with the given (valid)
+// handle.
+static real_vec_t input_array(const sw_input_t *input, sw_handle_t handle) {
+  const input_param_t *param = &kv_A(input->layout->array_param_info, handle);
+  return param->arrays[param_index(param, input->index)];
 }
 
 bool sw_input_has(sw_input_t *input, const char *name) {
-  khiter_t iter = kh_get(param_map, input->params, name);
-  return (iter != kh_end(input->params));
+  return (name_table_find(&input->layout->params, name) >= 0);
 }
 
 sw_input_result_t sw_input_get(sw_input_t *input, const char *name) {
-  khiter_t iter = kh_get(param_map, input->params, name);
   sw_input_result_t result = {.error_code = SW_SUCCESS};
-  if (iter != kh_end(input->params)) {
-    result.value = kh_val(input->params, iter);
+  sw_handle_t handle = name_table_find(&input->layout->params, name);
+  if (handle >= 0) {
+    result.value = input_value(input, handle);
+  } else {
+    result.error_code = SW_PARAM_NOT_FOUND;
+    const char *s = pool_format(input->layout->errors,
+                                "The input parameter '%s' was not found.",
+                                name);
+    result.error_message = s;
+  }
+  return result;
+}
+
+sw_input_result_t sw_input_get_h(sw_input_t *input, sw_handle_t handle) {
+  sw_input_result_t result = {.error_code = SW_SUCCESS};
+  if (name_table_has(&input->layout->params, handle)) {
+    result.value = input_value(input, handle);
   } else {
     result.error_code = SW_PARAM_NOT_FOUND;
-    const char *s = new_string("The input parameter '%s' was not found.", name);
+    const char *s = pool_format(input->layout->errors,
+                                "Invalid input parameter handle: %d", handle);
     result.error_message = s;
   }
   return result;
 }
 
 bool sw_input_has_array(sw_input_t *input, const char *name) {
-  khiter_t iter = kh_get(array_param_map, input->array_params, name);
-  return (iter != kh_end(input->array_params));
+  return (name_table_find(&input->layout->array_params, name) >= 0);
 }
 
 sw_input_array_result_t sw_input_get_array(sw_input_t *input, const char *name) {
-  khiter_t iter = kh_get(array_param_map, input->array_params, name);
   sw_input_array_result_t result = {.error_code = SW_SUCCESS};
-  if (iter != kh_end(input->array_params)) {
-    real_vec_t values = kh_val(input->array_params, iter);
+  sw_handle_t handle = name_table_find(&input->layout->array_params, name);
+  if (handle >= 0) {
+    real_vec_t values = input_array(input, handle);
+    result.size = kv_size(values);
+    result.values = values.a;
+  } else {
+    result.error_code = SW_PARAM_NOT_FOUND;
+    const char *s = pool_format(input->layout->errors,
+                                "The input array parameter '%s' was not found.",
+                                name);
+    result.error_message = s;
+  }
+  return result;
+}
+
+sw_input_array_result_t sw_input_get_array_h(sw_input_t *input,
+                                             sw_handle_t handle) {
+  sw_input_array_result_t result = {.error_code = SW_SUCCESS};
+  if (name_table_has(&input->layout->array_params, handle)) {
+    real_vec_t values = input_array(input, handle);
     result.size = kv_size(values);
     result.values = values.a;
   } else {
     result.error_code = SW_PARAM_NOT_FOUND;
-    const char *s = new_string("The input array parameter '%s' was not found.",
-                               name);
+    const char *s = pool_format(input->layout->errors,
+                                "Invalid input array parameter handle: %d",
+                                handle);
     result.error_message = s;
   }
   return result;
 }
 
+// An array-valued output quantity. Members' values are stored in rows of a
+// single buffer whose width is set by the first member to store a nonempty
+// array. A member whose array doesn't fit in its row stores it separately
+// instead. (The buffer can't be widened later, since other members may be
+// writing to their rows at the time.)
+typedef struct array_column_t {
+  size_t *sizes;     // number of values set by each member (0 if unset)
+  size_t width;      // number of values reserved for each member
+  sw_real_t *values; // rows of width values (NULL until first set)
+  sw_real_t **rows;  // separately-stored rows (NULL if not needed)
+} array_column_t;
+
+// storage for empty arrays in columns with no other values
+static sw_real_t no_array_values_[1];
+
+// Returns the values stored for member i in the given array column.
+static sw_real_t *array_column_row(const array_column_t *column, size_t i) {
+  if (column->rows[i]) return column->rows[i];
+  return (column->values) ? &column->values[i*column->width] : no_array_values_;
+}
+
+// An output index maps the names of output quantities to handles and handles
+// to column storage. It holds up to a fixed number of quantities, and can be
+// read without locking: an entry is written completely before its name is
+// placed in a hash slot, and entries never change once they're published.
+// When an index fills up, it's replaced by a larger copy, and the old one is
+// kept around until the schema is destroyed, since threads may still be
+// reading it.
+typedef struct output_index_t {
+  size_t capacity;            // maximum number of quantities
+  const char **names;         // quantity names, by handle
+  void **columns;             // quantity storage, by handle
+  size_t num_slots;           // number of hash slots (a power of 2)
+  const char **slot_names;    // names of quantities in hash slots (or NULL)
+  sw_handle_t *slot_handles;  // handles of quantities in hash slots
+} output_index_t;
+
+static output_index_t *output_index_new(size_t capacity) {
+  output_index_t *index = malloc(sizeof(output_index_t));
+  index->capacity = capacity;
+  index->names = calloc(capacity, sizeof(const char*));
+  index->columns = calloc(capacity, sizeof(void*));
+  index->num_slots = 2 * capacity;
+  index->slot_names = calloc(index->num_slots, sizeof(const char*));
+  index->slot_handles = calloc(index->num_slots, sizeof(sw_handle_t));
+  return index;
+}
+
+static void output_index_free(output_index_t *index) {
+  free(index->names);
+  free(index->columns);
+  free(index->slot_names);
+  free(index->slot_handles);
+  free(index);
+}
+
+// Returns the handle for the given name in the given index, or -1 if the name
+// isn't there.
+static sw_handle_t output_index_find(const output_index_t *index,
+                                     const char *name) {
+  size_t mask = index->num_slots - 1;
+  for (size_t i = kh_str_hash_func(name) & mask;; i = (i + 1) & mask) {
+    const char *slot_name = sw_load_ptr((void* const*)&index->slot_names[i]);
+    if (!slot_name) return -1;
+    if (!strcmp(slot_name, name)) return index->slot_handles[i];
+  }
+}
+
+// Adds the quantity with the given name, handle, and storage to the given
+// index, which must have room for it.
+static void output_index_add(output_index_t *index, const char *name,
+                             sw_handle_t handle, void *column) {
+  assert((size_t)handle < index->capacity);
+  index->names[handle] = name;
+  index->columns[handle] = column;
+  size_t mask = index->num_slots - 1;
+  size_t i = kh_str_hash_func(name) & mask;
+  while (index->slot_names[i]) i = (i + 1) & mask;
+  index->slot_handles[i] = handle;
+  sw_store_ptr((void**)&index->slot_names[i], (void*)name);
+}
+
+// A table of output quantities of one kind (scalar or array).
+typedef struct output_table_t {
+  output_index_t *index;
+  size_t size; // number of quantities (accessed only under the schema's lock)
+  kvec_t(output_index_t*) retired; // replaced indices
+} output_table_t;
+
+static void output_table_init(output_table_t *table) {
+  table->index = output_index_new(16);
+  table->size = 0;
+  kv_init(table->retired);
+}
+
+static void output_table_destroy(output_table_t *table) {
+  for (size_t i = 0; i < kv_size(table->retired); ++i)
+    output_index_free(kv_A(table->retired, i));
+  kv_destroy(table->retired);
+  output_index_free(table->index);
+}
+
+// Returns the current index for the given table.
+static output_index_t *output_table_index(const output_table_t *table) {
+  return sw_load_ptr((void* const*)&table->index);
+}
+
+// Adds a quantity with the given name and storage to the given table,
+// returning its handle. Must be called only by the thread holding the
+// schema's lock.
+static sw_handle_t output_table_add(output_table_t *table, const char *name,
+                                    void *column) {
+  output_index_t *index = table->index;
+  if (table->size == index->capacity) {
+    // Publish a larger copy of the index.
+    output_index_t *new_index = output_index_new(2 * index->capacity);
+    for (size_t h = 0; h < table->size; ++h)
+      output_index_add(new_index, index->names[h], (sw_handle_t)h,
+                       index->columns[h]);
+    kv_push(output_index_t*, table->retired, index);
+    sw_store_ptr((void**)&table->index, new_index);
+    index = new_index;
+  }
+  sw_handle_t handle = (sw_handle_t)table->size;
+  output_index_add(index, name, handle, column);
+  ++table->size;
+  return handle;
+}
+
+// An output schema assigns handles to the names of an ensemble's output
+// quantities (scalars and arrays separately) as they're registered, and
+// stores each quantity for all members in a column indexed by member. Outputs
+// for different members can be recorded concurrently: registering a new
+// quantity takes the schema's lock, but looking up one that's already
+// registered and storing values don't. The schema owns its names, which are
+// stored in an arena.
+typedef struct output_schema_t {
+  size_t num_members;
+  output_table_t metrics, array_metrics;
+  arena_t *names;
+  sw_mutex_t mutex;
+} output_schema_t;
+
+static void output_schema_init(output_schema_t *schema, size_t num_members) {
+  schema->num_members = num_members;
+  output_table_init(&schema->metrics);
+  output_table_init(&schema->array_metrics);
+  schema->names = arena_new();
+  sw_mutex_init(&schema->mutex);
+}
+
+static void output_schema_destroy(output_schema_t *schema) {
+  output_index_t *index = schema->metrics.index;
+  for (size_t h = 0; h < schema->metrics.size; ++h)
+    free(index->columns[h]);
+  index = schema->array_metrics.index;
+  for (size_t h = 0; h < schema->array_metrics.size; ++h) {
+    array_column_t *column = index->columns[h];
+    for (size_t i = 0; i < schema->num_members; ++i)
+      free(column->rows[i]);
+    free(column->rows);
+    free(column->sizes);
+    free(column->values);
+    free(column);
+  }
+  output_table_destroy(&schema->metrics);
+  output_table_destroy(&schema->array_metrics);
+  arena_free(schema->names);
+  sw_mutex_destroy(&schema->mutex);
+}
+
+// Returns the handle for the scalar quantity with the given name, registering
+// it (and allocating its column) if it's not already in the schema.
+static sw_handle_t output_schema_handle(output_schema_t *schema,
+                                        const char *name) {
+  sw_handle_t handle = output_index_find(output_table_index(&schema->metrics),
+                                         name);
+  if (handle < 0) {
+    sw_mutex_lock(&schema->mutex);
+    handle = output_index_find(schema->metrics.index, name);
+    if (handle < 0) {
+      sw_real_t *column = malloc(sizeof(sw_real_t) * (schema->num_members + 1));
+      for (size_t i = 0; i < schema->num_members; ++i)
+        column[i] = NAN;
+      handle = output_table_add(&schema->metrics,
+                                arena_copy_string(schema->names, name),
+                                column);
+    }
+    sw_mutex_unlock(&schema->mutex);
+  }
+  return handle;
+}
+
+// Returns the handle for the array quantity with the given name, registering
+// it if it's not already in the schema. Storage for its values is allocated
+// when they're first set.
+static sw_handle_t output_schema_array_handle(output_schema_t *schema,
+                                              const char *name) {
+  sw_handle_t handle =
+    output_index_find(output_table_index(&schema->array_metrics), name);
+  if (handle < 0) {
+    sw_mutex_lock(&schema->mutex);
+    handle = output_index_find(schema->array_metrics.index, name);
+    if (handle < 0) {
+      array_column_t *column = malloc(sizeof(array_column_t));
+      column->sizes = calloc(schema->num_members + 1, sizeof(size_t));
+      column->width = 0;
+      column->values = NULL;
+      column->rows = calloc(schema->num_members + 1, sizeof(sw_real_t*));
+      handle = output_table_add(&schema->array_metrics,
+                                arena_copy_string(schema->names, name),
+                                column);
+    }
+    sw_mutex_unlock(&schema->mutex);
+  }
+  return handle;
+}
+
+// Returns the storage for the quantity with the given handle in the given
+// table, or NULL if the handle is invalid.
+static void *output_column(const output_table_t *table, sw_handle_t handle) {
+  const output_index_t *index = output_table_index(table);
+  if ((handle < 0) || ((size_t)handle >= index->capacity)) return NULL;
+  return index->columns[handle];
+}
+
+// An output is a view of one member's row in its ensemble's output columns.
 struct sw_output_t {
-  khash_t(param_map) *metrics;
-  khash_t(array_param_map) *array_metrics;
+  output_schema_t *schema;
+  size_t index;
 };
 
+void sw_output_set_h(sw_output_t *output, sw_handle_t handle, sw_real_t value) {
+  sw_real_t *column = output_column(&output->schema->metrics, handle);
+  if (column)
+    column[output->index] = value;
+}
+
+sw_real_t *sw_output_reserve_array_h(sw_output_t *output, sw_handle_t handle,
+                                     size_t size) {
+  output_schema_t *schema = output->schema;
+  array_column_t *column = output_column(&schema->array_metrics, handle);
+  if (!column) return NULL;
+
+  // An empty array needs no storage, so it doesn't set the column's width.
+  size_t i = output->index;
+  if (size == 0) {
+    free(column->rows[i]);
+    column->rows[i] = NULL;
+    column->sizes[i] = 0;
+    return no_array_values_;
+  }
+
+  // The first member to store values sets the width of the column's rows.
+  if (!sw_load_ptr((void* const*)&column->values)) {
+    sw_mutex_lock(&schema->mutex);
+    if (!column->values) {
+      column->width = size;
+      sw_store_ptr((void**)&column->values,
+                   malloc(sizeof(sw_real_t) * (schema->num_members * size + 1)));
+    }
+    sw_mutex_unlock(&schema->mutex);
+  }
+
+  sw_real_t *row;
+  if (size <= column->width) {
+    free(column->rows[i]);
+    column->rows[i] = NULL;
+    row = &column->values[i * column->width];
+  } else {
+    column->rows[i] = realloc(column->rows[i], sizeof(sw_real_t) * size);
+    row = column->rows[i];
+  }
+  column->sizes[i] = size;
+  return row;
+}
+
+void sw_output_set_array_h(sw_output_t *output, sw_handle_t handle,
+                           const sw_real_t *values, size_t size) {
+  sw_real_t *row = sw_output_reserve_array_h(output, handle, size);
+  if (row && (size > 0))
+    memcpy(row, values, sizeof(sw_real_t) * size);
+}
+
 void sw_output_set(sw_output_t *output, const char *name, sw_real_t value) {
-  const char* n = dup_string(name);
-  int ret;
-  khiter_t iter = kh_put(param_map, output->metrics, n, &ret);
-  assert(ret == 1);
-  kh_value(output->metrics, iter) = value;
+  sw_handle_t handle = output_schema_handle(output->schema, name);
+  sw_output_set_h(output, handle, value);
 }
 
 void sw_output_set_array(sw_output_t *output, const char *name,
                          const sw_real_t *values, size_t size) {
-  const char* n = dup_string(name);
-  int ret;
-  khiter_t iter = kh_put(array_param_map, output->array_metrics, n, &ret);
-  assert(ret == 1);
-  real_vec_t array;
-  kv_init(array);
-  for (size_t i=0; i<size; ++i)
-    kv_push(sw_real_t, array, values[i]); // append
-  kh_value(output->array_metrics, iter) = array;
+  sw_handle_t handle = output_schema_array_handle(output->schema, name);
+  sw_output_set_array_h(output, handle, values, size);
 }
 
-// ensemble type
-struct sw_ensemble_t {
-  size_t size, position;
-  sw_input_t *inputs;
-  sw_output_t *outputs;
-  sw_settings_t *settings; // for writing and freeing
-};
+sw_real_t *sw_output_reserve_array(sw_output_t *output, const char *name,
+                                   size_t size) {
+  sw_handle_t handle = output_schema_array_handle(output->schema, name);
+  return sw_output_reserve_array_h(output, handle, size);
+}
 
 //------------------------------------------------------------------------
 //                              YAML parsing
 //------------------------------------------------------------------------
 
-// A YAML-specific string pool.
-static klist_t(string_list)* yaml_strings_ = NULL;
-
-// This function cleans up all maintained strings at the end of a process.
-static void free_yaml_strings() {
-  if (yaml_strings_) {
-    kl_destroy(string_list, yaml_strings_);
-    yaml_strings_ = NULL;
-  }
-}
-
 // This function creates a copy of a string encountered in the YAML parser,
-// placing it in the YAML string pool.
-static const char* dup_yaml_string(const char *s) {
-  // Copy the string.
-  size_t len = strlen(s);
-  char *dup = malloc(sizeof(char)*(len+1));
-  strcpy(dup, s);
-
-  // Stick it in the YAML string pool.
-  if (!yaml_strings_) {
-    yaml_strings_ = kl_init(string_list);
-  }
-  const char ** s_p = kl_pushp(string_list, yaml_strings_);
-  *s_p = dup;
-
-  return (const char*)dup;
+// placing it in the given arena. The arena belongs to the parsed YAML data,
+// and is handed off to the ensemble built from it.
+static const char* dup_yaml_string(arena_t *arena, const char *s) {
+  return arena_copy_string(arena, s);
 }
 
 // A hash table whose keys are C strings and whose values are real numbers.
@@ -328,6 +1057,20 @@ KHASH_MAP_INIT_STR(yaml_param_map, real_vec_t)
 // A vector of vectors containing real numbers.
 typedef kvec_t(real_vec_t) real_vec_vec_t;
 
+// Appends the given values to a vector of real numbers, growing it at most
+// once.
+static void append_values(real_vec_t *vec, const sw_real_t *values,
+                          size_t num_values) {
+  if (num_values == 1) {
+    kv_push(sw_real_t, *vec, values[0]);
+    return;
+  }
+  if (kv_size(*vec) + num_values > kv_max(*vec))
+    kv_resize(sw_real_t, *vec, kv_size(*vec) + num_values);
+  memcpy(vec->a + kv_size(*vec), values, sizeof(sw_real_t) * num_values);
+  kv_size(*vec) += num_values;
+}
+
 // A hash table whose keys are C strings and whose values are arrays of real
 // numbers.
 KHASH_MAP_INIT_STR(yaml_array_param_map, real_vec_vec_t)
@@ -336,24 +1079,283 @@ KHASH_MAP_INIT_STR(yaml_array_param_map, real_vec_vec_t)
 // parameter/setting names are unique.
 KHASH_SET_INIT_STR(yaml_name_set);
 
+// The values of an enumerated parameter read from a file, which is mapped into
+// memory so its values are never copied (see map_column_file below).
+typedef struct mapped_column_t {
+  const char *path;  // the path given in the YAML file
+  const sw_real_t *values;
+  size_t size;       // number of values
+  void *map;         // the mapped file
+  size_t map_length; // the length of the mapped file
+} mapped_column_t;
+
+// A hash table whose keys are C strings and whose values are mapped columns.
+KHASH_MAP_INIT_STR(yaml_column_map, mapped_column_t)
+
 // This type stores data parsed from YAML.
 typedef struct yaml_data_t {
   sw_settings_t *settings;
-  khash_t(yaml_param_map) *fixed_input, *lattice_input, *enumerated_input;
+  khash_t(yaml_param_map) *fixed_input, *lattice_input, *enumerated_input,
+                          *sampled_input;
   khash_t(yaml_array_param_map) *fixed_array_input, *lattice_array_input,
                                 *enumerated_array_input;
+  khash_t(yaml_column_map) *enumerated_columns;
   khash_t(yaml_name_set) *setting_names;
   khash_t(yaml_name_set) *param_names;
-  size_t num_enumerated_inputs;
+  // storage for names of settings and parameters and for the values of array
+  // parameters
+  arena_t *arena;
+  size_t num_enumerated_inputs, num_sampled_inputs;
   int error_code;
   const char *error_message;
 } yaml_data_t;
 
-// This frees any resources allocated for the yaml data struct.
-static void free_yaml_data(yaml_data_t data) {
-  // Destroy parsed scalars.
-  {
-    real_vec_t values;
+// Enumerated parameters can read their values from files containing NumPy
+// arrays (.npy files) or raw binary values of type sw_real_t (any other file).
+// Either way, the file is mapped into memory, so it's not read until its
+// values are needed, and its pages are shared by all processes that map it.
+
+// Returns the expected NumPy type descriptor for sw_real_t values (defined
+// with the NumPy archive writer below).
+static void npy_descr(char type, size_t size, char descr[32]);
+
+// The header of a .npy file, which describes the array it contains.
+typedef struct npy_header_t {
+  char descr[32];     // NumPy type descriptor of the array's elements
+  bool fortran_order; // true if the array's elements are in Fortran order
+  int rank;           // number of dimensions (0, 1, or 2; 3 for more)
+  size_t shape[2];    // extents of the first two dimensions
+  size_t offset;      // offset of the array's data within the file
+} npy_header_t;
+
+// Parses the header of the .npy file with the given contents, storing it in
+// *header. Returns an error message if the header can't be parsed, or NULL if
+// it can.
+static const char *read_npy_header(const unsigned char *map, size_t map_length,
+                                   npy_header_t *header) {
+  if ((map_length < 10) || memcmp(map, "\x93NUMPY", 6))
+    return "is not a NumPy (.npy) file";
+  size_t header_length = (size_t)map[8] | ((size_t)map[9] << 8);
+  size_t header_offset = 10;
+  if (map[6] >= 2) { // versions 2 and 3 have 4-byte header lengths
+    if (map_length < 12) return "is not a NumPy (.npy) file";
+    header_length |= ((size_t)map[10] << 16) | ((size_t)map[11] << 24);
+    header_offset = 12;
+  }
+  if (header_offset + header_length > map_length)
+    return "has a truncated header";
+  *header = (npy_header_t){.offset = header_offset + header_length};
+
+  // Copy the header so we can parse it as a C string.
+  char *text = malloc(header_length + 1);
+  memcpy(text, map + header_offset, header_length);
+  text[header_length] = '\0';
+  const char *message = NULL;
+  const char *descr_value = strstr(text, "'descr':");
+  const char *order_value = strstr(text, "'fortran_order':");
+  const char *shape_value = strstr(text, "'shape':");
+  size_t descr_length = 0;
+  if (descr_value) {
+    descr_value += strlen("'descr':");
+    while (*descr_value == ' ') ++descr_value;
+    if (*descr_value == '\'') {
+      ++descr_value;
+      while (descr_value[descr_length] &&
+             (descr_value[descr_length] != '\''))
+        ++descr_length;
+    }
+  }
+  if (!descr_value || (descr_length == 0) || (descr_length >= 32) ||
+      (descr_value[descr_length] != '\'') || !shape_value) {
+    message = "has an invalid header";
+  } else {
+    memcpy(header->descr, descr_value, descr_length);
+    header->descr[descr_length] = '\0';
+    if (order_value) {
+      order_value += strlen("'fortran_order':");
+      while (*order_value == ' ') ++order_value;
+      header->fortran_order = !strncmp(order_value, "True", 4);
+    }
+
+    // The shape is a tuple of integers, with a trailing comma if it has only
+    // one.
+    shape_value += strlen("'shape':");
+    while (*shape_value == ' ') ++shape_value;
+    if (*shape_value != '(') message = "has an invalid shape";
+    const char *p = shape_value + 1;
+    while (!message) {
+      while (*p == ' ') ++p;
+      if (*p == ')') break;
+      char *end;
+      unsigned long long n = strtoull(p, &end, 10);
+      if (end == p) {
+        message = "has an invalid shape";
+      } else {
+        if (header->rank < 2) header->shape[header->rank] = (size_t)n;
+        if (header->rank < 3) ++header->rank;
+        p = end;
+        while (*p == ' ') ++p;
+        if (*p == ',') ++p;
+        else if (*p != ')') message = "has an invalid shape";
+      }
+    }
+  }
+  free(text);
+  return message;
+}
+
+// Finds the offset of the data in the given mapped .npy file, storing it in
+// *offset and the number of values in *size. Returns an error message if the
+// file doesn't contain a 1D array of sw_real_t values, or NULL if it does.
+static const char *find_npy_data(const unsigned char *map, size_t map_length,
+                                 size_t *offset, size_t *size) {
+  npy_header_t header;
+  const char *message = read_npy_header(map, map_length, &header);
+  if (message) return message;
+  char descr[32];
+  npy_descr('f', sizeof(sw_real_t), descr);
+  if (strcmp(header.descr, descr)) {
+    return (sizeof(sw_real_t) == 8) ?
+      "does not contain 64-bit floating point numbers in native byte order" :
+      "does not contain 32-bit floating point numbers in native byte order";
+  } else if (header.rank != 1) {
+    return "does not contain a 1D array";
+  }
+  *offset = header.offset;
+  *size = header.shape[0];
+  if (*offset % sizeof(sw_real_t))
+    return "has misaligned data";
+  else if ((map_length - *offset) / sizeof(sw_real_t) < *size)
+    return "has fewer values than its shape indicates";
+  return NULL;
+}
+
+// Maps the file at the given path into memory (read-only), storing the
+// mapping in *map and its length in *map_length. Returns an error message (in
+// the global string pool) if the file can't be mapped, or NULL on success.
+static const char *map_file(const char *path, void **map, size_t *map_length) {
+  *map = NULL;
+  *map_length = 0;
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return new_string("The file '%s' could not be opened.", path);
+  LARGE_INTEGER file_size;
+  if (GetFileSizeEx(file, &file_size) && (file_size.QuadPart > 0)) {
+    *map_length = (size_t)file_size.QuadPart;
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping) {
+      *map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return new_string("The file '%s' could not be opened.", path);
+  struct stat file_stat;
+  if (!fstat(fd, &file_stat) && (file_stat.st_size > 0)) {
+    *map_length = (size_t)file_stat.st_size;
+    *map = mmap(NULL, *map_length, PROT_READ, MAP_SHARED, fd, 0);
+    if (*map == MAP_FAILED) *map = NULL;
+  }
+  close(fd);
+#endif
+  if (!*map)
+    return new_string("The file '%s' could not be mapped into memory (is it "
+                      "empty?)", path);
+  return NULL;
+}
+
+// Unmaps a file mapped by map_file.
+static void unmap_file(void *map, size_t map_length) {
+  if (map) {
+#ifdef _WIN32
+    UnmapViewOfFile(map);
+#else
+    munmap(map, map_length);
+#endif
+  }
+}
+
+// Unmaps a file mapped by map_column_file.
+static void unmap_column_file(mapped_column_t *column) {
+  unmap_file(column->map, column->map_length);
+  column->map = NULL;
+}
+
+// Maps the file at the given path into memory, storing its values in the given
+// column. Returns an error message (in the global string pool) if the file
+// can't be mapped or doesn't contain values of type sw_real_t, or NULL on
+// success.
+static const char *map_column_file(const char *path, mapped_column_t *column) {
+  *column = (mapped_column_t){.path = NULL};
+  const char *message = map_file(path, &column->map, &column->map_length);
+  if (message) return message;
+
+  // Find the values.
+  size_t offset = 0, size = column->map_length / sizeof(sw_real_t);
+  size_t path_len = strlen(path);
+  if ((path_len > 4) && !strcmp(path + path_len - 4, ".npy")) {
+    message = find_npy_data(column->map, column->map_length, &offset, &size);
+  } else if (column->map_length % sizeof(sw_real_t)) {
+    message = (sizeof(sw_real_t) == 8) ?
+      "does not contain a whole number of 64-bit floating point numbers" :
+      "does not contain a whole number of 32-bit floating point numbers";
+  }
+  if (message) {
+    unmap_column_file(column);
+    return new_string("The file '%s' %s.", path, message);
+  }
+  column->values = (const sw_real_t*)((const char*)column->map + offset);
+  column->size = size;
+  return NULL;
+}
+
+// Returns a newly allocated copy of the given path of a file named in the
+// given YAML file, prefixed by the YAML file's directory if it's relative.
+static char *input_file_path(const char *yaml_file, const char *path) {
+  const char *dir_end = strrchr(yaml_file, '/');
+#ifdef _WIN32
+  const char *backslash = strrchr(yaml_file, '\\');
+  if (backslash > dir_end) dir_end = backslash;
+  bool absolute = (path[0] == '/') || (path[0] == '\\') ||
+                  (path[0] && (path[1] == ':'));
+#else
+  bool absolute = (path[0] == '/');
+#endif
+  size_t dir_len = (dir_end && !absolute) ?
+                   (size_t)(dir_end + 1 - yaml_file) : 0;
+  char *full_path = malloc(dir_len + strlen(path) + 1);
+  memcpy(full_path, yaml_file, dir_len);
+  strcpy(full_path + dir_len, path);
+  return full_path;
+}
+
+// Returns a container for parsed YAML data without any parameters.
+static yaml_data_t new_yaml_data(void) {
+  yaml_data_t data = {.error_code = 0};
+  data.fixed_input = kh_init(yaml_param_map);
+  data.lattice_input = kh_init(yaml_param_map);
+  data.enumerated_input = kh_init(yaml_param_map);
+  data.sampled_input = kh_init(yaml_param_map);
+  data.fixed_array_input = kh_init(yaml_array_param_map);
+  data.lattice_array_input = kh_init(yaml_array_param_map);
+  data.enumerated_array_input = kh_init(yaml_array_param_map);
+  data.enumerated_columns = kh_init(yaml_column_map);
+  data.setting_names = kh_init(yaml_name_set);
+  data.param_names = kh_init(yaml_name_set);
+  data.arena = arena_new();
+  return data;
+}
+
+// This frees any resources allocated for the yaml data struct.
+static void free_yaml_data(yaml_data_t data) {
+  // Destroy parsed scalars.
+  {
+    real_vec_t values;
     kh_foreach_value(data.fixed_input, values,
       kv_destroy(values);
     );
@@ -363,27 +1365,34 @@ static void free_yaml_data(yaml_data_t data) {
     kh_foreach_value(data.enumerated_input, values,
       kv_destroy(values);
     );
+    kh_foreach_value(data.sampled_input, values,
+      kv_destroy(values);
+    );
   }
   kh_destroy(yaml_param_map, data.fixed_input);
   kh_destroy(yaml_param_map, data.lattice_input);
   kh_destroy(yaml_param_map, data.enumerated_input);
+  kh_destroy(yaml_param_map, data.sampled_input);
 
-  // Destroy parsed arrays.
+  // Unmap enumerated parameters read from files.
+  {
+    mapped_column_t column;
+    kh_foreach_value(data.enumerated_columns, column,
+      unmap_column_file(&column);
+    );
+  }
+  kh_destroy(yaml_column_map, data.enumerated_columns);
+
+  // Destroy lists of parsed arrays. The arrays' values live in the arena.
   {
     real_vec_vec_t values;
     kh_foreach_value(data.fixed_array_input, values,
-      for (size_t i = 0; i < kv_size(values); ++i)
-        kv_destroy(kv_A(values, i));
       kv_destroy(values);
     );
     kh_foreach_value(data.lattice_array_input, values,
-      for (size_t i = 0; i < kv_size(values); ++i)
-        kv_destroy(kv_A(values, i));
       kv_destroy(values);
     );
     kh_foreach_value(data.enumerated_array_input, values,
-      for (size_t i = 0; i < kv_size(values); ++i)
-        kv_destroy(kv_A(values, i));
       kv_destroy(values);
     );
   }
@@ -393,12 +1402,21 @@ static void free_yaml_data(yaml_data_t data) {
 
   kh_destroy(yaml_name_set, data.setting_names);
   kh_destroy(yaml_name_set, data.param_names);
+  arena_free(data.arena);
 
   if (data.settings) sw_settings_free(data.settings);
 }
 
+// Methods for drawing the members of a sampled ensemble from the hypercube
+// spanned by the ranges of its parameters.
+typedef enum sampling_method_t {
+  LATIN_HYPERCUBE_SAMPLING, // randomized Latin hypercube (the default)
+  SOBOL_SAMPLING            // Sobol low-discrepancy sequence
+} sampling_method_t;
+
 // This type keeps track of the state of the YAML parser.
 typedef struct parser_state_t {
+  const char *yaml_file; // for finding files relative to it
   const char *settings_block;
   bool parsing_settings;
   const char *current_setting;
@@ -409,11 +1427,27 @@ typedef struct parser_state_t {
   bool parsing_fixed_params;
   bool parsing_lattice_params;
   bool parsing_enumerated_params;
+  bool parsing_sampled_params;
   bool parsing_input_sequence;
   bool parsing_input_array_sequence;
 
   bool found_input;
   const char *current_param;
+
+  // values of the array currently being parsed, which are moved to the arena
+  // when its sequence ends
+  real_vec_t array_values;
+
+  // values of enumerated parameters parsed ahead of libyaml (see
+  // prescan_enumerated_lists below)
+  real_vec_vec_t prescanned_lists;
+
+  // options for sampled parameters, and the option whose value is expected
+  // next (or NULL)
+  sampling_method_t sampling_method;
+  size_t num_samples;
+  uint64_t sampling_seed;
+  const char *current_sampling_option;
 } parser_state_t;
 
 // Returns true if the given input parameter name is valid, false otherwise,
@@ -451,6 +1485,339 @@ static bool is_valid_input_name(const char *name, bool is_array_value) {
   return true;
 }
 
+// Moves the values of the array just parsed for the current parameter into
+// the arena, storing them as the last array in the parameter's list of arrays
+// within the given table (if the parameter is there).
+static void store_parsed_array(parser_state_t *state, yaml_data_t *data,
+                               khash_t(yaml_array_param_map) *array_input) {
+  khiter_t iter = kh_get(yaml_array_param_map, array_input,
+                         state->current_param);
+  if (iter != kh_end(array_input)) {
+    real_vec_vec_t arrays = kh_value(array_input, iter);
+    size_t size = kv_size(state->array_values);
+    real_vec_t array = {.n = size, .m = size};
+    if (size > 0) {
+      array.a = arena_alloc(data->arena, sizeof(sw_real_t) * size);
+      memcpy(array.a, state->array_values.a, sizeof(sw_real_t) * size);
+    }
+    kv_A(arrays, kv_size(arrays)-1) = array;
+  }
+  kv_size(state->array_values) = 0;
+}
+
+// Returns true if the given name within a sampled block is that of a sampling
+// option rather than a parameter.
+static bool is_sampling_option(const char *name) {
+  return (!strcmp(name, "samples") || !strcmp(name, "method") ||
+          !strcmp(name, "seed"));
+}
+
+// Handles the name or value of an option in a sampled block.
+static void handle_sampling_option(const char *value, parser_state_t *state,
+                                   yaml_data_t *data) {
+  const char *option = state->current_sampling_option;
+  if (!option) { // this is the option's name
+    if (!strcmp(value, "samples")) state->current_sampling_option = "samples";
+    else if (!strcmp(value, "method")) state->current_sampling_option = "method";
+    else state->current_sampling_option = "seed";
+    return;
+  }
+  state->current_sampling_option = NULL;
+  if (!strcmp(option, "method")) {
+    if (!strcmp(value, "latin_hypercube")) {
+      state->sampling_method = LATIN_HYPERCUBE_SAMPLING;
+    } else if (!strcmp(value, "sobol")) {
+      state->sampling_method = SOBOL_SAMPLING;
+    } else {
+      data->error_code = SW_INVALID_PARAM_VALUE;
+      data->error_message = new_string(
+          "Invalid sampling method: %s (must be latin_hypercube or sobol)",
+          value);
+    }
+  } else { // samples or seed: a non-negative integer
+    char *endp;
+    unsigned long long n = strtoull(value, &endp, 10);
+    if ((endp == value) || (*endp != '\0') || (value[0] == '-')) {
+      data->error_code = SW_INVALID_PARAM_VALUE;
+      data->error_message = new_string(
+          "Invalid value for sampling option %s: %s", option, value);
+    } else if (!strcmp(option, "samples")) {
+      state->num_samples = (size_t)n;
+    } else {
+      state->sampling_seed = (uint64_t)n;
+    }
+  }
+}
+
+// libyaml produces an event for every value in a sequence, so the long lists of
+// values typical of enumerated parameters dominate the time spent parsing
+// large input files. We parse flow sequences of plain numbers in enumerated
+// blocks ourselves before the text reaches libyaml, replacing each sequence
+// with an empty one tagged with the index of its parsed values, e.g.
+// "!sw_prescanned_3 []".
+
+// tag prefix for sequences whose values have been parsed ahead of time
+#define PRESCANNED_TAG "!sw_prescanned_"
+
+// lists shorter than this are left to libyaml
+#define PRESCAN_MIN_VALUES 64
+
+// Parses the number in text[0, length), which contains only digits, signs,
+// decimal points, and exponent markers, storing exactly what strtod produces
+// for it in *value. Returns false if the text isn't a number. Decimal numbers
+// whose significands and exponents are small enough to be represented exactly
+// are computed with a single (correctly rounded) multiplication or division by
+// a power of 10, and all others are handed to strtod.
+static bool parse_number(const char *text, size_t length, double *value) {
+  static const double powers_of_10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const char *p = text, *end = text + length;
+  bool negative = (*p == '-');
+  if ((*p == '-') || (*p == '+')) ++p;
+
+  // significand
+  uint64_t significand = 0;
+  int num_digits = 0, exponent = 0;
+  for (; (p < end) && isdigit((unsigned char)*p); ++p, ++num_digits)
+    significand = 10 * significand + (uint64_t)(*p - '0');
+  if ((p < end) && (*p == '.')) {
+    for (++p; (p < end) && isdigit((unsigned char)*p); ++p, ++num_digits) {
+      significand = 10 * significand + (uint64_t)(*p - '0');
+      --exponent;
+    }
+  }
+  if (num_digits == 0) return false;
+
+  // exponent
+  if ((p < end) && ((*p == 'e') || (*p == 'E'))) {
+    ++p;
+    bool negative_exponent = ((p < end) && (*p == '-'));
+    if ((p < end) && ((*p == '-') || (*p == '+'))) ++p;
+    if ((p == end) || !isdigit((unsigned char)*p)) return false;
+    int e = 0;
+    for (; (p < end) && isdigit((unsigned char)*p); ++p)
+      if (e < 100000) e = 10 * e + (*p - '0');
+    exponent += (negative_exponent) ? -e : e;
+  }
+  if (p != end) return false;
+
+  if ((num_digits <= 15) && (exponent >= -22) && (exponent <= 22)) {
+    *value = (double)significand;
+    *value = (exponent < 0) ? *value / powers_of_10[-exponent]
+                            : *value * powers_of_10[exponent];
+    if (negative) *value = -*value;
+  } else {
+    *value = strtod(text, NULL);
+  }
+  return true;
+}
+
+// Parses the flow sequence of plain numbers beginning with the '[' at text[0]
+// into the given (empty) vector, returning the length of the sequence in the
+// text, or 0 (leaving the vector empty) if it's not such a sequence.
+static size_t scan_number_list(const char *text, real_vec_t *values) {
+  const char *p = text + 1;
+  while (true) {
+    while ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')) ++p;
+    const char *token = p;
+    while (isdigit((unsigned char)*p) || (*p == '+') || (*p == '-') ||
+           (*p == '.') || (*p == 'e') || (*p == 'E')) ++p;
+    double value;
+    if ((p == token) || !parse_number(token, (size_t)(p - token), &value))
+      break;
+    kv_push(sw_real_t, *values, (sw_real_t)value);
+    while ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')) ++p;
+    if (*p == ']') return (size_t)(p + 1 - text);
+    if (*p != ',') break;
+    ++p;
+  }
+  kv_size(*values) = 0;
+  return 0;
+}
+
+// Returns true if a line of YAML text has only blanks or a comment at the given
+// position.
+static bool is_line_end(const char *p) {
+  while ((*p == ' ') || (*p == '\t')) ++p;
+  return ((*p == '\0') || (*p == '\n') || (*p == '\r') || (*p == '#'));
+}
+
+// Parses long lists of values for parameters in enumerated blocks within the
+// given (NUL-terminated) YAML text, appending them to the given vector of
+// lists and replacing their sequences in the text with tagged empty ones as
+// described above. The text is compacted in place.
+static void prescan_enumerated_lists(char *text, real_vec_vec_t *lists) {
+  long block_indent = -1; // indentation of the enumerated block (if any)
+  const char *line = text;
+  char *out = text; // where unchanged text is copied
+  while (*line) {
+    const char *p = line;
+    while (*p == ' ') ++p;
+    long indent = (long)(p - line);
+    if (!is_line_end(p)) {
+      if (indent <= block_indent) block_indent = -1; // end of block
+      if (!strncmp(p, "enumerated:", 11) && is_line_end(p + 11)) {
+        block_indent = indent;
+      } else if (block_indent >= 0) {
+        // Look for a list of values following "name:".
+        const char *q = p;
+        while (*q && !strchr(":#\"'[{\n", *q)) ++q;
+        if (*q == ':') {
+          ++q;
+          while ((*q == ' ') || (*q == '\t')) ++q;
+          if (*q == '[') {
+            real_vec_t values;
+            kv_init(values);
+            size_t length = scan_number_list(q, &values);
+            if (kv_size(values) >= PRESCAN_MIN_VALUES) {
+              // Copy the line up to the list, followed by the tagged sequence.
+              memmove(out, line, (size_t)(q - line));
+              out += q - line;
+              out += sprintf(out, PRESCANNED_TAG "%zu []", kv_size(*lists));
+              kv_push(real_vec_t, *lists, values);
+              line = p = q + length;
+            } else {
+              kv_destroy(values);
+            }
+          }
+        }
+      }
+    }
+
+    // Copy the rest of the line.
+    const char *next_line = strchr(p, '\n');
+    next_line = (next_line) ? next_line + 1 : p + strlen(p);
+    memmove(out, line, (size_t)(next_line - line));
+    out += next_line - line;
+    line = next_line;
+  }
+  *out = '\0';
+}
+
+// Reads the contents of the given file into a NUL-terminated buffer, storing
+// the number of bytes read in *length and returning NULL if the file can't be
+// read.
+static char *read_file(FILE *file, size_t *length) {
+  size_t size = 0, capacity = 4096;
+  char *text = malloc(capacity);
+  while (text) {
+    size += fread(text + size, 1, capacity - 1 - size, file);
+    if (size < capacity - 1) break;
+    capacity *= 2;
+    char *new_text = realloc(text, capacity);
+    if (!new_text) free(text);
+    text = new_text;
+  }
+  if (text) {
+    if (ferror(file)) {
+      free(text);
+      return NULL;
+    }
+    text[size] = '\0';
+    *length = size;
+  }
+  return text;
+}
+
+// Maps the file with the given path (relative to the YAML file's directory, if
+// not absolute) containing the values of the current input parameter.
+static void handle_column_file(const char *path, parser_state_t *state,
+                               yaml_data_t *data) {
+  if (!state->parsing_enumerated_params || state->parsing_input_sequence) {
+    data->error_code = SW_INVALID_PARAM_VALUE;
+    data->error_message = new_string(
+        "Input parameter %s: only enumerated parameters can be read from "
+        "files.", state->current_param);
+    return;
+  }
+  if (strstr(state->current_param, "log10(") == state->current_param) {
+    data->error_code = SW_INVALID_PARAM_VALUE;
+    data->error_message = new_string(
+        "Input parameter %s: logarithmic values can't be read from files.",
+        state->current_param);
+    return;
+  }
+
+  mapped_column_t column;
+  char *full_path = input_file_path(state->yaml_file, path);
+  const char *message = map_column_file(full_path, &column);
+  free(full_path);
+  if (message) {
+    data->error_code = SW_INVALID_INPUT_FILE;
+    data->error_message = message;
+    return;
+  }
+  column.path = dup_yaml_string(data->arena, path);
+  int ret;
+  khiter_t iter = kh_put(yaml_column_map, data->enumerated_columns,
+                         state->current_param, &ret);
+  assert(ret == 1);
+  kh_value(data->enumerated_columns, iter) = column;
+}
+
+// Appends the given values of the current input parameter to the array being
+// parsed (for array input), or to the list of values with the parameter's name.
+static void append_param_values(parser_state_t *state, yaml_data_t *data,
+                                const sw_real_t *values, size_t num_values) {
+  // If we're parsing array input, append these values to it.
+  if ((state->parsing_input_sequence &&
+        state->parsing_fixed_params) ||
+      (state->parsing_input_array_sequence)) {
+    khash_t(yaml_array_param_map) *array_input;
+    if (state->parsing_fixed_params) {
+      array_input = data->fixed_array_input;
+    } else if (state->parsing_lattice_params) {
+      array_input = data->lattice_array_input;
+    } else {
+      assert(state->parsing_enumerated_params);
+      array_input = data->enumerated_array_input;
+    }
+    khiter_t iter = kh_get(yaml_array_param_map, array_input,
+        state->current_param);
+    if (iter == kh_end(array_input)) { // name not yet encountered
+      // Create an array of arrays containing one empty array.
+      real_vec_vec_t arrays;
+      kv_init(arrays);
+      real_vec_t array;
+      kv_init(array);
+      kv_push(real_vec_t, arrays, array);
+
+      // Add it to the array parameter map.
+      int ret;
+      iter = kh_put(yaml_array_param_map, array_input,
+          state->current_param, &ret);
+      assert(ret == 1);
+      kh_value(array_input, iter) = arrays;
+    }
+    // Append these values to the array being parsed, which becomes the
+    // last array in the list of arrays for this input.
+    append_values(&state->array_values, values, num_values);
+  } else { // not in the middle of an array sequence
+    // Otherwise, append the values to the list of inputs with this name.
+    khash_t(yaml_param_map) *input;
+    if (state->parsing_fixed_params) {
+      input = data->fixed_input;
+    } else if (state->parsing_lattice_params) {
+      input = data->lattice_input;
+    } else if (state->parsing_enumerated_params) {
+      input = data->enumerated_input;
+    } else {
+      assert(state->parsing_sampled_params);
+      input = data->sampled_input;
+    }
+    khiter_t iter = kh_get(yaml_param_map, input, state->current_param);
+    if (iter == kh_end(input)) { // name not yet encountered
+      int ret;
+      iter = kh_put(yaml_param_map, input, state->current_param, &ret);
+      assert(ret == 1);
+      kv_init(kh_value(input, iter));
+    }
+    append_values(&kh_value(input, iter), values, num_values);
+  }
+}
+
 // Handles a YAML event, populating our data instance.
 static void handle_yaml_event(yaml_event_t *event,
                               parser_state_t* state,
@@ -478,7 +1845,7 @@ static void handle_yaml_event(yaml_event_t *event,
 
         // Set the current setting name and add it to our set of tracked
         // names.
-        state->current_setting = dup_yaml_string(value);
+        state->current_setting = dup_yaml_string(data->arena, value);
         int ret;
         iter = kh_put(yaml_name_set, data->setting_names,
             state->current_setting, &ret);
@@ -496,17 +1863,24 @@ static void handle_yaml_event(yaml_event_t *event,
     } else if (state->parsing_input) {
       if (!state->parsing_fixed_params &&
           !state->parsing_lattice_params &&
-          !state->parsing_enumerated_params) {
+          !state->parsing_enumerated_params &&
+          !state->parsing_sampled_params) {
         if (!strcmp(value, "fixed")) {
           state->parsing_fixed_params = true;
         } else if (!strcmp(value, "lattice")) {
           state->parsing_lattice_params = true;
         } else if (!strcmp(value, "enumerated")) {
           state->parsing_enumerated_params = true;
+        } else if (!strcmp(value, "sampled")) {
+          state->parsing_sampled_params = true;
         } else {
           data->error_code = SW_INVALID_PARAM_TYPE;
           data->error_message = new_string("Invalid parameter type: %s", value);
         }
+      } else if (state->parsing_sampled_params && !state->current_param &&
+                 (state->current_sampling_option ||
+                  is_sampling_option(value))) {
+        handle_sampling_option(value, state, data);
       } else { // handle input name/value
         if (!state->current_param) { // parse the input parameter name
                                      // Have we seen this parameter name before?
@@ -528,11 +1902,16 @@ static void handle_yaml_event(yaml_event_t *event,
 
           // Set the current parameter name and add it to our set of tracked
           // names.
-          state->current_param = dup_yaml_string(value);
+          state->current_param = dup_yaml_string(data->arena, value);
           int ret;
           iter = kh_put(yaml_name_set, data->param_names,
               state->current_param, &ret);
           assert(ret == 1);
+        } else if (event->data.scalar.tag &&
+                   !strcmp((const char*)event->data.scalar.tag, "!file")) {
+          // The value is the name of a file containing the parameter's values.
+          handle_column_file(value, state, data);
+          state->current_param = NULL;
         } else { // we have an input name; parse its value
           // Try to interpret the value as a real number.
           char *endp;
@@ -544,65 +1923,8 @@ static void handle_yaml_event(yaml_event_t *event,
                 state->current_param, value);
             return;
           } else { // valid real value
-            // If we're parsing array input, append this value to it.
-            if ((state->parsing_input_sequence &&
-                  state->parsing_fixed_params) ||
-                (state->parsing_input_array_sequence)) {
-              khash_t(yaml_array_param_map) *array_input;
-              if (state->parsing_fixed_params) {
-                array_input = data->fixed_array_input;
-              } else if (state->parsing_lattice_params) {
-                array_input = data->lattice_array_input;
-              } else {
-                assert(state->parsing_enumerated_params);
-                array_input = data->enumerated_array_input;
-              }
-              khiter_t iter = kh_get(yaml_array_param_map, array_input,
-                  state->current_param);
-              if (iter == kh_end(array_input)) { // name not yet encountered
-                // Create an array of arrays containing one empty array.
-                real_vec_vec_t arrays;
-                kv_init(arrays);
-                real_vec_t array;
-                kv_init(array);
-                kv_push(real_vec_t, arrays, array);
-
-                // Add it to the array parameter map.
-                int ret;
-                iter = kh_put(yaml_array_param_map, array_input,
-                    state->current_param, &ret);
-                assert(ret == 1);
-                kh_value(array_input, iter) = arrays;
-              }
-              // Append this value to the last array in the list of arrays for
-              // this input.
-              real_vec_vec_t arrays = kh_value(array_input, iter);
-              size_t index = kv_size(arrays)-1;
-              real_vec_t last_array = kv_A(arrays, index);
-              kv_push(sw_real_t, last_array, real_value);
-              kv_A(arrays, index) = last_array;
-              kh_value(array_input, iter) = arrays;
-            } else { // not in the middle of an array sequence
-              // Otherwise, append the value to the list of inputs with this name.
-              khash_t(yaml_param_map) *input;
-              if (state->parsing_fixed_params) {
-                input = data->fixed_input;
-              } else if (state->parsing_lattice_params) {
-                input = data->lattice_input;
-              } else {
-                assert(state->parsing_enumerated_params);
-                input = data->enumerated_input;
-              }
-              khiter_t iter = kh_get(yaml_param_map, input, state->current_param);
-              if (iter == kh_end(input)) { // name not yet encountered
-                int ret;
-                iter = kh_put(yaml_param_map, input, state->current_param, &ret);
-                assert(ret == 1);
-                kv_init(kh_value(input, iter));
-              }
-              kv_push(sw_real_t, kh_value(input, iter), real_value);
-            }
-          } // valid value
+            append_param_values(state, data, &real_value, 1);
+          }
 
           // Clear the current input if we're parsing a scalar.
           if (!state->parsing_input_sequence) {
@@ -625,6 +1947,7 @@ static void handle_yaml_event(yaml_event_t *event,
     if (state->parsing_fixed_params) state->parsing_fixed_params = false;
     else if (state->parsing_lattice_params) state->parsing_lattice_params = false;
     else if (state->parsing_enumerated_params) state->parsing_enumerated_params = false;
+    else if (state->parsing_sampled_params) state->parsing_sampled_params = false;
     else if (state->parsing_settings) state->parsing_settings = false;
     else if (state->parsing_input) state->parsing_input = false;
     else if (state->parsing_unrecognized) state->parsing_unrecognized = false;
@@ -636,10 +1959,11 @@ static void handle_yaml_event(yaml_event_t *event,
             "Cannot parse a sequence of array sequences for input parameter %s",
             state->current_param);
       } else if (state->parsing_input_sequence) {
-        if (state->parsing_fixed_params) {
+        if (state->parsing_fixed_params || state->parsing_sampled_params) {
           data->error_code = SW_INVALID_PARAM_VALUE;
           data->error_message = new_string(
-              "Cannot parse a sequence of arrays for fixed input parameter %s",
+              "Cannot parse a sequence of arrays for %s input parameter %s",
+              (state->parsing_fixed_params) ? "fixed" : "sampled",
               state->current_param);
           return;
         }
@@ -664,11 +1988,32 @@ static void handle_yaml_event(yaml_event_t *event,
       } else if (state->parsing_input) {
         state->parsing_input_sequence = true;
       }
+
+      // If this sequence's values were parsed ahead of time, append them all
+      // now.
+      const char *tag = (const char*)event->data.sequence_start.tag;
+      if (!data->error_code && tag && state->current_param &&
+          !strncmp(tag, PRESCANNED_TAG, strlen(PRESCANNED_TAG))) {
+        size_t index = (size_t)strtoull(tag + strlen(PRESCANNED_TAG), NULL, 10);
+        if (index < kv_size(state->prescanned_lists)) {
+          real_vec_t *values = &kv_A(state->prescanned_lists, index);
+          append_param_values(state, data, values->a, kv_size(*values));
+          kv_destroy(*values);
+          kv_init(*values);
+        }
+      }
     } else if (event->type == YAML_SEQUENCE_END_EVENT) {
       if (state->parsing_input_array_sequence) {
+        store_parsed_array(state, data, (state->parsing_lattice_params) ?
+                           data->lattice_array_input :
+                           data->enumerated_array_input);
         state->parsing_input_array_sequence = false;
       } else { // sequence of scalar or array inputs
-        if (!state->parsing_fixed_params) {
+        if (state->parsing_fixed_params) {
+          store_parsed_array(state, data, data->fixed_array_input);
+        }
+        // (Ranges of sampled parameters are checked when they're sampled.)
+        if (!state->parsing_fixed_params && !state->parsing_sampled_params) {
           // Make sure the sequence has more than one value, whatever it is.
           khash_t(yaml_param_map) *input;
           khash_t(yaml_array_param_map) *array_input;
@@ -709,13 +2054,16 @@ static void handle_yaml_event(yaml_event_t *event,
   }
 }
 
-// Postprocess non-array input parameters.
+// Postprocess non-array input parameters, expanding 3-element lists if
+// expand_ranges is true.
 static void postprocess_params(khash_t(yaml_param_map) **params,
+                               bool expand_ranges,
+                               arena_t *arena,
                                int *error_code,
                                const char **error_message) {
   // Expand any relevant 3-parameter lists.
   for (khiter_t iter = kh_begin(*params);
-      iter != kh_end(*params); ++iter) {
+      expand_ranges && (iter != kh_end(*params)); ++iter) {
 
     if (!kh_exist(*params, iter)) continue;
 
@@ -778,7 +2126,8 @@ static void postprocess_params(khash_t(yaml_param_map) **params,
 
     int ret;
     khiter_t r_iter = kh_put(yaml_param_map, renamed_input,
-                             dup_yaml_string(new_param_name), &ret);
+                             dup_yaml_string(arena, new_param_name),
+                             &ret);
     assert(ret == 1);
     kh_value(renamed_input, r_iter) = values;
 
@@ -791,8 +2140,10 @@ static void postprocess_params(khash_t(yaml_param_map) **params,
   *params = renamed_input;
 }
 
-// Postprocess array input parameters.
-static void postprocess_array_params(khash_t(yaml_array_param_map) *params) {
+// Postprocess array input parameters, storing expanded arrays in the given
+// arena.
+static void postprocess_array_params(khash_t(yaml_array_param_map) *params,
+                                     arena_t *arena) {
   // Expand any relevant 3-parameter lists.
   for (khiter_t iter = kh_begin(params); iter != kh_end(params); ++iter) {
 
@@ -825,22 +2176,20 @@ static void postprocess_array_params(khash_t(yaml_array_param_map) *params) {
       if (size > 0 && size != INT_MAX) {
         real_vec_vec_t expanded_array_values;
         kv_init(expanded_array_values);
+        kv_resize(real_vec_t, expanded_array_values, size);
         for (size_t i = 0; i < size; ++i) {
-          real_vec_t expanded_values;
-          kv_init(expanded_values);
+          real_vec_t expanded_values = {.n = len, .m = len};
+          expanded_values.a = arena_alloc(arena, sizeof(sw_real_t) * len);
           for (size_t l = 0; l < len; ++l) {
             sw_real_t val0 = kv_A(array_val0, l),
                       val2 = kv_A(array_val2, l);
-            kv_push(sw_real_t, expanded_values, val0 + i * val2);
+            kv_A(expanded_values, l) = val0 + i * val2;
           }
           kv_push(real_vec_t, expanded_array_values, expanded_values);
         }
         kh_value(params, iter) = expanded_array_values;
 
-        // Destroy the unprocessed array.
-        for (size_t i = 0; i < kv_size(array_values); ++i) {
-          kv_destroy(kv_A(array_values, i));
-        }
+        // Destroy the list of unprocessed arrays.
         kv_destroy(array_values);
       }
     }
@@ -849,6 +2198,7 @@ static void postprocess_array_params(khash_t(yaml_array_param_map) *params) {
 
 static void validate_enumerated_params(khash_t(yaml_param_map) *params,
                                        khash_t(yaml_array_param_map) *array_params,
+                                       khash_t(yaml_column_map) *columns,
                                        size_t *num_inputs,
                                        int *error_code,
                                        const char **error_message) {
@@ -892,26 +2242,251 @@ static void validate_enumerated_params(khash_t(yaml_param_map) *params,
         " than %s (%ld)", name, kv_size(values), first_name, *num_inputs);
     }
   }
+  // Enumerated parameters read from files
+  for (khiter_t iter = kh_begin(columns); iter != kh_end(columns); ++iter) {
+
+    if (!kh_exist(columns, iter)) continue;
+
+    const char *name = kh_key(columns, iter);
+    mapped_column_t column = kh_value(columns, iter);
+
+    if (*num_inputs == 0) {
+      *num_inputs = column.size;
+      first_name = name;
+    } else if (*num_inputs != column.size) {
+      *error_code = SW_INVALID_ENUMERATION;
+      *error_message = new_string(
+        "Invalid enumeration: Parameter %s has a different number of values (%ld)"
+        " than %s (%ld)", name, column.size, first_name, *num_inputs);
+    }
+  }
 }
 
-// Parses a YAML file, returning the results.
-static yaml_data_t parse_yaml(FILE* file, const char* settings_block) {
-  yaml_data_t data = {.error_code = 0};
+// Returns the next number in the SplitMix64 sequence with the given state.
+static uint64_t splitmix64(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
 
-  data.fixed_input = kh_init(yaml_param_map);
-  data.lattice_input = kh_init(yaml_param_map);
-  data.enumerated_input = kh_init(yaml_param_map);
-  data.fixed_array_input = kh_init(yaml_array_param_map);
-  data.lattice_array_input = kh_init(yaml_array_param_map);
-  data.enumerated_array_input = kh_init(yaml_array_param_map);
-  data.setting_names = kh_init(yaml_name_set);
-  data.param_names = kh_init(yaml_name_set);
+// Returns a pseudorandom number uniformly distributed in [0, 1).
+static double uniform_random(uint64_t *state) {
+  return (double)(splitmix64(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Fills points[d*num_samples + i] with coordinate d of point i of a Latin
+// hypercube in the unit cube: each coordinate falls into each of num_samples
+// equal intervals exactly once, at a random position within it. The points
+// are determined by the given seed.
+static void latin_hypercube(size_t num_dims, size_t num_samples,
+                            uint64_t seed, double *points) {
+  uint64_t state = seed;
+  size_t *perm = malloc(sizeof(size_t) * num_samples);
+  for (size_t d = 0; d < num_dims; ++d) {
+    for (size_t i = 0; i < num_samples; ++i)
+      perm[i] = i;
+    for (size_t i = num_samples - 1; i > 0; --i) { // Fisher-Yates shuffle
+      size_t j = (size_t)(uniform_random(&state) * (double)(i + 1));
+      if (j > i) j = i;
+      size_t p = perm[i];
+      perm[i] = perm[j];
+      perm[j] = p;
+    }
+    for (size_t i = 0; i < num_samples; ++i)
+      points[d*num_samples + i] =
+        ((double)perm[i] + uniform_random(&state)) / (double)num_samples;
+  }
+  free(perm);
+}
+
+// Sobol sequences of up to this many dimensions can be generated.
+#define SOBOL_MAX_DIMENSION 64
+
+// Degree of the highest-degree polynomial below.
+#define SOBOL_MAX_DEGREE 9
+
+// Primitive polynomials and initial direction numbers for dimensions 2 and up
+// of the Sobol sequence, from S. Joe and F. Y. Kuo, "Constructing Sobol
+// sequences with better two-dimensional projections", SIAM J. Sci. Comput. 30,
+// 2635-2654 (2008) (the new-joe-kuo-6.21201 data). Bit k of a polynomial is
+// its coefficient of x^k.
+static const unsigned short sobol_polynomials_[SOBOL_MAX_DIMENSION-1] = {
+  3, 7, 11, 13, 19, 25, 37, 41, 47, 55,
+  59, 61, 67, 91, 97, 103, 109, 115, 131, 137,
+  143, 145, 157, 167, 171, 185, 191, 193, 203, 211,
+  213, 229, 239, 241, 247, 253, 285, 299, 301, 333,
+  351, 355, 357, 361, 369, 391, 397, 425, 451, 463,
+  487, 501, 529, 539, 545, 557, 563, 601, 607, 617,
+  623, 631, 637
+};
+
+static const unsigned short
+sobol_m_[SOBOL_MAX_DIMENSION-1][SOBOL_MAX_DEGREE] = {
+  {1}, {1, 3}, {1, 3, 1}, {1, 1, 1}, {1, 1, 3, 3}, {1, 3, 5, 13},
+  {1, 1, 5, 5, 17}, {1, 1, 5, 5, 5}, {1, 1, 7, 11, 19}, {1, 1, 5, 1, 1},
+  {1, 1, 1, 3, 11}, {1, 3, 5, 5, 31}, {1, 3, 3, 9, 7, 49},
+  {1, 1, 1, 15, 21, 21}, {1, 3, 1, 13, 27, 49}, {1, 1, 1, 15, 7, 5},
+  {1, 3, 1, 15, 13, 25}, {1, 1, 5, 5, 19, 61}, {1, 3, 7, 11, 23, 15, 103},
+  {1, 3, 7, 13, 13, 15, 69}, {1, 1, 3, 13, 7, 35, 63}, {1, 3, 5, 9, 1, 25, 53},
+  {1, 3, 1, 13, 9, 35, 107}, {1, 3, 1, 5, 27, 61, 31},
+  {1, 1, 5, 11, 19, 41, 61}, {1, 3, 5, 3, 3, 13, 69}, {1, 1, 7, 13, 1, 19, 1},
+  {1, 3, 7, 5, 13, 19, 59}, {1, 1, 3, 9, 25, 29, 41}, {1, 3, 5, 13, 23, 1, 55},
+  {1, 3, 7, 3, 13, 59, 17}, {1, 3, 1, 3, 5, 53, 69}, {1, 1, 5, 5, 23, 33, 13},
+  {1, 1, 7, 7, 1, 61, 123}, {1, 1, 7, 9, 13, 61, 49}, {1, 3, 3, 5, 3, 55, 33},
+  {1, 3, 1, 15, 31, 13, 49, 245}, {1, 3, 5, 15, 31, 59, 63, 97},
+  {1, 3, 1, 11, 11, 11, 77, 249}, {1, 3, 1, 11, 27, 43, 71, 9},
+  {1, 1, 7, 15, 21, 11, 81, 45}, {1, 3, 7, 3, 25, 31, 65, 79},
+  {1, 3, 1, 1, 19, 11, 3, 205}, {1, 1, 5, 9, 19, 21, 29, 157},
+  {1, 3, 7, 11, 1, 33, 89, 185}, {1, 3, 3, 3, 15, 9, 79, 71},
+  {1, 3, 7, 11, 15, 39, 119, 27}, {1, 1, 3, 1, 11, 31, 97, 225},
+  {1, 1, 1, 3, 23, 43, 57, 177}, {1, 3, 7, 7, 17, 17, 37, 71},
+  {1, 3, 1, 5, 27, 63, 123, 213}, {1, 1, 3, 5, 11, 43, 53, 133},
+  {1, 3, 5, 5, 29, 17, 47, 173, 479}, {1, 3, 3, 11, 3, 1, 109, 9, 69},
+  {1, 1, 1, 5, 17, 39, 23, 5, 343}, {1, 3, 1, 5, 25, 15, 31, 103, 499},
+  {1, 1, 1, 11, 11, 17, 63, 105, 183}, {1, 1, 5, 11, 9, 29, 97, 231, 363},
+  {1, 1, 5, 15, 19, 45, 41, 7, 383}, {1, 3, 7, 7, 31, 19, 83, 137, 221},
+  {1, 1, 1, 3, 23, 15, 111, 223, 83}, {1, 1, 5, 13, 31, 15, 55, 25, 161},
+  {1, 1, 3, 13, 25, 47, 39, 87, 257}
+};
+
+// Fills points[d*num_samples + i] with coordinate d of point i of the Sobol
+// sequence in num_dims (<= SOBOL_MAX_DIMENSION) dimensions, for fewer than
+// 2^32 points. The sequence starts at the origin, and its points are most
+// evenly distributed when num_samples is a power of 2.
+static void sobol_sequence(size_t num_dims, size_t num_samples,
+                           double *points) {
+  for (size_t d = 0; d < num_dims; ++d) {
+    // Compute the dimension's direction numbers v[k] = m[k] / 2^(k+1),
+    // scaled by 2^32.
+    uint32_t v[32];
+    if (d == 0) {
+      for (int k = 0; k < 32; ++k)
+        v[k] = (uint32_t)1 << (31 - k);
+    } else {
+      unsigned int p = sobol_polynomials_[d-1];
+      int s = 0;
+      while (p >> (s + 1)) ++s; // degree of the polynomial
+      for (int k = 0; k < s; ++k)
+        v[k] = (uint32_t)sobol_m_[d-1][k] << (31 - k);
+      for (int k = s; k < 32; ++k) {
+        v[k] = v[k-s] ^ (v[k-s] >> s);
+        for (int i = 1; i < s; ++i)
+          if ((p >> (s - i)) & 1) v[k] ^= v[k-i];
+      }
+    }
+
+    // Generate the points in Gray code order, changing one direction number
+    // for each.
+    uint32_t x = 0;
+    for (size_t i = 0; i < num_samples; ++i) {
+      points[d*num_samples + i] = (double)x * (1.0 / 4294967296.0);
+      int c = 0;
+      while ((i >> c) & 1) ++c;
+      if (c < 32) x ^= v[c];
+    }
+  }
+}
+
+static int compare_names(const void *a, const void *b) {
+  return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+// Replaces the [low, high] range of each of the given sampled parameters with
+// its values for the given number of samples, drawn with the given method (and
+// seed, for random methods). Parameters are assigned dimensions of the sample
+// space in alphabetical order of their names, so the same input always
+// produces the same ensemble.
+static void sample_params(khash_t(yaml_param_map) *params,
+                          sampling_method_t method, size_t num_samples,
+                          uint64_t seed, int *error_code,
+                          const char **error_message) {
+  size_t num_dims = kh_size(params);
+  if (num_dims == 0) return;
+  if (num_samples == 0) {
+    *error_code = SW_INVALID_PARAM_VALUE;
+    *error_message = "The sampled block must give a positive number of samples.";
+    return;
+  }
+  if (method == SOBOL_SAMPLING) {
+    if (num_dims > SOBOL_MAX_DIMENSION) {
+      *error_code = SW_INVALID_PARAM_VALUE;
+      *error_message = new_string("Sobol sampling supports at most %d "
+                                  "parameters (%zu given).",
+                                  SOBOL_MAX_DIMENSION, num_dims);
+      return;
+    }
+    if ((uint64_t)num_samples > UINT32_MAX) {
+      *error_code = SW_ENSEMBLE_TOO_LARGE;
+      *error_message = "Sobol sampling supports fewer than 2^32 samples.";
+      return;
+    }
+  }
+
+  const char **names = malloc(sizeof(const char*) * num_dims);
+  size_t d = 0;
+  for (khiter_t iter = kh_begin(params); iter != kh_end(params); ++iter) {
+    if (!kh_exist(params, iter)) continue;
+    const char *name = kh_key(params, iter);
+    real_vec_t range = kh_value(params, iter);
+    if ((kv_size(range) != 2) || !(kv_A(range, 0) < kv_A(range, 1))) {
+      *error_code = SW_INVALID_PARAM_VALUE;
+      *error_message = new_string("Sampled parameter %s must be given a range "
+                                  "[low, high] with low < high.", name);
+      free(names);
+      return;
+    }
+    names[d++] = name;
+  }
+  qsort(names, num_dims, sizeof(const char*), compare_names);
+
+  double *points = malloc(sizeof(double) * num_dims * num_samples);
+  if (!points) {
+    *error_code = SW_ENSEMBLE_TOO_LARGE;
+    *error_message = new_string("The given sampled ensemble (%zu samples) is "
+                                "too large to fit into memory.", num_samples);
+    free(names);
+    return;
+  }
+  if (method == SOBOL_SAMPLING)
+    sobol_sequence(num_dims, num_samples, points);
+  else
+    latin_hypercube(num_dims, num_samples, seed, points);
+
+  for (d = 0; d < num_dims; ++d) {
+    khiter_t iter = kh_get(yaml_param_map, params, names[d]);
+    real_vec_t range = kh_value(params, iter);
+    double low = kv_A(range, 0), high = kv_A(range, 1);
+    real_vec_t values;
+    kv_init(values);
+    kv_resize(sw_real_t, values, num_samples);
+    for (size_t i = 0; i < num_samples; ++i)
+      kv_push(sw_real_t, values,
+              (sw_real_t)(low + (high - low) * points[d*num_samples + i]));
+    kv_destroy(range);
+    kh_value(params, iter) = values;
+  }
+  free(points);
+  free(names);
+}
+
+// Parses the (NUL-terminated) text of the given YAML file, returning the
+// results. The text is modified in the process.
+static yaml_data_t parse_yaml(char *text, const char *yaml_file,
+                              const char* settings_block) {
+  yaml_data_t data = new_yaml_data();
+
+  parser_state_t state = {.yaml_file = yaml_file,
+                          .settings_block = settings_block};
+
+  // Parse long lists of enumerated values ourselves.
+  prescan_enumerated_lists(text, &state.prescanned_lists);
 
   yaml_parser_t parser;
   yaml_parser_initialize(&parser);
-  yaml_parser_set_input_file(&parser, file);
+  yaml_parser_set_input_string(&parser, (const unsigned char*)text,
+                               strlen(text));
 
-  parser_state_t state = {.settings_block = settings_block};
   yaml_event_type_t event_type;
   do {
     yaml_event_t event;
@@ -920,7 +2495,7 @@ static yaml_data_t parse_yaml(FILE* file, const char* settings_block) {
     yaml_parser_parse(&parser, &event);
     if (parser.error != YAML_NO_ERROR) {
       data.error_code = SW_INVALID_YAML;
-      data.error_message = dup_string(parser.problem);
+      data.error_message = new_string("%s", parser.problem);
       yaml_event_delete(&event);
       yaml_parser_delete(&parser);
       goto return_data;
@@ -951,31 +2526,50 @@ static yaml_data_t parse_yaml(FILE* file, const char* settings_block) {
   // Did we find an input block?
   if (!state.found_input) {
     data.error_code = SW_INPUT_NOT_FOUND;
-    data.error_message = new_string("The input block was not found.");
+    data.error_message = "The input block was not found.";
     goto return_data;
   }
 
   // Postprocess input parameters, expanding 3-element lists if needed, and
   // applying log10 operations.
-  postprocess_params(&(data.lattice_input), &(data.error_code),
-                     &(data.error_message));
+  postprocess_params(&(data.lattice_input), true, data.arena,
+                     &(data.error_code), &(data.error_message));
   if (!data.error_code) {
-    postprocess_params(&(data.enumerated_input), &(data.error_code),
-                       &(data.error_message));
+    postprocess_params(&(data.enumerated_input), true, data.arena,
+                       &(data.error_code), &(data.error_message));
   }
 
   // Expand 3-element lists for array-valued parameters.
   if (!data.error_code) {
-    postprocess_array_params(data.lattice_array_input);
-    postprocess_array_params(data.enumerated_array_input);
+    postprocess_array_params(data.lattice_array_input, data.arena);
+    postprocess_array_params(data.enumerated_array_input, data.arena);
   }
 
   // Make sure enumerated parameters are all of the same length.
   validate_enumerated_params(data.enumerated_input, data.enumerated_array_input,
+                             data.enumerated_columns,
                              &(data.num_enumerated_inputs), &(data.error_code),
                              &(data.error_message));
 
+  // Draw samples for sampled parameters, then apply log10 operations to them
+  // (so a log10 parameter's values are distributed uniformly in its
+  // logarithm).
+  if (!data.error_code && (kh_size(data.sampled_input) > 0)) {
+    sample_params(data.sampled_input, state.sampling_method,
+                  state.num_samples, state.sampling_seed, &(data.error_code),
+                  &(data.error_message));
+    if (!data.error_code) {
+      postprocess_params(&(data.sampled_input), false, data.arena,
+                         &(data.error_code), &(data.error_message));
+      data.num_sampled_inputs = state.num_samples;
+    }
+  }
+
 return_data:
+  for (size_t i = 0; i < kv_size(state.prescanned_lists); ++i)
+    kv_destroy(kv_A(state.prescanned_lists, i));
+  kv_destroy(state.prescanned_lists);
+  kv_destroy(state.array_values);
   return data;
 }
 
@@ -983,186 +2577,601 @@ return_data:
 //                          Ensemble construction
 //------------------------------------------------------------------------
 
-static void assign_fixed_params(yaml_data_t yaml_data, sw_input_t *input) {
-  const char *name;
-  real_vec_t values;
-  kh_foreach(yaml_data.fixed_input, name, values,
-    if (kv_size(values) == 1) {
-      sw_input_set(input, name, kv_A(values, 0));
-    }
-  );
-}
-
-static void assign_fixed_array_params(yaml_data_t yaml_data, sw_input_t *input) {
-  const char *name;
-  real_vec_vec_t array_values;
-  kh_foreach(yaml_data.fixed_array_input, name, array_values,
-    if (kv_size(array_values) == 1) {
-      sw_input_set_array(input, name, kv_A(array_values, 0));
-    }
-  );
-}
-
-static void assign_lattice_params(yaml_data_t yaml_data, size_t l, const size_t m,
-                                  sw_input_t *input) {
-  assert(m < 8);
-  size_t N = 0;
-  real_vec_t values[7];
-  const char *name[7]={NULL,NULL,NULL,NULL,NULL,NULL,NULL};
-  for (khiter_t iter = kh_begin(yaml_data.lattice_input);
-      iter != kh_end(yaml_data.lattice_input) && N<m; ++iter) {
-    if (!kh_exist(yaml_data.lattice_input, iter)) continue;
-    real_vec_t value = kh_value(yaml_data.lattice_input, iter);
-    if (kv_size(value) > 1) {
-      name[N] = kh_key(yaml_data.lattice_input, iter);
-      values[N] = value;
-      ++N;
-    }
-  }
-  real_vec_vec_t array_values[7];
-  const char *array_name[7]={NULL,NULL,NULL,NULL,NULL,NULL,NULL};
-  for (khiter_t iter = kh_begin(yaml_data.array_input);
-      iter != kh_end(yaml_data.lattice_array_input) && N<m; ++iter) {
-    if (!kh_exist(yaml_data.lattice_array_input, iter)) continue;
-    real_vec_vec_t value = kh_value(yaml_data.lattice_array_input, iter);
-    if (kv_size(value) > 1) {
-      array_name[N] = kh_key(yaml_data.lattice_array_input, iter);
-      array_values[N] = value;
-      ++N;
-    }
-  }
-  size_t n[7];
-  for (size_t i = 0; i < m; ++i) {
-    n[i] = (name[i]) ? kv_size(values[i]) : kv_size(array_values[i]);
-  };
-  size_t j[7];
-  {
-    size_t L = l;
-    for (int i = (int)m-1; i > 0; --i) {
-      j[i] = L % n[i];
-      L /= n[i];
-    }
-    j[0] = L;
-  }
-  for  (int i=0; i<m; ++i) {
-    if (name[i])
-      sw_input_set(input, name[i], kv_A(values[i], j[i]));
-    else
-      sw_input_set_array(input, array_name[i], kv_A(array_values[i], j[i]));
-  }
-}
-
-static void assign_enumerated_params(yaml_data_t yaml_data, size_t enum_index,
-                                     sw_input_t *input) {
-  const char *name;
-  real_vec_t values;
-  kh_foreach(yaml_data.enumerated_input, name, values,
-    sw_input_set(input, name, kv_A(values, enum_index));
-  );
-
-  real_vec_vec_t array_values;
-  kh_foreach(yaml_data.enumerated_array_input, name, array_values,
-    sw_input_set_array(input, name, kv_A(array_values, enum_index));
-  );
-}
-
 // This type contains results from building an ensemble.
 typedef struct sw_build_result_t {
-  const char *yaml_file;
   size_t num_inputs;
-  sw_input_t *inputs;
+  size_t num_lattice_params, num_sampled_params, num_enumerated_params;
   int error_code;
   const char *error_message;
 } sw_build_result_t;
 
-// Generates an array of inputs for an ensemble.
+// Multiplies *n by m, returning false (and leaving *n alone) if the product
+// can't be represented by a size_t.
+static bool mul_size(size_t *n, size_t m) {
+  if ((m > 0) && (*n > SIZE_MAX / m)) return false;
+  *n *= m;
+  return true;
+}
+
+// Sizes up the ensemble described by the given YAML data. Members aren't
+// generated here: their inputs are assigned on demand from the YAML data as
+// the ensemble is traversed.
 static sw_build_result_t build_ensemble(yaml_data_t yaml_data) {
   sw_build_result_t result = {.num_inputs = 1, .error_code = SW_SUCCESS};
 
   // Count up the number of inputs and parameters.
+  bool overflow = false;
 
   // Fixed parameters
   size_t num_fixed_params = kh_size(yaml_data.fixed_input) +
                             kh_size(yaml_data.fixed_array_input);
 
   // Lattice parameters
-  size_t num_lattice_params = 0;
   {
     real_vec_t values;
     kh_foreach_value(yaml_data.lattice_input, values,
-      result.num_inputs *= kv_size(values);
-      ++num_lattice_params;
+      if (!mul_size(&result.num_inputs, kv_size(values))) overflow = true;
+      ++result.num_lattice_params;
     );
   }
   {
     real_vec_vec_t array_values;
     kh_foreach_value(yaml_data.lattice_array_input, array_values,
-      result.num_inputs *= kv_size(array_values);
-      ++num_lattice_params;
+      if (!mul_size(&result.num_inputs, kv_size(array_values))) overflow = true;
+      ++result.num_lattice_params;
     );
   }
 
+  // Sampled parameters
+  result.num_sampled_params = kh_size(yaml_data.sampled_input);
+  if (result.num_sampled_params > 0) {
+    if (!mul_size(&result.num_inputs, yaml_data.num_sampled_inputs))
+      overflow = true;
+  }
+
   // Enumerated parameters
-  size_t num_enumerated_params = kh_size(yaml_data.enumerated_input) +
-                                 kh_size(yaml_data.enumerated_array_input);
-  if (num_enumerated_params > 0) {
-    result.num_inputs *= yaml_data.num_enumerated_inputs;
+  result.num_enumerated_params = kh_size(yaml_data.enumerated_input) +
+                                 kh_size(yaml_data.enumerated_array_input) +
+                                 kh_size(yaml_data.enumerated_columns);
+  if (result.num_enumerated_params > 0) {
+    if (!mul_size(&result.num_inputs, yaml_data.num_enumerated_inputs))
+      overflow = true;
   }
 
-  size_t num_params = num_fixed_params + num_lattice_params +
-                      num_enumerated_params;
+  size_t num_params = num_fixed_params + result.num_lattice_params +
+                      result.num_sampled_params + result.num_enumerated_params;
   if (num_params == 0) {
     result.error_code = SW_EMPTY_ENSEMBLE;
-    result.error_message = new_string("Ensemble has no members!");
-    return result;
-  } else if (num_lattice_params > 7) {
-    result.error_code = SW_TOO_MANY_LATTICE_PARAMS;
-    result.error_message =
-      new_string("The given lattice ensemble has %d traversed parameters "
-                 "(must be <= 7).", num_lattice_params);
-    return result;
-  }
-
-  // Try to allocate storage for inputs.
-  result.inputs = malloc(sizeof(sw_input_t) * result.num_inputs);
-  if (!result.inputs) {
+    result.error_message = "Ensemble has no members!";
+  } else if (overflow) {
     result.error_code = SW_ENSEMBLE_TOO_LARGE;
     result.error_message =
-      new_string("The given lattice ensemble (%zd members) is too large to fit "
-                 "into memory.\n", result.num_inputs);
-    return result;
-  }
-
-  // Build a list of inputs corresponding to all the traversed parameters.
-  for (size_t l = 0; l < result.num_inputs; ++l) {
-    result.inputs[l].params = kh_init(param_map);
-    result.inputs[l].array_params = kh_init(array_param_map);
-    assign_fixed_params(yaml_data, &result.inputs[l]);
-    assign_fixed_array_params(yaml_data, &result.inputs[l]);
-    if (num_lattice_params > 0) {
-      size_t lattice_index = l;
-      if (yaml_data.num_enumerated_inputs > 0) {
-        lattice_index = l / yaml_data.num_enumerated_inputs;
-      }
-      assign_lattice_params(yaml_data, lattice_index, num_lattice_params,
-                            &result.inputs[l]);
-    }
-    if (num_enumerated_params > 0) {
-      size_t enum_index = l % yaml_data.num_enumerated_inputs;
-      assign_enumerated_params(yaml_data, enum_index, &result.inputs[l]);
-    }
+      "The given ensemble has too many members to be indexed.";
   }
 
   return result;
 }
 
-//------------------------------------------------------------------------
-//                      Ensemble loading and writing
-//------------------------------------------------------------------------
-
-sw_ensemble_result_t sw_load_ensemble(const char* yaml_file,
-                                      const char* settings_block) {
-  sw_ensemble_result_t result = {.error_code = 0};
+// Assigns handles to the input parameters in the given YAML data, in the
+// order fixed, lattice, sampled, enumerated, and records how each parameter's
+// values vary across ensemble members. Lattice parameters span the outer
+// product of their values, with the last one varying fastest, and each lattice
+// point is repeated for every sample, which in turn is repeated for every set
+// of enumerated values.
+static void build_input_layout(yaml_data_t yaml_data, input_layout_t *layout) {
+  input_layout_init(layout);
+  const char *name;
+  real_vec_t values;
+  real_vec_vec_t array_values;
+
+  // Fixed parameters assume a single value.
+  kh_foreach(yaml_data.fixed_input, name, values,
+    if (kv_size(values) == 1) add_input_param(layout, name, values.a, 1, 1);
+  );
+  kh_foreach(yaml_data.fixed_array_input, name, array_values,
+    if (kv_size(array_values) == 1)
+      add_input_array_param(layout, name, array_values.a, 1, 1);
+  );
+
+  // Enumerated parameters vary fastest, followed by sampled parameters.
+  size_t num_enumerated = 1;
+  if (yaml_data.num_enumerated_inputs > 0)
+    num_enumerated = yaml_data.num_enumerated_inputs;
+  size_t num_samples = 1;
+  if (kh_size(yaml_data.sampled_input) > 0)
+    num_samples = yaml_data.num_sampled_inputs;
+
+  // Lattice parameters are traversed in order, scalars first. Each one is an
+  // axis of any number of lattice dimensions, and a member's position along
+  // it is a digit of the member's index in a mixed-radix number system.
+  size_t max_lattice = kh_size(yaml_data.lattice_input) +
+                       kh_size(yaml_data.lattice_array_input);
+  size_t *counts = malloc(sizeof(size_t) * (max_lattice + 1));
+  size_t *strides = malloc(sizeof(size_t) * (max_lattice + 1));
+  size_t num_lattice = 0;
+  kh_foreach_value(yaml_data.lattice_input, values,
+    if (kv_size(values) > 1)
+      counts[num_lattice++] = kv_size(values);
+  );
+  size_t num_lattice_scalars = num_lattice;
+  kh_foreach_value(yaml_data.lattice_array_input, array_values,
+    if (kv_size(array_values) > 1)
+      counts[num_lattice++] = kv_size(array_values);
+  );
+  size_t stride = num_enumerated * num_samples;
+  for (int i = (int)num_lattice-1; i >= 0; --i) {
+    strides[i] = stride;
+    stride *= counts[i];
+  }
+  size_t i = 0;
+  kh_foreach(yaml_data.lattice_input, name, values,
+    if ((kv_size(values) > 1) && (i < num_lattice_scalars)) {
+      add_input_param(layout, name, values.a, strides[i], counts[i]);
+      ++i;
+    }
+  );
+  kh_foreach(yaml_data.lattice_array_input, name, array_values,
+    if ((kv_size(array_values) > 1) && (i < num_lattice)) {
+      add_input_array_param(layout, name, array_values.a, strides[i],
+                            counts[i]);
+      ++i;
+    }
+  );
+  free(counts);
+  free(strides);
+
+  kh_foreach(yaml_data.sampled_input, name, values,
+    add_input_param(layout, name, values.a, num_enumerated, num_samples);
+  );
+
+  kh_foreach(yaml_data.enumerated_input, name, values,
+    add_input_param(layout, name, values.a, 1, num_enumerated);
+  );
+  kh_foreach(yaml_data.enumerated_array_input, name, array_values,
+    add_input_array_param(layout, name, array_values.a, 1, num_enumerated);
+  );
+  mapped_column_t column;
+  kh_foreach(yaml_data.enumerated_columns, name, column,
+    add_input_param(layout, name, column.values, 1, num_enumerated);
+  );
+}
+
+//------------------------------------------------------------------------
+//                          Parsed ensemble cache
+//------------------------------------------------------------------------
+
+// If the SKYWALKER_CACHE_DIR environment variable names a directory,
+// Skywalker stores the input layout built for each YAML file it loads there
+// in a compact binary file, and reads this file instead of parsing the YAML
+// file when the same input is loaded again. Each cache file is named for a hash
+// of the YAML text and the settings block (and of Skywalker's version and
+// precision), so editing the YAML file simply produces a new cache file. The
+// hash only names the file: a cache file also stores the YAML text and settings
+// block it was built from, and it's used only if these match exactly.
+//
+// A cache file stores the settings and the input parameters in the order of
+// the input layout, so a cached ensemble's members are identical to those of a
+// parsed one. Enumerated parameters read from files are stored as their paths
+// and mapped again when the cache is read. Any problem with a cache file means
+// the YAML file is parsed as usual.
+
+// version of the cache file format
+#define CACHE_FORMAT_VERSION 2
+
+// This type is the header of a cache file.
+typedef struct cache_header_t {
+  char magic[8];        // "SWCACHE"
+  uint64_t hash;        // hash of the YAML text, as described above
+  uint64_t text_length; // length of the YAML text (which follows the header)
+  uint64_t num_inputs;  // number of ensemble members
+} cache_header_t;
+
+// Returns the FNV-1a hash of the given bytes, continuing from the given hash.
+static uint64_t fnv1a_hash(uint64_t hash, const void *bytes, size_t length) {
+  const unsigned char *b = bytes;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= b[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// Returns the newly allocated path of the cache file for the given YAML text
+// and settings block, storing its header (without the number of members) in
+// *header, or returns NULL if caching is disabled.
+static char *cache_file_path(const char *text, size_t text_length,
+                             const char *settings_block,
+                             cache_header_t *header) {
+  const char *cache_dir = getenv("SKYWALKER_CACHE_DIR");
+  if (!cache_dir || !cache_dir[0]) return NULL;
+
+  const uint16_t one = 1;
+  const int key[] = {CACHE_FORMAT_VERSION, SKYWALKER_MAJOR_VERSION,
+                     SKYWALKER_MINOR_VERSION, SKYWALKER_PATCH_VERSION,
+                     (int)sizeof(sw_real_t), *(const char*)&one};
+  uint64_t hash = fnv1a_hash(0xcbf29ce484222325ULL, key, sizeof(key));
+  hash = fnv1a_hash(hash, text, text_length + 1);
+  if (settings_block)
+    hash = fnv1a_hash(hash, settings_block, strlen(settings_block));
+  *header = (cache_header_t){.magic = "SWCACHE", .hash = hash,
+                             .text_length = text_length};
+
+  size_t length = strlen(cache_dir) + 32;
+  char *path = malloc(length);
+  snprintf(path, length, "%s/%016llx.swcache", cache_dir,
+           (unsigned long long)hash);
+  return path;
+}
+
+// This type writes a cache file, keeping track of failures.
+typedef struct cache_writer_t {
+  FILE *file;
+  bool failed;
+} cache_writer_t;
+
+static void cache_write(cache_writer_t *writer, const void *data, size_t size) {
+  if (!writer->failed && (fwrite(data, 1, size, writer->file) != size))
+    writer->failed = true;
+}
+
+static void cache_write_size(cache_writer_t *writer, size_t size) {
+  uint64_t n = size;
+  cache_write(writer, &n, sizeof(uint64_t));
+}
+
+static void cache_write_string(cache_writer_t *writer, const char *s) {
+  size_t length = strlen(s);
+  cache_write_size(writer, length);
+  cache_write(writer, s, length);
+}
+
+// Writes the cache file with the given path and header for an ensemble loaded
+// from the given YAML text and settings block (possibly NULL), with the given
+// settings (possibly NULL), input layout, and enumerated parameters read from
+// files. The file is written under a temporary name and then
+// renamed, so processes loading the same input at once never read a partial
+// cache file.
+static void write_cache(const char *path, const cache_header_t *header,
+                        const char *text, const char *settings_block,
+                        const sw_settings_t *settings,
+                        const input_layout_t *layout,
+                        khash_t(yaml_column_map) *columns) {
+  size_t temp_length = strlen(path) + 32;
+  char *temp_path = malloc(temp_length);
+#ifdef _WIN32
+  snprintf(temp_path, temp_length, "%s.%lu.tmp", path,
+           (unsigned long)GetCurrentProcessId());
+#else
+  snprintf(temp_path, temp_length, "%s.%ld.tmp", path, (long)getpid());
+#endif
+  FILE *file = fopen(temp_path, "wb");
+  if (!file) {
+    free(temp_path);
+    return;
+  }
+  cache_writer_t writer = {.file = file};
+  cache_write(&writer, header, sizeof(cache_header_t));
+
+  // the input the ensemble was built from
+  cache_write(&writer, text, header->text_length);
+  cache_write_size(&writer, (settings_block) ? 1 : 0);
+  if (settings_block)
+    cache_write_string(&writer, settings_block);
+
+  // settings
+  cache_write_size(&writer, (settings) ? 1 : 0);
+  if (settings) {
+    cache_write_size(&writer, kh_size(settings->params));
+    const char *name, *value;
+    kh_foreach(settings->params, name, value,
+      cache_write_string(&writer, name);
+      cache_write_string(&writer, value);
+    );
+  }
+
+  // scalar input parameters, with the paths of those read from files
+  cache_write_size(&writer, kv_size(layout->param_info));
+  for (size_t i = 0; i < kv_size(layout->param_info); ++i) {
+    const char *name = kv_A(layout->params.names, i);
+    const input_param_t *param = &kv_A(layout->param_info, i);
+    cache_write_string(&writer, name);
+    cache_write_size(&writer, param->stride);
+    cache_write_size(&writer, param->count);
+    khiter_t iter = kh_get(yaml_column_map, columns, name);
+    if (iter != kh_end(columns)) {
+      cache_write_size(&writer, 1);
+      cache_write_string(&writer, kh_value(columns, iter).path);
+    } else {
+      cache_write_size(&writer, 0);
+      cache_write(&writer, param->values, sizeof(sw_real_t) * param->count);
+    }
+  }
+
+  // array-valued input parameters
+  cache_write_size(&writer, kv_size(layout->array_param_info));
+  for (size_t i = 0; i < kv_size(layout->array_param_info); ++i) {
+    const input_param_t *param = &kv_A(layout->array_param_info, i);
+    cache_write_string(&writer, kv_A(layout->array_params.names, i));
+    cache_write_size(&writer, param->stride);
+    cache_write_size(&writer, param->count);
+    for (size_t j = 0; j < param->count; ++j) {
+      cache_write_size(&writer, kv_size(param->arrays[j]));
+      cache_write(&writer, param->arrays[j].a,
+                  sizeof(sw_real_t) * kv_size(param->arrays[j]));
+    }
+  }
+
+  bool succeeded = !writer.failed;
+  if (fclose(file)) succeeded = false;
+  if (succeeded) succeeded = !rename(temp_path, path);
+  if (!succeeded) remove(temp_path);
+  free(temp_path);
+}
+
+// This type reads the contents of a cache file, keeping track of failures.
+typedef struct cache_reader_t {
+  const char *p, *end;
+  bool failed;
+} cache_reader_t;
+
+// Returns a pointer to the next number of bytes in the file contents, or NULL
+// if there aren't enough.
+static const void *cache_read(cache_reader_t *reader, size_t size) {
+  if (reader->failed || ((size_t)(reader->end - reader->p) < size)) {
+    reader->failed = true;
+    return NULL;
+  }
+  const void *data = reader->p;
+  reader->p += size;
+  return data;
+}
+
+static size_t cache_read_size(cache_reader_t *reader) {
+  uint64_t n = 0;
+  const void *data = cache_read(reader, sizeof(uint64_t));
+  if (data) memcpy(&n, data, sizeof(uint64_t));
+  return (size_t)n;
+}
+
+// Reads a string, copying it to the given arena.
+static const char *cache_read_string(cache_reader_t *reader, arena_t *arena) {
+  size_t length = cache_read_size(reader);
+  const char *s = cache_read(reader, length);
+  if (!s) return "";
+  char *copy = arena_alloc(arena, length + 1);
+  memcpy(copy, s, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+// Reads the given number of reals, copying them to the given arena.
+static const sw_real_t *cache_read_reals(cache_reader_t *reader, size_t n,
+                                         arena_t *arena) {
+  if (n > SIZE_MAX / sizeof(sw_real_t)) reader->failed = true;
+  const void *values = cache_read(reader, sizeof(sw_real_t) * n);
+  if (!values) return NULL;
+  sw_real_t *copy = arena_alloc(arena, sizeof(sw_real_t) * n);
+  memcpy(copy, values, sizeof(sw_real_t) * n);
+  return copy;
+}
+
+// Reads the cache file at the given path for the given YAML file, whose header
+// should match the given one, and whose input should match the given YAML text
+// and settings block (possibly NULL). On success, stores the ensemble's parameter
+// data, input layout, and number of members in *data, *layout, and
+// *num_inputs, and returns true. Otherwise returns false.
+static bool read_cache(const char *path, const char *yaml_file,
+                       const cache_header_t *expected_header,
+                       const char *text, const char *settings_block,
+                       yaml_data_t *data, input_layout_t *layout,
+                       size_t *num_inputs) {
+  FILE *file = fopen(path, "rb");
+  if (!file) return false;
+  size_t length;
+  char *contents = read_file(file, &length);
+  fclose(file);
+  if (!contents) return false;
+
+  cache_reader_t reader = {.p = contents, .end = contents + length};
+  cache_header_t header;
+  const void *header_data = cache_read(&reader, sizeof(cache_header_t));
+  if (header_data) memcpy(&header, header_data, sizeof(cache_header_t));
+  if (!header_data || memcmp(header.magic, expected_header->magic, 8) ||
+      (header.hash != expected_header->hash) ||
+      (header.text_length != expected_header->text_length)) {
+    free(contents);
+    return false;
+  }
+
+  // Make sure the file was built from this input, not just one whose hash
+  // is the same.
+  const void *cached_text = cache_read(&reader, (size_t)header.text_length);
+  bool same_input = cached_text &&
+                    !memcmp(cached_text, text, (size_t)header.text_length);
+  if (same_input) {
+    if (cache_read_size(&reader)) {
+      size_t length = cache_read_size(&reader);
+      const char *block = cache_read(&reader, length);
+      same_input = block && settings_block &&
+                   (strlen(settings_block) == length) &&
+                   !memcmp(block, settings_block, length);
+    } else {
+      same_input = !reader.failed && !settings_block;
+    }
+  }
+  if (!same_input) {
+    free(contents);
+    return false;
+  }
+  *num_inputs = (size_t)header.num_inputs;
+  *data = new_yaml_data();
+  input_layout_init(layout);
+
+  // settings
+  if (cache_read_size(&reader)) {
+    data->settings = sw_settings_new();
+    size_t num_settings = cache_read_size(&reader);
+    for (size_t i = 0; (i < num_settings) && !reader.failed; ++i) {
+      const char *name = cache_read_string(&reader, data->arena);
+      const char *value = cache_read_string(&reader, data->arena);
+      if (sw_settings_has(data->settings, name)) reader.failed = true;
+      else sw_settings_set(data->settings, name, value);
+    }
+  }
+
+  // scalar input parameters
+  size_t num_params = cache_read_size(&reader);
+  for (size_t i = 0; (i < num_params) && !reader.failed; ++i) {
+    const char *name = cache_read_string(&reader, data->arena);
+    size_t stride = cache_read_size(&reader);
+    size_t count = cache_read_size(&reader);
+    const sw_real_t *values = NULL;
+    if (cache_read_size(&reader)) { // read from a file
+      const char *column_path = cache_read_string(&reader, data->arena);
+      int ret;
+      khiter_t iter = kh_put(yaml_column_map, data->enumerated_columns, name,
+                             &ret);
+      if (reader.failed || (ret != 1)) {
+        if (ret == 1) kh_del(yaml_column_map, data->enumerated_columns, iter);
+        reader.failed = true;
+        break;
+      }
+      mapped_column_t *column = &kh_value(data->enumerated_columns, iter);
+      char *full_path = input_file_path(yaml_file, column_path);
+      const char *message = map_column_file(full_path, column);
+      free(full_path);
+      column->path = column_path;
+      if (message || (column->size != count)) reader.failed = true;
+      values = column->values;
+    } else {
+      values = cache_read_reals(&reader, count, data->arena);
+    }
+    if ((stride == 0) || (count == 0) ||
+        (kh_get(handle_map, layout->params.handles, name) !=
+         kh_end(layout->params.handles))) {
+      reader.failed = true;
+    }
+    if (!reader.failed) add_input_param(layout, name, values, stride, count);
+  }
+
+  // array-valued input parameters
+  size_t num_array_params = cache_read_size(&reader);
+  for (size_t i = 0; (i < num_array_params) && !reader.failed; ++i) {
+    const char *name = cache_read_string(&reader, data->arena);
+    size_t stride = cache_read_size(&reader);
+    size_t count = cache_read_size(&reader);
+    if ((stride == 0) || (count == 0) ||
+        (count > (size_t)(reader.end - reader.p) / sizeof(uint64_t)) ||
+        (kh_get(handle_map, layout->array_params.handles, name) !=
+         kh_end(layout->array_params.handles))) {
+      reader.failed = true;
+      break;
+    }
+    real_vec_t *arrays = arena_alloc(data->arena, sizeof(real_vec_t) * count);
+    for (size_t j = 0; j < count; ++j) {
+      size_t size = cache_read_size(&reader);
+      arrays[j].a = (sw_real_t*)cache_read_reals(&reader, size, data->arena);
+      arrays[j].n = arrays[j].m = (reader.failed) ? 0 : size;
+    }
+    if (!reader.failed) add_input_array_param(layout, name, arrays, stride,
+                                              count);
+  }
+
+  free(contents);
+  if (reader.failed || (reader.p != reader.end)) {
+    input_layout_destroy(layout);
+    free_yaml_data(*data);
+    return false;
+  }
+  return true;
+}
+
+// writes an ensemble's outputs as it's traversed (see below)
+typedef struct output_stream_t output_stream_t;
+
+// memoized outputs of an ensemble's members (see below)
+typedef struct member_memo_t member_memo_t;
+
+// ensemble type
+struct sw_ensemble_t {
+  size_t size, position;
+  // index of the first member within the full ensemble, and its size
+  size_t offset, global_size;
+#ifdef SKYWALKER_HAVE_MPI
+  // communicator for an ensemble distributed across processes
+  // (MPI_COMM_NULL if the ensemble isn't distributed)
+  MPI_Comm comm;
+#endif
+  // parsed parameter data, from which member inputs are generated
+  yaml_data_t data;
+  // handles for input parameters and output quantities
+  input_layout_t input_layout;
+  output_schema_t output_schema;
+  // views of the members' inputs and rows of output columns
+  sw_input_t *inputs;
+  sw_output_t *outputs;
+  sw_settings_t *settings; // for writing and freeing
+  // writer for streamed outputs (NULL if outputs aren't streamed)
+  output_stream_t *stream;
+  // memoized outputs of members (NULL if members aren't memoized)
+  member_memo_t *memo;
+  // batch of members for sw_ensemble_next_batch (NULL until first needed)
+  sw_batch_t *batch;
+  // error messages for the ensemble and its members, freed with it
+  string_pool_t *strings;
+  // statistics (see sw_ensemble_stats), whether traversals are timed, and
+  // the time at which the last traversal step returned a member or batch
+  // (negative if the last step ended the traversal)
+  sw_ensemble_stats_t stats;
+  bool collect_stats;
+  double step_end;
+  // if members are profiled (see sw_ensemble_profile), the handle of the
+  // quantity that records their times (-1 if they aren't), and the output of
+  // the member being processed by the driver (NULL if none)
+  sw_handle_t profile_handle;
+  sw_output_t *profiled_output;
+};
+
+// Prepares an ensemble's output stream for the next step of a traversal
+// (defined with the Python module writer below).
+static bool advance_stream(sw_ensemble_t *ensemble);
+
+// Returns the index one past the last member in the current chunk of an
+// ensemble's output stream.
+static size_t stream_chunk_end(const sw_ensemble_t *ensemble);
+
+// Fills the outputs of an ensemble's member from its memo if it's there (or
+// else makes it the member being processed), records the outputs of the
+// member being processed, and writes what's been recorded to the memo file
+// (defined with the memo below).
+static bool recall_member(sw_ensemble_t *ensemble, size_t i);
+static void memoize_pending_member(sw_ensemble_t *ensemble);
+static void flush_memo(sw_ensemble_t *ensemble);
+static void free_memo(member_memo_t *memo);
+
+//------------------------------------------------------------------------
+//                      Ensemble loading and writing
+//------------------------------------------------------------------------
+
+// Computes the offset and size of the block of an ensemble with the given
+// number of members that is assigned to the given process (rank) out of the
+// given number of processes. The first (num_members % num_ranks) processes
+// get one extra member.
+static void partition_ensemble(size_t num_members, size_t rank,
+                               size_t num_ranks, size_t *offset,
+                               size_t *size) {
+  size_t block_size = num_members / num_ranks;
+  size_t remainder = num_members % num_ranks;
+  *offset = rank * block_size + ((rank < remainder) ? rank : remainder);
+  *size = block_size + ((rank < remainder) ? 1 : 0);
+}
+
+// Loads the block of the ensemble in the given file that is assigned to the
+// given process (rank) out of the given number of processes.
+static sw_ensemble_result_t load_ensemble(const char* yaml_file,
+                                          const char* settings_block,
+                                          size_t rank, size_t num_ranks) {
+  sw_ensemble_result_t result = {.error_code = 0};
 
   // Validate inputs.
   if (settings_block && (!strcmp(settings_block, "input"))) {
@@ -1172,6 +3181,7 @@ sw_ensemble_result_t sw_load_ensemble(const char* yaml_file,
     return result;
   }
 
+  double parse_start = sw_clock();
   FILE *file = fopen(yaml_file, "r");
   if (!file) {
     result.error_code = SW_YAML_FILE_NOT_FOUND;
@@ -1179,258 +3189,3609 @@ sw_ensemble_result_t sw_load_ensemble(const char* yaml_file,
                                       yaml_file);
     return result;
   }
-
-  // Parse the YAML file, populating a data container.
-  yaml_data_t data = parse_yaml(file, settings_block);
+  size_t text_length;
+  char *text = read_file(file, &text_length);
   fclose(file);
+  if (!text) {
+    result.error_code = SW_INVALID_YAML;
+    result.error_message = new_string("The file '%s' could not be read.",
+                                      yaml_file);
+    return result;
+  }
+
+  // Read the ensemble's parameter data and input layout from the cache if
+  // we can. Otherwise, parse the YAML text, populating a data container, and
+  // build the layout from it.
+  cache_header_t cache_header;
+  char *cache_path = cache_file_path(text, text_length, settings_block,
+                                     &cache_header);
+  yaml_data_t data;
+  input_layout_t input_layout;
+  sw_build_result_t build_result = {.error_code = SW_SUCCESS};
+  bool cached = (cache_path && read_cache(cache_path, yaml_file, &cache_header,
+                                          text, settings_block,
+                                          &data, &input_layout,
+                                          &build_result.num_inputs));
+  double build_start = sw_clock();
+  if (!cached) {
+    // Parsing modifies the text, so the cache file gets a copy of the original.
+    char *original_text = NULL;
+    if (cache_path) {
+      original_text = malloc(text_length + 1);
+      memcpy(original_text, text, text_length + 1);
+    }
+    data = parse_yaml(text, yaml_file, settings_block);
+    build_start = sw_clock();
+    if (data.error_code == SW_SUCCESS) {
+      build_result = build_ensemble(data);
+      if (build_result.error_code == SW_SUCCESS) {
+        build_input_layout(data, &input_layout);
+        if (cache_path) {
+          cache_header.num_inputs = build_result.num_inputs;
+          write_cache(cache_path, &cache_header, original_text, settings_block,
+                      data.settings, &input_layout, data.enumerated_columns);
+        }
+      }
+    }
+    free(original_text);
+  }
+  free(cache_path);
+  free(text);
 
   if (data.error_code == SW_SUCCESS) {
-    sw_build_result_t build_result = build_ensemble(data);
+    sw_input_t *inputs = NULL;
+    sw_output_t *outputs = NULL;
+    size_t offset = 0, size = 0;
+    if (build_result.error_code == SW_SUCCESS) {
+      // Input values are looked up from the parsed data and output columns
+      // are allocated as quantities are registered, so all we need up front
+      // are views for this process's members.
+      partition_ensemble(build_result.num_inputs, rank, num_ranks,
+                         &offset, &size);
+      inputs = malloc(sizeof(sw_input_t) * (size + 1));
+      outputs = malloc(sizeof(sw_output_t) * (size + 1));
+      if (!inputs || !outputs) {
+        free(inputs);
+        free(outputs);
+        input_layout_destroy(&input_layout);
+        build_result.error_code = SW_ENSEMBLE_TOO_LARGE;
+        build_result.error_message =
+          new_string("The given ensemble (%zd members) is too large to fit "
+                     "into memory.", build_result.num_inputs);
+      }
+    }
     if (build_result.error_code != SW_SUCCESS) {
       result.error_code = build_result.error_code;
       result.error_message = build_result.error_message;
     } else {
       sw_ensemble_t *ensemble = malloc(sizeof(sw_ensemble_t));
-      ensemble->size = build_result.num_inputs;
+      ensemble->size = size;
       ensemble->position = 0;
-      ensemble->inputs = build_result.inputs;
-      ensemble->outputs = malloc(ensemble->size*sizeof(sw_output_t));
+      ensemble->offset = offset;
+      ensemble->global_size = build_result.num_inputs;
+#ifdef SKYWALKER_HAVE_MPI
+      ensemble->comm = MPI_COMM_NULL;
+#endif
+      ensemble->strings = string_pool_new();
+      ensemble->input_layout = input_layout;
+      ensemble->input_layout.errors = ensemble->strings;
+      output_schema_init(&ensemble->output_schema, ensemble->size);
       for (size_t i = 0; i < ensemble->size; ++i) {
-        ensemble->outputs[i].metrics = kh_init(param_map);
-        ensemble->outputs[i].array_metrics = kh_init(array_param_map);
+        inputs[i].layout = &ensemble->input_layout;
+        inputs[i].index = offset + i;
+        outputs[i].schema = &ensemble->output_schema;
+        outputs[i].index = i;
       }
+      ensemble->inputs = inputs;
+      ensemble->outputs = outputs;
       result.settings = data.settings;
       data.settings = NULL;
       ensemble->settings = result.settings;
+      ensemble->stream = NULL;
+      ensemble->memo = NULL;
+      ensemble->batch = NULL;
+      ensemble->stats = (sw_ensemble_stats_t){
+        .parse_time = build_start - parse_start,
+        .build_time = sw_clock() - build_start
+      };
+      ensemble->collect_stats = false;
+      ensemble->step_end = -1.0;
+      ensemble->profile_handle = -1;
+      ensemble->profiled_output = NULL;
+
+      // Members are profiled if the settings ask for it.
+      if (ensemble->settings &&
+          sw_settings_has(ensemble->settings, "skywalker_profile")) {
+        sw_settings_result_t profile = sw_settings_get(ensemble->settings,
+                                                       "skywalker_profile");
+        if (!strcmp(profile.value, "true"))
+          sw_ensemble_profile(ensemble);
+      }
+
+      // The ensemble takes ownership of the parsed data.
+      ensemble->data = data;
       result.ensemble = ensemble;
+      return result;
+    }
+  } else {
+    result.error_code = data.error_code;
+    result.error_message = data.error_message;
+  }
+
+  // Clean up.
+  free_yaml_data(data);
+
+  return result;
+}
+
+sw_ensemble_result_t sw_load_ensemble(const char* yaml_file,
+                                      const char* settings_block) {
+  return load_ensemble(yaml_file, settings_block, 0, 1);
+}
+
+#ifdef SKYWALKER_HAVE_MPI
+sw_ensemble_result_t sw_load_ensemble_mpi(const char *yaml_file,
+                                          const char *settings_block,
+                                          MPI_Comm comm) {
+  // Every process parses the input and builds its own block of the ensemble.
+  // Errors are caused by the input, so all processes encounter the same ones.
+  int rank, num_ranks;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &num_ranks);
+  sw_ensemble_result_t result = load_ensemble(yaml_file, settings_block,
+                                              (size_t)rank, (size_t)num_ranks);
+  if (result.error_code == SW_SUCCESS) {
+    MPI_Comm_dup(comm, &result.ensemble->comm);
+  }
+  return result;
+}
+#endif
+
+size_t sw_ensemble_size(sw_ensemble_t* ensemble) {
+  return ensemble->size;
+}
+
+size_t sw_ensemble_offset(sw_ensemble_t* ensemble) {
+  return ensemble->offset;
+}
+
+sw_handle_result_t sw_input_handle(sw_ensemble_t *ensemble, const char *name) {
+  sw_handle_result_t result = {.error_code = SW_SUCCESS};
+  result.handle = name_table_find(&ensemble->input_layout.params, name);
+  if (result.handle < 0) {
+    result.error_code = SW_PARAM_NOT_FOUND;
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "The input parameter '%s' was not found.", name);
+  }
+  return result;
+}
+
+sw_handle_result_t sw_input_array_handle(sw_ensemble_t *ensemble,
+                                         const char *name) {
+  sw_handle_result_t result = {.error_code = SW_SUCCESS};
+  result.handle = name_table_find(&ensemble->input_layout.array_params, name);
+  if (result.handle < 0) {
+    result.error_code = SW_PARAM_NOT_FOUND;
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "The input array parameter '%s' was not found.", name);
+  }
+  return result;
+}
+
+sw_handle_t sw_output_handle(sw_ensemble_t *ensemble, const char *name) {
+  return output_schema_handle(&ensemble->output_schema, name);
+}
+
+sw_handle_t sw_output_array_handle(sw_ensemble_t *ensemble, const char *name) {
+  return output_schema_array_handle(&ensemble->output_schema, name);
+}
+
+// When an ensemble collects statistics, each step of a traversal (a call to
+// sw_ensemble_next or sw_ensemble_next_batch) is timed, along with the time
+// the driver spends between steps. This function records the latter (in the
+// ensemble's statistics, and for the profiled member, if any), and returns
+// the time at which the current step begins.
+static double begin_traversal_step(sw_ensemble_t *ensemble) {
+  double now = sw_clock();
+  if (ensemble->step_end >= 0.0) {
+    double driver_time = now - ensemble->step_end;
+    if (ensemble->collect_stats)
+      ensemble->stats.driver_time += driver_time;
+    if (ensemble->profiled_output) {
+      sw_output_set_h(ensemble->profiled_output, ensemble->profile_handle,
+                      (sw_real_t)driver_time);
+      ensemble->profiled_output = NULL;
+    }
+  }
+  return now;
+}
+
+// Records the time spent in the traversal step that began at the given time,
+// which returned a member or batch if more is true.
+static void end_traversal_step(sw_ensemble_t *ensemble, double start,
+                               bool more) {
+  double now = sw_clock();
+  if (ensemble->collect_stats)
+    ensemble->stats.traversal_time += now - start;
+  ensemble->step_end = (more) ? now : -1.0;
+}
+
+// Returns true if traversals of the given ensemble are timed.
+static bool traversal_is_timed(const sw_ensemble_t *ensemble) {
+  return ensemble->collect_stats || (ensemble->profile_handle >= 0);
+}
+
+// Moves the given ensemble's traversal to its next member (see
+// sw_ensemble_next).
+static bool next_member(sw_ensemble_t *ensemble,
+                        sw_input_t **input,
+                        sw_output_t **output) {
+  // The outputs of the member returned by the last step are memoized before
+  // they're streamed.
+  if (ensemble->memo) memoize_pending_member(ensemble);
+  while (true) {
+    // A streaming ensemble writes its outputs as it goes, and can be
+    // traversed only once.
+    if (ensemble->stream && !advance_stream(ensemble)) {
+      *input = NULL;
+      *output = NULL;
+      return false;
+    }
+    if (ensemble->position >= ensemble->size) {
+      ensemble->position = 0; // reset for next traversal
+      if (ensemble->memo) flush_memo(ensemble);
+      *input = NULL;
+      *output = NULL;
+      return false;
+    }
+
+    // Memoized members are skipped.
+    size_t i = ensemble->position++;
+    if (ensemble->memo && recall_member(ensemble, i)) continue;
+    *input = &ensemble->inputs[i];
+    *output = &ensemble->outputs[i];
+    return true;
+  }
+}
+
+bool sw_ensemble_next(sw_ensemble_t *ensemble,
+                      sw_input_t **input,
+                      sw_output_t **output) {
+  if (!traversal_is_timed(ensemble))
+    return next_member(ensemble, input, output);
+  double start = begin_traversal_step(ensemble);
+  bool more = next_member(ensemble, input, output);
+  if (ensemble->profile_handle >= 0)
+    ensemble->profiled_output = *output;
+  end_traversal_step(ensemble, start, more);
+  return more;
+}
+
+bool sw_ensemble_get(sw_ensemble_t *ensemble, size_t i,
+                     sw_input_t **input, sw_output_t **output) {
+  // Members of a streaming ensemble are available only through
+  // sw_ensemble_next.
+  if ((i >= ensemble->size) || ensemble->stream) {
+    *input = NULL;
+    *output = NULL;
+    return false;
+  }
+  *input = &ensemble->inputs[i];
+  *output = &ensemble->outputs[i];
+  return true;
+}
+
+sw_ensemble_range_t sw_ensemble_range(sw_ensemble_t *ensemble,
+                                      size_t begin, size_t end) {
+  if (end > ensemble->size) end = ensemble->size;
+  if (ensemble->stream) end = 0; // see sw_ensemble_get
+  if (begin > end) begin = end;
+  return (sw_ensemble_range_t){.ensemble = ensemble, .position = begin,
+                               .end = end};
+}
+
+bool sw_ensemble_range_next(sw_ensemble_range_t *range,
+                            sw_input_t **input,
+                            sw_output_t **output) {
+  if (range->position >= range->end) {
+    *input = NULL;
+    *output = NULL;
+    return false;
+  }
+  sw_ensemble_get(range->ensemble, range->position, input, output);
+  ++range->position;
+  return true;
+}
+
+// A batch is a view of a block of consecutive members of an ensemble. The
+// values of a scalar input parameter for the batch's members are gathered
+// into an array the first time they're requested, unless they're already
+// stored contiguously. Output quantities need no such storage: consecutive
+// members have consecutive rows in the ensemble's output columns.
+struct sw_batch_t {
+  sw_ensemble_t *ensemble;
+  size_t begin, size;     // index of the first member, number of members
+  size_t capacity;        // number of members storage is allocated for
+  sw_real_t *values;      // gathered values (capacity per input parameter)
+  const sw_real_t **inputs; // values for each input parameter (NULL until
+                            // requested)
+};
+
+static void batch_free(sw_batch_t *batch) {
+  free(batch->values);
+  free(batch->inputs);
+  free(batch);
+}
+
+// Moves the given ensemble's traversal past its next batch of members (see
+// sw_ensemble_next_batch).
+static bool next_batch(sw_ensemble_t *ensemble, size_t batch_size,
+                       sw_batch_t **batch) {
+  *batch = NULL;
+  if (batch_size == 0) return false;
+
+  // Batches of a streaming ensemble don't extend past the end of a chunk, so
+  // their outputs belong to it.
+  size_t end = ensemble->size;
+  if (ensemble->stream) {
+    if (!advance_stream(ensemble)) return false;
+    if (ensemble->position < ensemble->size)
+      end = stream_chunk_end(ensemble);
+  }
+  if (ensemble->position >= ensemble->size) {
+    ensemble->position = 0; // reset for next traversal
+    return false;
+  }
+  size_t size = end - ensemble->position;
+  if (batch_size < size) size = batch_size;
+
+  sw_batch_t *b = ensemble->batch;
+  size_t num_params = kv_size(ensemble->input_layout.param_info);
+  if (!b) {
+    b = malloc(sizeof(sw_batch_t));
+    b->ensemble = ensemble;
+    b->capacity = 0;
+    b->values = NULL;
+    b->inputs = malloc(sizeof(sw_real_t*) * (num_params + 1));
+    ensemble->batch = b;
+  }
+  if (size > b->capacity) {
+    free(b->values);
+    b->values = malloc(sizeof(sw_real_t) * (size * num_params + 1));
+    b->capacity = size;
+  }
+  for (size_t p = 0; p < num_params; ++p)
+    b->inputs[p] = NULL;
+  b->begin = ensemble->position;
+  b->size = size;
+  ensemble->position += size;
+  *batch = b;
+  return true;
+}
+
+bool sw_ensemble_next_batch(sw_ensemble_t *ensemble, size_t batch_size,
+                            sw_batch_t **batch) {
+  if (!traversal_is_timed(ensemble))
+    return next_batch(ensemble, batch_size, batch);
+  double start = begin_traversal_step(ensemble);
+  bool more = next_batch(ensemble, batch_size, batch);
+  end_traversal_step(ensemble, start, more);
+  return more;
+}
+
+size_t sw_batch_size(sw_batch_t *batch) {
+  return batch->size;
+}
+
+size_t sw_batch_begin(sw_batch_t *batch) {
+  return batch->begin;
+}
+
+// Returns the values of the scalar input parameter with the given (valid)
+// handle for the members of the given batch.
+static const sw_real_t *batch_input_values(sw_batch_t *batch,
+                                           sw_handle_t handle) {
+  if (!batch->inputs[handle]) {
+    const input_param_t *param =
+      &kv_A(batch->ensemble->input_layout.param_info, handle);
+    size_t first = batch->ensemble->inputs[batch->begin].index;
+    size_t k = param_index(param, first);
+    if ((param->stride == 1) && (k + batch->size <= param->count)) {
+      batch->inputs[handle] = &param->values[k];
+    } else {
+      sw_real_t *values = &batch->values[handle * batch->capacity];
+      gather_param_values(param, first, batch->size, values);
+      batch->inputs[handle] = values;
+    }
+  }
+  return batch->inputs[handle];
+}
+
+sw_input_array_result_t sw_batch_input_get(sw_batch_t *batch,
+                                           const char *name) {
+  sw_input_array_result_t result = {.error_code = SW_SUCCESS};
+  input_layout_t *layout = &batch->ensemble->input_layout;
+  sw_handle_t handle = name_table_find(&layout->params, name);
+  if (handle >= 0) {
+    result.values = (sw_real_t*)batch_input_values(batch, handle);
+    result.size = batch->size;
+  } else {
+    result.error_code = SW_PARAM_NOT_FOUND;
+    result.error_message =
+      pool_format(layout->errors, "The input parameter '%s' was not found.",
+                  name);
+  }
+  return result;
+}
+
+sw_input_array_result_t sw_batch_input_get_h(sw_batch_t *batch,
+                                             sw_handle_t handle) {
+  sw_input_array_result_t result = {.error_code = SW_SUCCESS};
+  input_layout_t *layout = &batch->ensemble->input_layout;
+  if (name_table_has(&layout->params, handle)) {
+    result.values = (sw_real_t*)batch_input_values(batch, handle);
+    result.size = batch->size;
+  } else {
+    result.error_code = SW_PARAM_NOT_FOUND;
+    result.error_message =
+      pool_format(layout->errors, "Invalid input parameter handle: %d",
+                  handle);
+  }
+  return result;
+}
+
+sw_real_t *sw_batch_output_reserve_h(sw_batch_t *batch, sw_handle_t handle) {
+  sw_ensemble_t *ensemble = batch->ensemble;
+  sw_real_t *column = output_column(&ensemble->output_schema.metrics, handle);
+  if (!column) return NULL;
+  return &column[ensemble->outputs[batch->begin].index];
+}
+
+sw_real_t *sw_batch_output_reserve(sw_batch_t *batch, const char *name) {
+  sw_handle_t handle = output_schema_handle(&batch->ensemble->output_schema,
+                                            name);
+  return sw_batch_output_reserve_h(batch, handle);
+}
+
+bool sw_batch_get(sw_batch_t *batch, size_t i,
+                  sw_input_t **input, sw_output_t **output) {
+  if (i >= batch->size) {
+    *input = NULL;
+    *output = NULL;
+    return false;
+  }
+  *input = &batch->ensemble->inputs[batch->begin + i];
+  *output = &batch->ensemble->outputs[batch->begin + i];
+  return true;
+}
+
+sw_transfer_result_t sw_ensemble_export_inputs(sw_ensemble_t *ensemble,
+                                               size_t num_names,
+                                               const char **names,
+                                               sw_real_t *values) {
+  sw_transfer_result_t result = {.error_code = SW_SUCCESS};
+  input_layout_t *layout = &ensemble->input_layout;
+  for (size_t k = 0; k < num_names; ++k) {
+    if (name_table_find(&layout->params, names[k]) < 0) {
+      result.error_code = SW_PARAM_NOT_FOUND;
+      result.error_message =
+        pool_format(ensemble->strings,
+                    "The input parameter '%s' was not found.", names[k]);
+      return result;
+    }
+  }
+  for (size_t k = 0; k < num_names; ++k) {
+    sw_handle_t handle = name_table_find(&layout->params, names[k]);
+    gather_param_values(&kv_A(layout->param_info, handle), ensemble->offset,
+                        ensemble->size, &values[k * ensemble->size]);
+  }
+  return result;
+}
+
+sw_transfer_result_t sw_ensemble_import_outputs(sw_ensemble_t *ensemble,
+                                                size_t num_names,
+                                                const char **names,
+                                                const sw_real_t *values) {
+  sw_transfer_result_t result = {.error_code = SW_SUCCESS};
+  if (ensemble->stream) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message = "Outputs can't be imported into an ensemble whose "
+                           "outputs are streamed.";
+    return result;
+  }
+  // Each member's quantity is stored in its row of the quantity's column.
+  // NaN values are skipped so they don't overwrite quantities already set.
+  for (size_t k = 0; k < num_names; ++k) {
+    sw_handle_t handle = output_schema_handle(&ensemble->output_schema,
+                                              names[k]);
+    sw_real_t *column = output_column(&ensemble->output_schema.metrics,
+                                      handle);
+    const sw_real_t *imported = &values[k * ensemble->size];
+    for (size_t i = 0; i < ensemble->size; ++i) {
+      if (!isnan(imported[i]))
+        column[i] = imported[i];
+    }
+  }
+  return result;
+}
+
+void sw_ensemble_collect_stats(sw_ensemble_t *ensemble) {
+  ensemble->collect_stats = true;
+}
+
+void sw_ensemble_profile(sw_ensemble_t *ensemble) {
+  if (ensemble->profile_handle < 0)
+    ensemble->profile_handle = output_schema_handle(&ensemble->output_schema,
+                                                    "skywalker_time");
+}
+
+// Returns the number of bytes allocated for the values of the given
+// ensemble's input parameters, including its views of members' inputs.
+static size_t input_bytes(const sw_ensemble_t *ensemble) {
+  const input_layout_t *layout = &ensemble->input_layout;
+  size_t num_values = 0;
+  for (size_t h = 0; h < kv_size(layout->param_info); ++h)
+    num_values += kv_A(layout->param_info, h).count;
+  for (size_t h = 0; h < kv_size(layout->array_param_info); ++h) {
+    const input_param_t *param = &kv_A(layout->array_param_info, h);
+    for (size_t k = 0; k < param->count; ++k)
+      num_values += kv_size(param->arrays[k]);
+  }
+  if (ensemble->batch)
+    num_values += ensemble->batch->capacity * kv_size(layout->param_info);
+  return sizeof(sw_real_t) * num_values +
+         sizeof(sw_input_t) * (ensemble->size + 1);
+}
+
+// Returns the number of bytes allocated for the values of the given
+// ensemble's output quantities, including its views of members' outputs.
+static size_t output_bytes(const sw_ensemble_t *ensemble) {
+  const output_schema_t *schema = &ensemble->output_schema;
+  size_t n = schema->num_members + 1, bytes = sizeof(sw_output_t) * n;
+  bytes += sizeof(sw_real_t) * n * schema->metrics.size;
+  const output_index_t *index = schema->array_metrics.index;
+  for (size_t h = 0; h < schema->array_metrics.size; ++h) {
+    const array_column_t *column = index->columns[h];
+    bytes += sizeof(array_column_t) + (sizeof(size_t) + sizeof(sw_real_t*)) * n;
+    if (column->values)
+      bytes += sizeof(sw_real_t) * (schema->num_members * column->width + 1);
+    for (size_t i = 0; i < schema->num_members; ++i) {
+      if (column->rows[i])
+        bytes += sizeof(sw_real_t) * column->sizes[i];
+    }
+  }
+  return bytes;
+}
+
+// Returns the statistics for the given ensemble (see sw_ensemble_stats).
+static sw_ensemble_stats_t ensemble_stats(const sw_ensemble_t *ensemble) {
+  sw_ensemble_stats_t stats = ensemble->stats;
+  stats.input_bytes = input_bytes(ensemble);
+  stats.output_bytes = output_bytes(ensemble);
+  sw_mutex_lock(&ensemble->strings->mutex);
+  stats.string_bytes = arena_size(ensemble->strings->arena);
+  sw_mutex_unlock(&ensemble->strings->mutex);
+  return stats;
+}
+
+sw_ensemble_stats_t sw_ensemble_stats(sw_ensemble_t *ensemble) {
+  return ensemble_stats(ensemble);
+}
+
+// We use this to sort input and output quantity names.
+static int string_cmp(const void *s1, const void *s2) {
+  return strcmp(*(const char**)s1, *(const char**)s2);
+}
+
+// We use this to sort pointers to names in a name table.
+static int name_ptr_cmp(const void *p1, const void *p2) {
+  return strcmp(**(const char***)p1, **(const char***)p2);
+}
+
+// Returns a newly-allocated array containing the handles (indices) of the n
+// given names, sorted so that their names are in ascending lexicographic
+// order.
+static sw_handle_t *sorted_handles(const char **names, size_t n) {
+  const char ***name_ptrs = malloc(sizeof(const char**) * (n+1));
+  for (size_t i = 0; i < n; ++i)
+    name_ptrs[i] = &names[i];
+  qsort(name_ptrs, n, sizeof(const char**), name_ptr_cmp);
+  sw_handle_t *handles = malloc(sizeof(sw_handle_t) * (n+1));
+  for (size_t i = 0; i < n; ++i)
+    handles[i] = (sw_handle_t)(name_ptrs[i] - names);
+  free(name_ptrs);
+  return handles;
+}
+
+//------------------------------------------------------------------------
+//                     Shortest round-trip real formatting
+//------------------------------------------------------------------------
+
+// We write real numbers using the shortest decimal representation that reads
+// back as the same number. The digits are computed with the Ryu algorithm
+// (Ulf Adams, "Ryu: fast float-to-string conversion", PLDI 2018), which needs
+// only fixed-width integer arithmetic given tables of (truncated) powers of 5
+// and their inverses. We compute the tables the first time they're needed
+// instead of storing them. The tables are sized for double precision, and
+// also work for single precision values.
+
+#define POW5_BITCOUNT 125
+#define POW5_INV_BITCOUNT 125
+#define POW5_TABLE_SIZE 326
+#define POW5_INV_TABLE_SIZE 342
+
+// 5^i and 2^k/5^q, scaled to 125 bits (low and high 64-bit words)
+static uint64_t pow5_split_[POW5_TABLE_SIZE][2];
+static uint64_t pow5_inv_split_[POW5_INV_TABLE_SIZE][2];
+
+// non-NULL once the tables have been computed
+static void *pow5_tables_ready_ = NULL;
+static sw_mutex_t pow5_tables_mutex_ = SW_MUTEX_INITIALIZER;
+
+// Returns e == 0 ? 1 : ceil(log2(5^e)).
+static int32_t pow5bits(int32_t e) {
+  return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+// Returns floor(log10(2^e)) for 0 <= e <= 1650.
+static uint32_t log10_pow2(int32_t e) {
+  return ((uint32_t)e * 78913) >> 18;
+}
+
+// Returns floor(log10(5^e)) for 0 <= e <= 2620.
+static uint32_t log10_pow5(int32_t e) {
+  return ((uint32_t)e * 732923) >> 20;
+}
+
+// A (small) unsigned big integer with 32-bit limbs, least significant first.
+#define BIGNUM_LIMBS 28
+typedef struct bignum_t {
+  uint32_t limbs[BIGNUM_LIMBS];
+} bignum_t;
+
+static int bignum_bit_length(const bignum_t *x) {
+  for (int i = BIGNUM_LIMBS-1; i >= 0; --i) {
+    if (x->limbs[i]) {
+      int bits = 32;
+      while (!(x->limbs[i] & (1u << (bits-1)))) --bits;
+      return 32*i + bits;
+    }
+  }
+  return 0;
+}
+
+static bool bignum_bit(const bignum_t *x, int bit) {
+  return (x->limbs[bit/32] >> (bit % 32)) & 1;
+}
+
+static int bignum_cmp(const bignum_t *x, const bignum_t *y) {
+  for (int i = BIGNUM_LIMBS-1; i >= 0; --i) {
+    if (x->limbs[i] != y->limbs[i])
+      return (x->limbs[i] < y->limbs[i]) ? -1 : 1;
+  }
+  return 0;
+}
+
+// x -= y (assuming x >= y)
+static void bignum_sub(bignum_t *x, const bignum_t *y) {
+  uint64_t borrow = 0;
+  for (int i = 0; i < BIGNUM_LIMBS; ++i) {
+    uint64_t d = (uint64_t)x->limbs[i] - y->limbs[i] - borrow;
+    x->limbs[i] = (uint32_t)d;
+    borrow = (d >> 63) & 1;
+  }
+}
+
+// x = 2x
+static void bignum_shift_left1(bignum_t *x) {
+  for (int i = BIGNUM_LIMBS-1; i > 0; --i)
+    x->limbs[i] = (x->limbs[i] << 1) | (x->limbs[i-1] >> 31);
+  x->limbs[0] <<= 1;
+}
+
+// x = 5x
+static void bignum_mul5(bignum_t *x) {
+  uint64_t carry = 0;
+  for (int i = 0; i < BIGNUM_LIMBS; ++i) {
+    uint64_t p = (uint64_t)x->limbs[i] * 5 + carry;
+    x->limbs[i] = (uint32_t)p;
+    carry = p >> 32;
+  }
+}
+
+// Computes the tables of powers of 5 and their inverses.
+static void compute_pow5_tables(void) {
+  bignum_t pow5 = {.limbs = {1}};
+  for (int32_t i = 0; i < POW5_INV_TABLE_SIZE; ++i) {
+    int bits = bignum_bit_length(&pow5);
+    assert(bits == pow5bits(i));
+
+    // 5^i, shifted to have exactly POW5_BITCOUNT bits.
+    if (i < POW5_TABLE_SIZE) {
+      uint64_t split[2] = {0, 0};
+      for (int b = 0; b < POW5_BITCOUNT; ++b) {
+        int src = bits - POW5_BITCOUNT + b;
+        if ((src >= 0) && bignum_bit(&pow5, src))
+          split[b/64] |= (uint64_t)1 << (b % 64);
+      }
+      pow5_split_[i][0] = split[0];
+      pow5_split_[i][1] = split[1];
+    }
+
+    // floor(2^(bits - 1 + POW5_INV_BITCOUNT) / 5^i) + 1, computed by long
+    // division. The leading bits - 1 bits of the quotient are zero.
+    uint64_t q[2] = {0, 0};
+    if (i == 0) {
+      q[1] = (uint64_t)1 << (POW5_INV_BITCOUNT - 64);
+    } else {
+      bignum_t r = {.limbs = {0}};
+      r.limbs[(bits-1)/32] = 1u << ((bits-1) % 32);
+      for (int b = 0; b < POW5_INV_BITCOUNT; ++b) {
+        bignum_shift_left1(&r);
+        q[1] = (q[1] << 1) | (q[0] >> 63);
+        q[0] <<= 1;
+        if (bignum_cmp(&r, &pow5) >= 0) {
+          bignum_sub(&r, &pow5);
+          q[0] |= 1;
+        }
+      }
+    }
+    pow5_inv_split_[i][0] = q[0] + 1;
+    pow5_inv_split_[i][1] = q[1] + (q[0] + 1 == 0);
+
+    bignum_mul5(&pow5);
+  }
+}
+
+// Makes sure the tables of powers of 5 are ready for use.
+static void init_pow5_tables(void) {
+  if (!sw_load_ptr(&pow5_tables_ready_)) {
+    sw_mutex_lock(&pow5_tables_mutex_);
+    if (!pow5_tables_ready_) {
+      compute_pow5_tables();
+      sw_store_ptr(&pow5_tables_ready_, (void*)pow5_split_);
+    }
+    sw_mutex_unlock(&pow5_tables_mutex_);
+  }
+}
+
+// Computes the 128-bit product of a and b, returning the low 64 bits and
+// storing the high 64 bits.
+static uint64_t umul128(uint64_t a, uint64_t b, uint64_t *high) {
+  uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+  uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+  uint64_t b00 = a_lo * b_lo, b01 = a_lo * b_hi;
+  uint64_t b10 = a_hi * b_lo, b11 = a_hi * b_hi;
+  uint64_t mid1 = b10 + (b00 >> 32);
+  uint64_t mid2 = b01 + (uint32_t)mid1;
+  *high = b11 + (mid1 >> 32) + (mid2 >> 32);
+  return (mid2 << 32) | (uint32_t)b00;
+}
+
+// Returns floor(m * mul / 2^j) for a 125-bit multiplier mul and 64 < j < 128.
+static uint64_t mul_shift64(uint64_t m, const uint64_t mul[2], int32_t j) {
+  uint64_t high0, high1;
+  umul128(m, mul[0], &high0);
+  uint64_t low1 = umul128(m, mul[1], &high1);
+  uint64_t sum = high0 + low1;
+  if (sum < high0) ++high1;
+  int32_t dist = j - 64;
+  assert((dist > 0) && (dist < 64));
+  return (high1 << (64 - dist)) | (sum >> dist);
+}
+
+static uint32_t pow5_factor(uint64_t value) {
+  uint32_t count = 0;
+  while (value % 5 == 0) {
+    value /= 5;
+    ++count;
+  }
+  return count;
+}
+
+static bool multiple_of_pow5(uint64_t value, uint32_t p) {
+  return pow5_factor(value) >= p;
+}
+
+static bool multiple_of_pow2(uint64_t value, uint32_t p) {
+  return (value & (((uint64_t)1 << p) - 1)) == 0;
+}
+
+// Computes the shortest decimal digits d and exponent e such that d x 10^e
+// reads back as the (positive, finite) binary floating point number with the
+// given biased exponent and mantissa fields, for a type with the given number
+// of mantissa bits and exponent bias.
+static void shortest_decimal(uint64_t ieee_mantissa, uint32_t ieee_exponent,
+                             int mantissa_bits, int bias,
+                             uint64_t *digits, int32_t *exponent) {
+  int32_t e2;
+  uint64_t m2;
+  if (ieee_exponent == 0) {
+    e2 = 1 - bias - mantissa_bits - 2;
+    m2 = ieee_mantissa;
+  } else {
+    e2 = (int32_t)ieee_exponent - bias - mantissa_bits - 2;
+    m2 = ((uint64_t)1 << mantissa_bits) | ieee_mantissa;
+  }
+  bool accept_bounds = (m2 % 2 == 0);
+
+  // Determine the interval of decimal representations that read back as our
+  // number, scaled by a power of 10.
+  uint64_t mv = 4 * m2;
+  uint32_t mm_shift = (ieee_mantissa != 0) || (ieee_exponent <= 1);
+  uint64_t vr, vp, vm;
+  int32_t e10;
+  bool vm_trailing_zeros = false, vr_trailing_zeros = false;
+  if (e2 >= 0) {
+    uint32_t q = log10_pow2(e2) - (e2 > 3);
+    e10 = (int32_t)q;
+    int32_t k = POW5_INV_BITCOUNT + pow5bits((int32_t)q) - 1;
+    int32_t i = -e2 + (int32_t)q + k;
+    vr = mul_shift64(4 * m2, pow5_inv_split_[q], i);
+    vp = mul_shift64(4 * m2 + 2, pow5_inv_split_[q], i);
+    vm = mul_shift64(4 * m2 - 1 - mm_shift, pow5_inv_split_[q], i);
+    if (q <= 21) {
+      // Only one of mp, mv, and mm can be a multiple of 5, if any.
+      if (mv % 5 == 0) {
+        vr_trailing_zeros = multiple_of_pow5(mv, q);
+      } else if (accept_bounds) {
+        vm_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+      } else {
+        vp -= multiple_of_pow5(mv + 2, q);
+      }
+    }
+  } else {
+    uint32_t q = log10_pow5(-e2) - (-e2 > 1);
+    e10 = (int32_t)q + e2;
+    int32_t i = -e2 - (int32_t)q;
+    int32_t k = pow5bits(i) - POW5_BITCOUNT;
+    int32_t j = (int32_t)q - k;
+    vr = mul_shift64(4 * m2, pow5_split_[i], j);
+    vp = mul_shift64(4 * m2 + 2, pow5_split_[i], j);
+    vm = mul_shift64(4 * m2 - 1 - mm_shift, pow5_split_[i], j);
+    if (q <= 1) {
+      // mv = 4 * m2 always has at least two trailing 0 bits.
+      vr_trailing_zeros = true;
+      if (accept_bounds) {
+        vm_trailing_zeros = (mm_shift == 1);
+      } else {
+        --vp;
+      }
+    } else if (q < 63) {
+      vr_trailing_zeros = multiple_of_pow2(mv, q);
+    }
+  }
+
+  // Find the shortest representation in the interval, rounding correctly.
+  int32_t removed = 0;
+  uint32_t last_removed_digit = 0;
+  if (vm_trailing_zeros || vr_trailing_zeros) {
+    while (vp / 10 > vm / 10) {
+      vm_trailing_zeros &= (vm % 10 == 0);
+      vr_trailing_zeros &= (last_removed_digit == 0);
+      last_removed_digit = (uint32_t)(vr % 10);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      ++removed;
+    }
+    if (vm_trailing_zeros) {
+      while (vm % 10 == 0) {
+        vr_trailing_zeros &= (last_removed_digit == 0);
+        last_removed_digit = (uint32_t)(vr % 10);
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+        ++removed;
+      }
+    }
+    if (vr_trailing_zeros && (last_removed_digit == 5) && (vr % 2 == 0)) {
+      // Round to even if the exact number is .....50..0.
+      last_removed_digit = 4;
+    }
+    *digits = vr + (((vr == vm) && (!accept_bounds || !vm_trailing_zeros)) ||
+                    (last_removed_digit >= 5));
+  } else {
+    // This is the common case.
+    bool round_up = false;
+    while (vp / 10 > vm / 10) {
+      round_up = (vr % 10 >= 5);
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      ++removed;
+    }
+    *digits = vr + ((vr == vm) || round_up);
+  }
+  *exponent = e10 + removed;
+}
+
+// Writes the shortest representation of x that reads back as x (in %g style,
+// with at least two exponent digits) to s, returning its length. s must have
+// room for 32 characters.
+static size_t format_real(sw_real_t x, char *s) {
+  uint64_t ieee_mantissa;
+  uint32_t ieee_exponent;
+  int mantissa_bits, bias;
+  bool negative;
+  if (sizeof(sw_real_t) == sizeof(double)) {
+    double d = (double)x;
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(double));
+    mantissa_bits = 52;
+    bias = 1023;
+    ieee_mantissa = bits & (((uint64_t)1 << 52) - 1);
+    ieee_exponent = (uint32_t)((bits >> 52) & 0x7FF);
+    negative = (bits >> 63);
+    if (ieee_exponent == 0x7FF) ieee_exponent = UINT32_MAX;
+  } else {
+    float f = (float)x;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(float));
+    mantissa_bits = 23;
+    bias = 127;
+    ieee_mantissa = bits & ((1u << 23) - 1);
+    ieee_exponent = (bits >> 23) & 0xFF;
+    negative = (bits >> 31);
+    if (ieee_exponent == 0xFF) ieee_exponent = UINT32_MAX;
+  }
+
+  size_t n = 0;
+  if ((ieee_exponent == UINT32_MAX) && (ieee_mantissa != 0)) {
+    memcpy(s, "nan", 3);
+    return 3;
+  }
+  if (negative) s[n++] = '-';
+  if (ieee_exponent == UINT32_MAX) {
+    memcpy(&s[n], "inf", 3);
+    return n + 3;
+  }
+  if ((ieee_exponent == 0) && (ieee_mantissa == 0)) {
+    s[n++] = '0';
+    return n;
+  }
+
+  init_pow5_tables();
+  uint64_t digits;
+  int32_t exponent;
+  shortest_decimal(ieee_mantissa, ieee_exponent, mantissa_bits, bias,
+                   &digits, &exponent);
+
+  char d[20];
+  int num_digits = 0;
+  for (; digits > 0; digits /= 10)
+    d[19 - num_digits++] = (char)('0' + digits % 10);
+  const char *first = &d[20 - num_digits];
+  int32_t sci_exponent = exponent + num_digits - 1;
+
+  if ((sci_exponent >= -4) && (sci_exponent < 16)) {
+    if (exponent >= 0) { // integer
+      memcpy(&s[n], first, num_digits);
+      n += num_digits;
+      memset(&s[n], '0', exponent);
+      n += exponent;
+    } else if (sci_exponent >= 0) { // decimal point within the digits
+      memcpy(&s[n], first, sci_exponent + 1);
+      n += sci_exponent + 1;
+      s[n++] = '.';
+      memcpy(&s[n], &first[sci_exponent + 1], num_digits - sci_exponent - 1);
+      n += num_digits - sci_exponent - 1;
+    } else { // leading zeros
+      s[n++] = '0';
+      s[n++] = '.';
+      memset(&s[n], '0', -sci_exponent - 1);
+      n += -sci_exponent - 1;
+      memcpy(&s[n], first, num_digits);
+      n += num_digits;
+    }
+  } else {
+    s[n++] = first[0];
+    if (num_digits > 1) {
+      s[n++] = '.';
+      memcpy(&s[n], &first[1], num_digits - 1);
+      n += num_digits - 1;
+    }
+    s[n++] = 'e';
+    s[n++] = (sci_exponent < 0) ? '-' : '+';
+    int32_t e = (sci_exponent < 0) ? -sci_exponent : sci_exponent;
+    if (e >= 100) s[n++] = (char)('0' + e / 100);
+    s[n++] = (char)('0' + (e / 10) % 10);
+    s[n++] = (char)('0' + e % 10);
+  }
+  return n;
+}
+
+//------------------------------------------------------------------------
+//                       Buffered Python module output
+//------------------------------------------------------------------------
+
+// This type accumulates text in a large buffer, writing it to a file in big
+// blocks. A buffer without a file keeps all of its text in memory.
+typedef struct text_buffer_t {
+  FILE *file;
+  char *data;
+  size_t size, capacity;
+  int precision; // significant digits of reals (0 for full precision)
+  bool failed;   // true if a write to the file failed
+} text_buffer_t;
+
+static void text_buffer_init(text_buffer_t *buffer, FILE *file) {
+  buffer->file = file;
+  buffer->capacity = 1 << 20;
+  buffer->data = malloc(buffer->capacity);
+  buffer->size = 0;
+  buffer->precision = 0;
+  buffer->failed = false;
+}
+
+static void text_buffer_flush(text_buffer_t *buffer) {
+  if (buffer->file && (buffer->size > 0)) {
+    if (fwrite(buffer->data, 1, buffer->size, buffer->file) != buffer->size)
+      buffer->failed = true;
+    buffer->size = 0;
+  }
+}
+
+// Flushes the buffer and frees its resources, returning true if all its text
+// was written, false if not.
+static bool text_buffer_finish(text_buffer_t *buffer) {
+  text_buffer_flush(buffer);
+  free(buffer->data);
+  return !buffer->failed;
+}
+
+// Makes room for at least n characters in the buffer, returning a pointer to
+// where they go.
+static char *text_buffer_reserve(text_buffer_t *buffer, size_t n) {
+  if (buffer->size + n > buffer->capacity) {
+    text_buffer_flush(buffer);
+    if (buffer->size + n > buffer->capacity) {
+      buffer->capacity = 2 * (buffer->size + n);
+      buffer->data = realloc(buffer->data, buffer->capacity);
+    }
+  }
+  return &buffer->data[buffer->size];
+}
+
+static void text_buffer_puts(text_buffer_t *buffer, const char *s) {
+  size_t n = strlen(s);
+  memcpy(text_buffer_reserve(buffer, n), s, n);
+  buffer->size += n;
+}
+
+// Formats x in its shortest exact form (unless the buffer has a smaller
+// precision) in s, which holds at least 32 characters, returning its length.
+static size_t text_buffer_format_real(const text_buffer_t *buffer,
+                                      sw_real_t x, char *s) {
+  int max_precision = (sizeof(sw_real_t) == sizeof(double)) ? 17 : 9;
+  if ((buffer->precision > 0) && (buffer->precision < max_precision) &&
+      !isnan(x))
+    return (size_t)snprintf(s, 32, "%.*g", buffer->precision, (double)x);
+  else
+    return format_real(x, s);
+}
+
+// Appends x.
+static void text_buffer_put_value(text_buffer_t *buffer, sw_real_t x) {
+  char *s = text_buffer_reserve(buffer, 32);
+  buffer->size += text_buffer_format_real(buffer, x, s);
+}
+
+// Appends x, followed by a comma and a space.
+static void text_buffer_put_real(text_buffer_t *buffer, sw_real_t x) {
+  char *s = text_buffer_reserve(buffer, 34);
+  size_t n = text_buffer_format_real(buffer, x, s);
+  s[n++] = ',';
+  s[n++] = ' ';
+  buffer->size += n;
+}
+
+// These options write everything in a Python module.
+static const sw_write_options_t default_write_options_ = {
+  .format = SW_PYTHON_MODULE
+};
+
+// Returns true if the given options select the named quantity in the given
+// group ("settings", "input", or "output") to be written.
+static bool selects_quantity(const sw_write_options_t *options,
+                             const char *group, const char *name) {
+  if (!options->quantities) return true;
+  size_t group_length = strlen(group);
+  for (size_t i = 0; i < options->num_quantities; ++i) {
+    const char *quantity = options->quantities[i];
+    if (!strncmp(quantity, group, group_length) &&
+        ((quantity[group_length] == '\0') ||
+         ((quantity[group_length] == '.') &&
+          !strcmp(&quantity[group_length + 1], name))))
+      return true;
+  }
+  return false;
+}
+
+// Returns true if the given input parameter is to be written once (rather
+// than for each member) with the given options.
+static bool writes_input_once(const sw_write_options_t *options,
+                              const input_param_t *param) {
+  return options->fixed_inputs_once && (param->count == 1);
+}
+
+// Writes the values of the named input parameter for the n members of an
+// ensemble to the given buffer. Fixed parameters can be written once.
+static void write_input(text_buffer_t *buffer, const char *name,
+                        const input_param_t *param, size_t n, bool once) {
+  text_buffer_puts(buffer, "input.");
+  text_buffer_puts(buffer, name);
+  if (once) {
+    text_buffer_puts(buffer, " = ");
+    text_buffer_put_value(buffer, param->values[0]);
+    text_buffer_puts(buffer, "\n");
+    return;
+  }
+  text_buffer_puts(buffer, " = [");
+  for (size_t m = 0; m < n; ++m) {
+    text_buffer_put_real(buffer, param->values[param_index(param, m)]);
+  }
+  text_buffer_puts(buffer, "]\n");
+}
+
+// Writes the arrays of the named input array parameter for the n members of an
+// ensemble to the given buffer. Fixed parameters can be written once.
+static void write_array_input(text_buffer_t *buffer, const char *name,
+                              const input_param_t *param, size_t n,
+                              bool once) {
+  text_buffer_puts(buffer, "input.");
+  text_buffer_puts(buffer, name);
+  text_buffer_puts(buffer, once ? " = " : " = [");
+  for (size_t m = 0; m < (once ? 1 : n); ++m) {
+    real_vec_t array = param->arrays[param_index(param, m)];
+    text_buffer_puts(buffer, "[");
+    for (size_t j = 0; j < kv_size(array); ++j)
+      text_buffer_put_real(buffer, kv_A(array, j));
+    text_buffer_puts(buffer, once ? "]" : "],");
+  }
+  text_buffer_puts(buffer, once ? "\n" : "]\n");
+}
+
+// Writes the header of a Python module for the given ensemble, followed by its
+// settings and inputs (those selected by the given options), to the given
+// buffer.
+static void write_py_preamble(text_buffer_t *buffer,
+                              const sw_ensemble_t *ensemble,
+                              const sw_write_options_t *options) {
+  text_buffer_puts(buffer,
+    "# This file was automatically generated by skywalker.\n\n"
+    "from math import nan as nan, inf as inf\n\n"
+    "# Object is just a dynamic container that stores input/output data.\n"
+    "class Object(object):\n"
+    "    pass\n\n");
+
+  // Write settings (if present), sorted by name.
+  if (ensemble->settings) {
+    text_buffer_puts(buffer, "# Settings are stored here.\n");
+    text_buffer_puts(buffer, "settings = Object()\n");
+    khash_t(string_map) *settings = ensemble->settings->params;
+    size_t num_settings = kh_size(settings);
+    const char **setting_names = malloc(sizeof(const char*) * num_settings);
+    size_t i = 0;
+    for (khiter_t iter = kh_begin(settings); iter != kh_end(settings); ++iter) {
+      if (!kh_exist(settings, iter)) continue;
+      setting_names[i++] = kh_key(settings, iter);
+    }
+    qsort(setting_names, num_settings, sizeof(const char*), string_cmp);
+
+    for (i = 0; i < num_settings; ++i) {
+      const char *name = setting_names[i];
+      if (!selects_quantity(options, "settings", name)) continue;
+      khiter_t iter = kh_get(string_map, settings, name);
+      const char* value = kh_val(settings, iter);
+      text_buffer_puts(buffer, "settings.");
+      text_buffer_puts(buffer, name);
+      text_buffer_puts(buffer, " = '");
+      text_buffer_puts(buffer, value);
+      text_buffer_puts(buffer, "'\n");
+    }
+    free(setting_names);
+  }
+
+  // Write input data, sorted by quantity name.
+  {
+    text_buffer_puts(buffer, "# Input is stored here.\n");
+    text_buffer_puts(buffer, "input = Object()\n");
+    const input_layout_t *layout = &ensemble->input_layout;
+    size_t n = ensemble->global_size;
+    sw_handle_t *handles = sorted_handles(layout->params.names.a,
+                                          name_table_size(&layout->params));
+    for (size_t i = 0; i < name_table_size(&layout->params); ++i) {
+      sw_handle_t h = handles[i];
+      const char *name = kv_A(layout->params.names, h);
+      const input_param_t *param = &kv_A(layout->param_info, h);
+      if (selects_quantity(options, "input", name))
+        write_input(buffer, name, param, n, writes_input_once(options, param));
+    }
+    free(handles);
+    handles = sorted_handles(layout->array_params.names.a,
+                             name_table_size(&layout->array_params));
+    for (size_t i = 0; i < name_table_size(&layout->array_params); ++i) {
+      sw_handle_t h = handles[i];
+      const char *name = kv_A(layout->array_params.names, h);
+      const input_param_t *param = &kv_A(layout->array_param_info, h);
+      if (selects_quantity(options, "input", name))
+        write_array_input(buffer, name, param, n,
+                          writes_input_once(options, param));
+    }
+    free(handles);
+  }
+}
+
+// Writes a Python list of the first n values in the given output column to the
+// given buffer.
+static void write_py_values(text_buffer_t *buffer, const sw_real_t *column,
+                            size_t n) {
+  text_buffer_puts(buffer, "[");
+  for (size_t m = 0; m < n; ++m) {
+    text_buffer_put_real(buffer, column[m]);
+  }
+  text_buffer_puts(buffer, "]");
+}
+
+// Writes a Python list of the n rows starting with the given one in the given
+// array output column to the given buffer.
+static void write_py_arrays(text_buffer_t *buffer,
+                            const array_column_t *column, size_t first,
+                            size_t n) {
+  text_buffer_puts(buffer, "[");
+  for (size_t m = first; m < first + n; ++m) {
+    const sw_real_t *values = array_column_row(column, m);
+    text_buffer_puts(buffer, "[");
+    for (size_t j = 0; j < column->sizes[m]; ++j) {
+      text_buffer_put_real(buffer, values[j]);
+    }
+    text_buffer_puts(buffer, "],");
+  }
+  text_buffer_puts(buffer, "]");
+}
+
+// Writes the given ensemble's statistics (except its write time, which isn't
+// known yet) to a stats object in a Python module in the given buffer, if the
+// ensemble collects them.
+static void write_py_stats(text_buffer_t *buffer,
+                           const sw_ensemble_t *ensemble) {
+  if (!ensemble->collect_stats) return;
+  sw_ensemble_stats_t stats = ensemble_stats(ensemble);
+  char text[512];
+  snprintf(text, 512,
+           "\n# Skywalker's statistics for this ensemble are stored here.\n"
+           "stats = Object()\n"
+           "stats.parse_time = %.9g\n"
+           "stats.build_time = %.9g\n"
+           "stats.traversal_time = %.9g\n"
+           "stats.driver_time = %.9g\n"
+           "stats.input_bytes = %zu\n"
+           "stats.output_bytes = %zu\n"
+           "stats.string_bytes = %zu\n",
+           stats.parse_time, stats.build_time, stats.traversal_time,
+           stats.driver_time, stats.input_bytes, stats.output_bytes,
+           stats.string_bytes);
+  text_buffer_puts(buffer, text);
+}
+
+// Writes the given ensemble's settings and inputs and the given outputs for
+// all of its members to a Python module in the file with the given name, with
+// the given options.
+static sw_write_result_t write_py_module(const sw_ensemble_t *ensemble,
+                                         const output_schema_t *schema,
+                                         const char *module_filename,
+                                         const sw_write_options_t *options) {
+  sw_write_result_t result = {.error_code = SW_SUCCESS};
+  if (ensemble->global_size == 0) {
+    result.error_code = SW_EMPTY_ENSEMBLE;
+    result.error_message = "The given ensemble is empty!";
+    return result;
+  }
+  FILE* file = fopen(module_filename, "w");
+  if (!file) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "Could not write ensemble data to '%s'.", module_filename);
+    return result;
+  }
+  text_buffer_t buffer;
+  text_buffer_init(&buffer, file);
+  buffer.precision = options->precision;
+  write_py_preamble(&buffer, ensemble, options);
+
+  // Write output data, sorted by quantity name. Unset quantities are NaN (or
+  // empty, for arrays).
+  text_buffer_puts(&buffer, "\n# Output data is stored here.\n");
+  text_buffer_puts(&buffer, "output = Object()\n");
+  {
+    const output_index_t *index = schema->metrics.index;
+    sw_handle_t *handles = sorted_handles(index->names, schema->metrics.size);
+    for (size_t i = 0; i < schema->metrics.size; ++i) {
+      sw_handle_t h = handles[i];
+      if (!selects_quantity(options, "output", index->names[h])) continue;
+      const sw_real_t *column = index->columns[h];
+      text_buffer_puts(&buffer, "output.");
+      text_buffer_puts(&buffer, index->names[h]);
+      text_buffer_puts(&buffer, " = ");
+      write_py_values(&buffer, column, schema->num_members);
+      text_buffer_puts(&buffer, "\n");
+    }
+    free(handles);
+
+    index = schema->array_metrics.index;
+    handles = sorted_handles(index->names, schema->array_metrics.size);
+    for (size_t i = 0; i < schema->array_metrics.size; ++i) {
+      sw_handle_t h = handles[i];
+      if (!selects_quantity(options, "output", index->names[h])) continue;
+      const array_column_t *column = index->columns[h];
+      text_buffer_puts(&buffer, "output.");
+      text_buffer_puts(&buffer, index->names[h]);
+      text_buffer_puts(&buffer, " = ");
+      write_py_arrays(&buffer, column, 0, schema->num_members);
+      text_buffer_puts(&buffer, "\n");
+    }
+    free(handles);
+  }
+  write_py_stats(&buffer, ensemble);
+
+  bool succeeded = text_buffer_finish(&buffer);
+  if (fclose(file) || !succeeded) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "Could not write ensemble data to '%s'.", module_filename);
+  }
+  return result;
+}
+
+//------------------------------------------------------------------------
+//                      Streaming Python module output
+//------------------------------------------------------------------------
+
+// An output stream writes an ensemble's Python module as the ensemble is
+// traversed: the settings and inputs up front, and the outputs of each chunk of
+// members once sw_ensemble_next has moved past it. The ensemble's output
+// columns then hold only two chunks of members, used in turn: once the
+// traversal moves past a chunk, the chunk is handed to a writer thread, which
+// formats and writes its outputs and resets its rows while the driver
+// processes the next chunk. The traversal waits for the writer only if it
+// moves past the next chunk before the writer is done. So outputs never
+// occupy more memory than two chunks need. (If the writer thread can't be
+// started, each chunk is written by the traversal instead.)
+//
+// In the module, each chunk's values are appended to the output lists by a
+// helper function that also pads lists for quantities that weren't set by
+// earlier members. The lists are padded to the size of the ensemble when the
+// stream is finished, so a finished module defines the same data as one
+// written all at once by sw_ensemble_write. An unfinished module (left behind
+// by a program that didn't finish) defines the outputs of all the members
+// whose chunks were written.
+//
+// After each chunk, the stream records the number of members it has written
+// in a comment. A stream can be restarted from an unfinished module by
+// discarding any text after the last of these comments and resuming the
+// traversal with the next member.
+
+// A chunk of members whose outputs are to be written: members [begin,
+// begin + n), stored in the rows of the output columns starting with
+// first_row, with the quantities registered when the traversal moved past it.
+typedef struct stream_chunk_t {
+  size_t begin, n, first_row;
+  const output_index_t *index, *array_index;
+  size_t num_quantities, num_array_quantities;
+} stream_chunk_t;
+
+struct output_stream_t {
+  const char *filename;  // name of the module's file
+  FILE *file;            // the module's file (NULL once the stream finishes)
+  text_buffer_t buffer;  // text not yet written to the file
+  size_t chunk_size;     // number of members in a chunk
+  size_t first;          // index of the first member streamed by this run
+  size_t begin;          // index of the first member in the current chunk
+  bool failed;           // true if writing the module failed
+  // the writer thread (if has_writer is true), the chunk handed to it (if
+  // pending is true), and whether it should stop once it's written
+  bool has_writer;
+  sw_thread_t writer;
+  sw_mutex_t mutex;
+  sw_cond_t cond;
+  stream_chunk_t chunk;
+  bool pending, stopping;
+};
+
+// the comment that records the number of members written by a stream
+static const char *stream_marker_ = "# completed members: ";
+
+// Returns the first n members in the current chunk of the given ensemble's
+// stream, advancing the stream to the next chunk.
+static stream_chunk_t next_stream_chunk(sw_ensemble_t *ensemble, size_t n) {
+  output_stream_t *stream = ensemble->stream;
+  const output_schema_t *schema = &ensemble->output_schema;
+  stream_chunk_t chunk = {
+    .begin = stream->begin, .n = n,
+    .first_row = ((stream->begin - stream->first) / stream->chunk_size % 2) *
+                 stream->chunk_size,
+    .index = schema->metrics.index,
+    .array_index = schema->array_metrics.index,
+    .num_quantities = schema->metrics.size,
+    .num_array_quantities = schema->array_metrics.size
+  };
+  stream->begin += n;
+  return chunk;
+}
+
+// Writes the outputs of the given chunk to the given stream, and resets their
+// values.
+static void write_stream_chunk(output_stream_t *stream,
+                               const stream_chunk_t *chunk) {
+  text_buffer_t *buffer = &stream->buffer;
+  size_t n = chunk->n, row = chunk->first_row;
+  char begin[32];
+  snprintf(begin, 32, "%zu", chunk->begin);
+
+  const output_index_t *index = chunk->index;
+  sw_handle_t *handles = sorted_handles(index->names, chunk->num_quantities);
+  for (size_t i = 0; i < chunk->num_quantities; ++i) {
+    sw_handle_t h = handles[i];
+    sw_real_t *column = (sw_real_t*)index->columns[h] + row;
+    text_buffer_puts(buffer, "_extend('");
+    text_buffer_puts(buffer, index->names[h]);
+    text_buffer_puts(buffer, "', ");
+    text_buffer_puts(buffer, begin);
+    text_buffer_puts(buffer, ", ");
+    write_py_values(buffer, column, n);
+    text_buffer_puts(buffer, ")\n");
+    for (size_t m = 0; m < n; ++m)
+      column[m] = NAN;
+  }
+  free(handles);
+
+  index = chunk->array_index;
+  handles = sorted_handles(index->names, chunk->num_array_quantities);
+  for (size_t i = 0; i < chunk->num_array_quantities; ++i) {
+    sw_handle_t h = handles[i];
+    array_column_t *column = index->columns[h];
+    text_buffer_puts(buffer, "_extend('");
+    text_buffer_puts(buffer, index->names[h]);
+    text_buffer_puts(buffer, "', ");
+    text_buffer_puts(buffer, begin);
+    text_buffer_puts(buffer, ", ");
+    write_py_arrays(buffer, column, row, n);
+    text_buffer_puts(buffer, ", True)\n");
+    for (size_t m = row; m < row + n; ++m) {
+      free(column->rows[m]);
+      column->rows[m] = NULL;
+      column->sizes[m] = 0;
+    }
+  }
+  free(handles);
+
+  // Record the chunk's completion and put it on disk.
+  char marker[64];
+  snprintf(marker, 64, "%s%zu\n", stream_marker_, chunk->begin + n);
+  text_buffer_puts(buffer, marker);
+  text_buffer_flush(buffer);
+  fflush(stream->file);
+}
+
+// Writes the chunks handed to the given stream's writer until it's stopped.
+static void run_stream_writer(void *context) {
+  output_stream_t *stream = context;
+  sw_mutex_lock(&stream->mutex);
+  while (true) {
+    while (!stream->pending && !stream->stopping)
+      sw_cond_wait(&stream->cond, &stream->mutex);
+    if (!stream->pending) break;
+    stream_chunk_t chunk = stream->chunk;
+    sw_mutex_unlock(&stream->mutex);
+    write_stream_chunk(stream, &chunk);
+    sw_mutex_lock(&stream->mutex);
+    stream->pending = false;
+    sw_cond_broadcast(&stream->cond);
+  }
+  sw_mutex_unlock(&stream->mutex);
+}
+
+// Starts the given stream's writer thread, if it can.
+static void start_stream_writer(output_stream_t *stream) {
+  sw_mutex_init(&stream->mutex);
+  sw_cond_init(&stream->cond);
+  stream->pending = stream->stopping = false;
+  stream->has_writer = sw_thread_start(&stream->writer, run_stream_writer,
+                                       stream);
+  if (!stream->has_writer) {
+    sw_cond_destroy(&stream->cond);
+    sw_mutex_destroy(&stream->mutex);
+  }
+}
+
+// Waits for the given stream's writer thread to write any chunk handed to it,
+// and stops the thread.
+static void stop_stream_writer(output_stream_t *stream) {
+  if (!stream->has_writer) return;
+  sw_mutex_lock(&stream->mutex);
+  stream->stopping = true;
+  sw_cond_broadcast(&stream->cond);
+  sw_mutex_unlock(&stream->mutex);
+  sw_thread_join(&stream->writer);
+  sw_cond_destroy(&stream->cond);
+  sw_mutex_destroy(&stream->mutex);
+  stream->has_writer = false;
+}
+
+// Hands the first n members in the current chunk of the given ensemble's
+// stream to its writer (once the writer is done with the previous chunk, whose
+// rows the next chunk reuses), and advances the stream to the next chunk.
+static void hand_off_stream_chunk(sw_ensemble_t *ensemble, size_t n) {
+  output_stream_t *stream = ensemble->stream;
+  stream_chunk_t chunk = next_stream_chunk(ensemble, n);
+  if (!stream->has_writer) {
+    write_stream_chunk(stream, &chunk);
+    return;
+  }
+  sw_mutex_lock(&stream->mutex);
+  while (stream->pending)
+    sw_cond_wait(&stream->cond, &stream->mutex);
+  stream->chunk = chunk;
+  stream->pending = true;
+  sw_cond_broadcast(&stream->cond);
+  sw_mutex_unlock(&stream->mutex);
+}
+
+// Closes the given stream's file, leaving its module as it is (with all the
+// chunks handed to its writer).
+static void close_stream(output_stream_t *stream) {
+  stop_stream_writer(stream);
+  stream->failed = !text_buffer_finish(&stream->buffer) || stream->failed;
+  stream->failed = fclose(stream->file) || stream->failed;
+  stream->file = NULL;
+}
+
+// Writes the outputs of the members of the given ensemble's current chunk that
+// have been traversed, has the module pad all output lists to the size of the
+// ensemble, and closes the stream's file. Does nothing if the stream is
+// already finished.
+static void finish_stream(sw_ensemble_t *ensemble) {
+  output_stream_t *stream = ensemble->stream;
+  if (!stream->file) return;
+  stop_stream_writer(stream);
+  if (ensemble->position > stream->begin) {
+    stream_chunk_t chunk = next_stream_chunk(ensemble,
+                                             ensemble->position - stream->begin);
+    write_stream_chunk(stream, &chunk);
+  }
+
+  char trailer[64];
+  snprintf(trailer, 64, "_finish(%zu)\n", ensemble->size);
+  text_buffer_puts(&stream->buffer, trailer);
+  text_buffer_puts(&stream->buffer, "del _extend, _finish, _is_array\n");
+  write_py_stats(&stream->buffer, ensemble);
+  close_stream(stream);
+}
+
+// Prepares the given ensemble's stream for the next step of a traversal,
+// handing off the current chunk if all of its members have been traversed and
+// finishing the stream at the end of the traversal. Returns false if the
+// stream has already finished, true otherwise.
+static bool advance_stream(sw_ensemble_t *ensemble) {
+  output_stream_t *stream = ensemble->stream;
+  if (!stream->file) return false;
+  if (ensemble->position >= ensemble->size)
+    finish_stream(ensemble);
+  else if (ensemble->position - stream->begin == stream->chunk_size)
+    hand_off_stream_chunk(ensemble, stream->chunk_size);
+  return true;
+}
+
+static size_t stream_chunk_end(const sw_ensemble_t *ensemble) {
+  const output_stream_t *stream = ensemble->stream;
+  size_t end = stream->begin + stream->chunk_size;
+  return (end < ensemble->size) ? end : ensemble->size;
+}
+
+// Writes the beginning of a streamed Python module for the given ensemble: its
+// settings and inputs, and the helper that extends output lists.
+static void write_stream_preamble(text_buffer_t *buffer,
+                                  const sw_ensemble_t *ensemble) {
+  write_py_preamble(buffer, ensemble, &default_write_options_);
+  text_buffer_puts(buffer,
+    "\n# Output data is stored here.\n"
+    "output = Object()\n\n"
+    "# Output data are streamed in chunks of members. This function appends\n"
+    "# a chunk's values (which begin at the given member) to an output list,\n"
+    "# padding the list for members that didn't set the quantity.\n"
+    "def _extend(name, begin, values, is_array=False):\n"
+    "    column = getattr(output, name, [])\n"
+    "    column.extend([[] if is_array else nan\n"
+    "                   for i in range(begin - len(column))])\n"
+    "    column.extend(values)\n"
+    "    setattr(output, name, column)\n"
+    "    _is_array[name] = is_array\n"
+    "_is_array = {}\n\n"
+    "# This function pads all output lists to the given number of members once\n"
+    "# the stream is finished.\n"
+    "def _finish(size):\n"
+    "    for name, is_array in _is_array.items():\n"
+    "        _extend(name, size, [], is_array)\n\n");
+}
+
+// Reads the streamed module in the given file, returning the number of members
+// (no more than num_members) whose outputs it records and storing the length
+// of its text through the last of their chunks. Returns SIZE_MAX if the
+// module doesn't begin with the given preamble.
+static size_t scan_streamed_module(FILE *file, const text_buffer_t *preamble,
+                                   size_t num_members, size_t *length) {
+  char *text = malloc(preamble->size + 1);
+  bool matches = (fread(text, 1, preamble->size, file) == preamble->size) &&
+                 !memcmp(text, preamble->data, preamble->size);
+  free(text);
+  if (!matches) return SIZE_MAX;
+
+  // Look for lines consisting of the marker followed by a number.
+  size_t marker_length = strlen(stream_marker_);
+  size_t num_completed = 0, position = preamble->size;
+  size_t matched = 0, num_digits = 0, count = 0;
+  *length = position;
+  for (int c = getc(file); c != EOF; c = getc(file)) {
+    ++position;
+    if (c == '\n') {
+      if ((matched == marker_length) && (num_digits > 0)) {
+        num_completed = count;
+        *length = position;
+      }
+      matched = num_digits = count = 0;
+    } else if (matched < marker_length) {
+      matched = (c == stream_marker_[matched]) ? matched + 1 : SIZE_MAX;
+    } else if ((matched == marker_length) && isdigit(c)) {
+      count = 10 * count + (size_t)(c - '0');
+      ++num_digits;
+      if (count > num_members) matched = SIZE_MAX;
+    } else {
+      matched = SIZE_MAX;
+    }
+  }
+  return num_completed;
+}
+
+// Shortens the given file to the given length, returning true on success.
+static bool truncate_file(FILE *file, size_t length) {
+  fflush(file);
+#ifdef _WIN32
+  return !_chsize_s(_fileno(file), (__int64)length);
+#else
+  return !ftruncate(fileno(file), (off_t)length);
+#endif
+}
+
+// Attaches a stream to the given ensemble that writes the Python module in the
+// file with the given name in chunks of the given size. If restart is true and
+// the file contains an unfinished module streamed for the ensemble, the stream
+// keeps the outputs in it and resumes the ensemble's traversal after them.
+static sw_write_result_t start_stream(sw_ensemble_t *ensemble,
+                                      const char *module_filename,
+                                      size_t chunk_size, bool restart) {
+  sw_write_result_t result = {.error_code = SW_SUCCESS};
+  if (ensemble->stream) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "The ensemble's outputs are already streamed to '%s'.",
+                  ensemble->stream->filename);
+    return result;
+  }
+#ifdef SKYWALKER_HAVE_MPI
+  if (ensemble->comm != MPI_COMM_NULL) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      "The outputs of a distributed ensemble can't be streamed.";
+    return result;
+  }
+#endif
+  if (ensemble->position > 0) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      "Outputs can't be streamed during a traversal of the ensemble.";
+    return result;
+  }
+  if (chunk_size == 0) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message = "Invalid chunk size: 0";
+    return result;
+  }
+  if (ensemble->size == 0) {
+    result.error_code = SW_EMPTY_ENSEMBLE;
+    result.error_message = "The given ensemble is empty!";
+    return result;
+  }
+
+  // The module is written in binary mode so that restarts can find positions
+  // within it.
+  text_buffer_t preamble;
+  text_buffer_init(&preamble, NULL);
+  write_stream_preamble(&preamble, ensemble);
+  size_t num_completed = 0;
+  FILE *file = (restart) ? fopen(module_filename, "r+b") : NULL;
+  if (file) {
+    size_t length;
+    num_completed = scan_streamed_module(file, &preamble,
+                                         ensemble->size, &length);
+    if (num_completed == SIZE_MAX) {
+      fclose(file);
+      text_buffer_finish(&preamble);
+      result.error_code = SW_WRITE_FAILURE;
+      result.error_message =
+        pool_format(ensemble->strings,
+                    "'%s' doesn't contain outputs streamed for this ensemble.",
+                    module_filename);
+      return result;
+    }
+    // Discard any partially-written chunk.
+    if (!truncate_file(file, length) || fseek(file, 0, SEEK_END)) {
+      fclose(file);
+      file = NULL;
+    }
+    preamble.size = 0;
+  } else {
+    file = fopen(module_filename, "wb");
+  }
+  if (!file) {
+    text_buffer_finish(&preamble);
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "Could not write ensemble data to '%s'.", module_filename);
+    return result;
+  }
+
+  // Write the preamble (if needed).
+  if (preamble.size > 0) {
+    preamble.file = file;
+    text_buffer_flush(&preamble);
+    fflush(file);
+  }
+  bool failed = !text_buffer_finish(&preamble);
+
+  output_stream_t *stream = malloc(sizeof(output_stream_t));
+  stream->filename = copy_string(module_filename);
+  stream->file = file;
+  text_buffer_init(&stream->buffer, file);
+  stream->chunk_size = chunk_size;
+  stream->first = stream->begin = num_completed;
+  stream->failed = failed;
+  stream->has_writer = false;
+  ensemble->stream = stream;
+
+  // The traversal resumes after the completed members, and each member's
+  // outputs are stored in its row of one of two chunks, used in turn. The
+  // writer is needed only if there's more than one chunk.
+  ensemble->position = num_completed;
+  for (size_t i = num_completed; i < ensemble->size; ++i)
+    ensemble->outputs[i].index = (i - num_completed) % (2 * chunk_size);
+  if (chunk_size < ensemble->size - num_completed) {
+    if (2 * chunk_size < ensemble->size)
+      ensemble->output_schema.num_members = 2 * chunk_size;
+    start_stream_writer(stream);
+  }
+  return result;
+}
+
+sw_write_result_t sw_ensemble_stream(sw_ensemble_t *ensemble,
+                                     const char *module_filename,
+                                     size_t chunk_size) {
+  return start_stream(ensemble, module_filename, chunk_size, false);
+}
+
+sw_write_result_t sw_ensemble_restart(sw_ensemble_t *ensemble,
+                                      const char *module_filename,
+                                      size_t chunk_size) {
+  return start_stream(ensemble, module_filename, chunk_size, true);
+}
+
+// Finishes the stream for the given ensemble, whose outputs can be written only
+// to the stream's module.
+static sw_write_result_t write_streamed_module(sw_ensemble_t *ensemble,
+                                               const char *filename,
+                                               sw_write_format_t format) {
+  sw_write_result_t result = {.error_code = SW_SUCCESS};
+  output_stream_t *stream = ensemble->stream;
+  if ((format != SW_PYTHON_MODULE) || strcmp(filename, stream->filename)) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "The ensemble's outputs were streamed to '%s', and can't be "
+                  "written to '%s'.", stream->filename, filename);
+    return result;
+  }
+  finish_stream(ensemble);
+  if (stream->failed) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "Could not write ensemble data to '%s'.", filename);
+  }
+  return result;
+}
+
+//------------------------------------------------------------------------
+//                         Memoized member outputs
+//------------------------------------------------------------------------
+
+// An ensemble whose members are memoized (see sw_ensemble_memoize) records the
+// outputs of each member traversed by sw_ensemble_next in a memo file, keyed
+// by a hash of the ensemble's settings and the member's inputs. A traversal
+// skips any member whose key is in the memo, filling its outputs from the memo
+// instead. The memo file is a header followed by records, one per member,
+// appended as the traversal moves past members. Its contents are kept in
+// memory, and records are found by their offsets in it.
+//
+// Each record holds (as 64-bit sizes, strings preceded by their lengths, and
+// reals) the member's key, the number of scalar outputs it set followed by
+// their names and values, and the number of array outputs it set followed by
+// their names, sizes, and values. A key is a pair of independent hashes: the
+// first locates the record, and the second checks it.
+
+// version of the memo file format
+#define MEMO_FORMAT_VERSION 1
+
+// This type is the header of a memo file.
+typedef struct memo_header_t {
+  char magic[8];      // "SWMEMO"
+  uint64_t version;   // MEMO_FORMAT_VERSION
+  uint64_t real_size; // size of the reals stored in records
+  uint64_t one;       // 1, in the byte order of the records
+} memo_header_t;
+
+// A hash table mapping the keys of memoized members to their records' offsets.
+KHASH_MAP_INIT_INT64(memo_map, size_t)
+
+struct member_memo_t {
+  FILE *file;                 // the memo file
+  kvec_t(char) contents;      // the contents of the file
+  khash_t(memo_map) *records; // offsets of records in contents, by key
+  uint64_t settings_key[2];   // the part of each key from the settings
+  size_t pending;             // member being processed (SIZE_MAX if none)
+  kvec_t(char) name;          // the name of the quantity being recalled
+};
+
+// Offset bases for the two hashes in a key.
+static const uint64_t memo_offsets_[2] = {
+  0xcbf29ce484222325ULL, 0x6c62272e07bb0142ULL
+};
+
+// Returns the given hash with its bits mixed (by the finalizer of
+// SplitMix64), so that sums of similar hashes don't cancel.
+static uint64_t mix_hash(uint64_t hash) {
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+  return hash ^ (hash >> 31);
+}
+
+// Returns the given (0 or 1) hash of a value of the given kind ('s' for a
+// setting, 'x' for a scalar input, 'a' for an input array) with the given name
+// and bytes. The hashes of a member's settings and inputs are summed, so its
+// key doesn't depend on the order in which they're stored.
+static uint64_t memo_hash(int h, char kind, const char *name,
+                          const void *bytes, size_t size) {
+  uint64_t hash = fnv1a_hash(memo_offsets_[h], &kind, 1);
+  hash = fnv1a_hash(hash, name, strlen(name) + 1);
+  return mix_hash(fnv1a_hash(hash, bytes, size));
+}
+
+// Computes the key for member i of the given ensemble.
+static void member_key(const sw_ensemble_t *ensemble, size_t i,
+                       uint64_t key[2]) {
+  const input_layout_t *layout = &ensemble->input_layout;
+  const sw_input_t *input = &ensemble->inputs[i];
+  for (int h = 0; h < 2; ++h) {
+    key[h] = ensemble->memo->settings_key[h];
+    for (size_t p = 0; p < kv_size(layout->param_info); ++p) {
+      sw_real_t value = input_value(input, (sw_handle_t)p);
+      key[h] += memo_hash(h, 'x', kv_A(layout->params.names, p), &value,
+                          sizeof(sw_real_t));
+    }
+    for (size_t p = 0; p < kv_size(layout->array_param_info); ++p) {
+      real_vec_t array = input_array(input, (sw_handle_t)p);
+      key[h] += memo_hash(h, 'a', kv_A(layout->array_params.names, p),
+                          array.a, sizeof(sw_real_t) * kv_size(array));
+    }
+  }
+}
+
+// Appends the given bytes to the memo's contents.
+static void memo_put(member_memo_t *memo, const void *data, size_t size) {
+  size_t length = kv_size(memo->contents);
+  if (length + size > kv_max(memo->contents))
+    kv_resize(char, memo->contents, 2 * (length + size));
+  memcpy(&memo->contents.a[length], data, size);
+  memo->contents.n += size;
+}
+
+static void memo_put_size(member_memo_t *memo, size_t size) {
+  uint64_t n = size;
+  memo_put(memo, &n, sizeof(uint64_t));
+}
+
+static void memo_put_string(member_memo_t *memo, const char *s) {
+  size_t length = strlen(s);
+  memo_put_size(memo, length);
+  memo_put(memo, s, length);
+}
+
+// Reads the name of a quantity in a record into the memo's name buffer,
+// returning it.
+static const char *memo_read_name(member_memo_t *memo,
+                                  cache_reader_t *reader) {
+  size_t length = cache_read_size(reader);
+  const char *s = cache_read(reader, length);
+  if (!s) return "";
+  if (length + 1 > kv_max(memo->name))
+    kv_resize(char, memo->name, length + 1);
+  memcpy(memo->name.a, s, length);
+  memo->name.a[length] = '\0';
+  return memo->name.a;
+}
+
+// Moves the given reader past the record it's reading, storing the record's
+// key. Returns false if the record is incomplete.
+static bool skip_memo_record(cache_reader_t *reader, uint64_t *key) {
+  const void *data = cache_read(reader, 2 * sizeof(uint64_t));
+  if (data) memcpy(key, data, sizeof(uint64_t));
+  for (size_t n = cache_read_size(reader); (n > 0) && !reader->failed; --n) {
+    cache_read(reader, cache_read_size(reader));
+    cache_read(reader, sizeof(sw_real_t));
+  }
+  for (size_t n = cache_read_size(reader); (n > 0) && !reader->failed; --n) {
+    cache_read(reader, cache_read_size(reader));
+    size_t size = cache_read_size(reader);
+    if (size > SIZE_MAX / sizeof(sw_real_t)) reader->failed = true;
+    cache_read(reader, sizeof(sw_real_t) * size);
+  }
+  return !reader->failed;
+}
+
+// Records the outputs of member i of the given ensemble in its memo.
+static void memoize_member(sw_ensemble_t *ensemble, size_t i) {
+  member_memo_t *memo = ensemble->memo;
+  const output_schema_t *schema = &ensemble->output_schema;
+  size_t row = ensemble->outputs[i].index;
+  uint64_t key[2];
+  member_key(ensemble, i, key);
+  size_t offset = kv_size(memo->contents);
+  memo_put(memo, key, sizeof(key));
+
+  // Unset outputs are left out, as is the time recorded for a profiled member
+  // (its time isn't spent again when it's recalled).
+  const output_index_t *index = output_table_index(&schema->metrics);
+  size_t count_offset = kv_size(memo->contents);
+  uint64_t count = 0;
+  memo_put(memo, &count, sizeof(uint64_t));
+  for (size_t h = 0; h < schema->metrics.size; ++h) {
+    const sw_real_t *column = index->columns[h];
+    if (isnan(column[row]) || ((sw_handle_t)h == ensemble->profile_handle))
+      continue;
+    memo_put_string(memo, index->names[h]);
+    memo_put(memo, &column[row], sizeof(sw_real_t));
+    ++count;
+  }
+  memcpy(&memo->contents.a[count_offset], &count, sizeof(uint64_t));
+
+  index = output_table_index(&schema->array_metrics);
+  count_offset = kv_size(memo->contents);
+  count = 0;
+  memo_put(memo, &count, sizeof(uint64_t));
+  for (size_t h = 0; h < schema->array_metrics.size; ++h) {
+    const array_column_t *column = index->columns[h];
+    size_t size = column->sizes[row];
+    if (size == 0) continue;
+    memo_put_string(memo, index->names[h]);
+    memo_put_size(memo, size);
+    memo_put(memo, array_column_row(column, row), sizeof(sw_real_t) * size);
+    ++count;
+  }
+  memcpy(&memo->contents.a[count_offset], &count, sizeof(uint64_t));
+
+  // A memo that can't be written still serves this traversal.
+  fwrite(&memo->contents.a[offset], 1, kv_size(memo->contents) - offset,
+         memo->file);
+  int ret;
+  khiter_t iter = kh_put(memo_map, memo->records, key[0], &ret);
+  kh_value(memo->records, iter) = offset;
+}
+
+// If member i of the given ensemble is in its memo, fills the member's outputs
+// from the memo and returns true. Otherwise makes it the member being
+// processed and returns false.
+static bool recall_member(sw_ensemble_t *ensemble, size_t i) {
+  member_memo_t *memo = ensemble->memo;
+  uint64_t key[2];
+  member_key(ensemble, i, key);
+  khiter_t iter = kh_get(memo_map, memo->records, key[0]);
+  memo->pending = i;
+  if (iter == kh_end(memo->records)) return false;
+  cache_reader_t reader = {
+    .p = &memo->contents.a[kh_value(memo->records, iter)],
+    .end = &memo->contents.a[kv_size(memo->contents)]
+  };
+  uint64_t stored_key[2];
+  memcpy(stored_key, cache_read(&reader, sizeof(stored_key)),
+         sizeof(stored_key));
+  if (stored_key[1] != key[1]) return false;
+  memo->pending = SIZE_MAX;
+
+  // Records are checked when the memo is read, so reading them can't fail.
+  output_schema_t *schema = &ensemble->output_schema;
+  sw_output_t *output = &ensemble->outputs[i];
+  for (size_t n = cache_read_size(&reader); n > 0; --n) {
+    sw_handle_t handle =
+      output_schema_handle(schema, memo_read_name(memo, &reader));
+    sw_real_t value;
+    memcpy(&value, cache_read(&reader, sizeof(sw_real_t)), sizeof(sw_real_t));
+    sw_output_set_h(output, handle, value);
+  }
+  for (size_t n = cache_read_size(&reader); n > 0; --n) {
+    sw_handle_t handle =
+      output_schema_array_handle(schema, memo_read_name(memo, &reader));
+    size_t size = cache_read_size(&reader);
+    memcpy(sw_output_reserve_array_h(output, handle, size),
+           cache_read(&reader, sizeof(sw_real_t) * size),
+           sizeof(sw_real_t) * size);
+  }
+  return true;
+}
+
+static void memoize_pending_member(sw_ensemble_t *ensemble) {
+  member_memo_t *memo = ensemble->memo;
+  if (memo->pending != SIZE_MAX) {
+    memoize_member(ensemble, memo->pending);
+    memo->pending = SIZE_MAX;
+  }
+}
+
+static void flush_memo(sw_ensemble_t *ensemble) {
+  fflush(ensemble->memo->file);
+}
+
+static void free_memo(member_memo_t *memo) {
+  fclose(memo->file);
+  kv_destroy(memo->contents);
+  kv_destroy(memo->name);
+  kh_destroy(memo_map, memo->records);
+  free(memo);
+}
+
+sw_write_result_t sw_ensemble_memoize(sw_ensemble_t *ensemble,
+                                      const char *memo_filename) {
+  sw_write_result_t result = {.error_code = SW_SUCCESS};
+  if (ensemble->memo) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message = "The ensemble's members are already memoized.";
+    return result;
+  }
+#ifdef SKYWALKER_HAVE_MPI
+  if (ensemble->comm != MPI_COMM_NULL) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      "The members of a distributed ensemble can't be memoized.";
+    return result;
+  }
+#endif
+  if (ensemble->position > 0) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      "Members can't be memoized during a traversal of the ensemble.";
+    return result;
+  }
+
+  // Read the memo file, if it exists.
+  char *contents = NULL;
+  size_t length = 0;
+  FILE *file = fopen(memo_filename, "r+b");
+  if (file) {
+    contents = read_file(file, &length);
+    if (!contents) {
+      fclose(file);
+      file = NULL;
+    }
+  } else {
+    file = fopen(memo_filename, "w+b");
+  }
+  if (!file) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "Could not read or write the memo file '%s'.",
+                  memo_filename);
+    return result;
+  }
+  const memo_header_t header = {.magic = "SWMEMO",
+                                .version = MEMO_FORMAT_VERSION,
+                                .real_size = sizeof(sw_real_t), .one = 1};
+  if ((length > 0) && ((length < sizeof(memo_header_t)) ||
+                       memcmp(contents, &header, sizeof(memo_header_t)))) {
+    free(contents);
+    fclose(file);
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "'%s' isn't a memo file written by Skywalker with %s "
+                  "precision.", memo_filename,
+                  (sizeof(sw_real_t) == 8) ? "double" : "single");
+    return result;
+  }
+
+  member_memo_t *memo = malloc(sizeof(member_memo_t));
+  memo->file = file;
+  kv_init(memo->contents);
+  memo->records = kh_init(memo_map);
+  memo->pending = SIZE_MAX;
+  kv_init(memo->name);
+  if (length == 0) {
+    memo_put(memo, &header, sizeof(memo_header_t));
+    fwrite(&header, 1, sizeof(memo_header_t), file);
+    free(contents);
+  } else {
+    memo->contents.a = contents;
+    memo->contents.n = length;
+    memo->contents.m = length + 1;
+
+    // Index the records. A record left incomplete by an interrupted run is
+    // discarded, so new ones are appended after the last complete one.
+    cache_reader_t reader = {.p = contents + sizeof(memo_header_t),
+                             .end = contents + length};
+    while (reader.p < reader.end) {
+      size_t offset = (size_t)(reader.p - contents);
+      uint64_t key = 0;
+      if (!skip_memo_record(&reader, &key)) {
+        memo->contents.n = offset;
+        truncate_file(file, offset);
+        break;
+      }
+      int ret;
+      khiter_t iter = kh_put(memo_map, memo->records, key, &ret);
+      kh_value(memo->records, iter) = offset;
+    }
+    fseek(file, 0, SEEK_END);
+  }
+
+  // Skywalker's own settings (like skywalker_profile) don't affect members'
+  // outputs, so they're left out of keys.
+  memo->settings_key[0] = memo->settings_key[1] = 0;
+  if (ensemble->settings) {
+    const char *name, *value;
+    kh_foreach(ensemble->settings->params, name, value,
+      if (strncmp(name, "skywalker_", 10)) {
+        for (int h = 0; h < 2; ++h)
+          memo->settings_key[h] += memo_hash(h, 's', name, value,
+                                             strlen(value));
+      }
+    );
+  }
+  ensemble->memo = memo;
+  return result;
+}
+
+//------------------------------------------------------------------------
+//                         NumPy archive (.npz) output
+//------------------------------------------------------------------------
+
+// A NumPy archive is a ZIP archive containing one .npy file per array. We
+// write it directly, using ZIP64 extensions for any array (or archive) too
+// large for the original ZIP format. Arrays are stored uncompressed, or (with
+// zlib) compressed with the deflate method, as numpy.savez_compressed does.
+
+// An entry in the archive's central directory.
+typedef struct npz_entry_t {
+  char *name;           // name of the file within the archive
+  uint64_t offset;      // offset of the file's local header
+  uint64_t size;        // size of the file's data
+  uint64_t stored_size; // size of the file's data as stored (compressed)
+  uint32_t crc;         // CRC-32 checksum of the file's data
+  bool compressed;      // true if the file's data are compressed
+} npz_entry_t;
+
+// This type writes arrays to a NumPy archive, one at a time.
+typedef struct npz_writer_t {
+  FILE *file;
+  uint64_t position;           // number of bytes written to the file
+  uint32_t crc_table[256];     // table for computing CRC-32 checksums
+  kvec_t(npz_entry_t) entries; // entries for the arrays written so far
+  fpos_t header_position;      // position of the current array's local header
+  uint64_t data_offset;        // offset of the current array's data
+  uint32_t crc;                // checksum of the current array's data
+  size_t real_size;            // size of each real value in the archive
+  bool compress;               // true if arrays are compressed
+  bool in_data;                // true while the current array's data is written
+  bool failed;                 // true if a write to the file failed
+#ifdef SKYWALKER_HAVE_ZLIB
+  z_stream stream;             // compressor for the current array's data
+  unsigned char *compressed;   // buffer for compressed data
+#endif
+} npz_writer_t;
+
+static const uint32_t zip_max_u32_ = 0xFFFFFFFF;
+
+// size of the buffer for compressed data
+static const size_t npz_buffer_size_ = 1 << 16;
+
+// Initializes a writer for an archive in the given file. Reals are stored at
+// full precision, and arrays are stored uncompressed, unless the writer's
+// real_size and compress fields are changed before arrays are written.
+static void npz_writer_init(npz_writer_t *writer, FILE *file) {
+  writer->file = file;
+  writer->position = 0;
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; ++k)
+      c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+    writer->crc_table[i] = c;
+  }
+  kv_init(writer->entries);
+  writer->crc = 0;
+  writer->real_size = sizeof(sw_real_t);
+  writer->compress = false;
+  writer->in_data = false;
+  writer->failed = false;
+#ifdef SKYWALKER_HAVE_ZLIB
+  writer->compressed = NULL;
+#endif
+}
+
+// Writes the given bytes to the archive's file.
+static void npz_put(npz_writer_t *writer, const void *data, size_t size) {
+  if (fwrite(data, 1, size, writer->file) != size)
+    writer->failed = true;
+  writer->position += size;
+}
+
+#ifdef SKYWALKER_HAVE_ZLIB
+// Compresses the given bytes of the current array's data, writing compressed
+// data to the archive as they're produced. flush is Z_FINISH to finish the
+// data, and Z_NO_FLUSH otherwise.
+static void npz_deflate(npz_writer_t *writer, const void *data, size_t size,
+                        int flush) {
+  z_stream *stream = &writer->stream;
+  stream->next_in = (Bytef*)data;
+  do {
+    // The compressor counts input bytes with (32-bit) unsigned ints.
+    size_t chunk_size = (size > UINT_MAX) ? UINT_MAX : size;
+    stream->avail_in = (uInt)chunk_size;
+    size -= chunk_size;
+    int chunk_flush = (size == 0) ? flush : Z_NO_FLUSH;
+    do {
+      stream->next_out = writer->compressed;
+      stream->avail_out = (uInt)npz_buffer_size_;
+      deflate(stream, chunk_flush);
+      npz_put(writer, writer->compressed,
+              npz_buffer_size_ - stream->avail_out);
+    } while (stream->avail_out == 0);
+  } while (size > 0);
+}
+#endif
+
+// Writes the given bytes to the archive, updating the checksum of the current
+// array's data (and compressing them, if the writer compresses arrays).
+static void npz_write(npz_writer_t *writer, const void *data, size_t size) {
+  if (size == 0) return;
+  if (writer->in_data) {
+    const unsigned char *bytes = data;
+    uint32_t crc = ~writer->crc;
+    for (size_t i = 0; i < size; ++i)
+      crc = writer->crc_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    writer->crc = ~crc;
+#ifdef SKYWALKER_HAVE_ZLIB
+    if (writer->compress) {
+      npz_deflate(writer, data, size, Z_NO_FLUSH);
+      return;
+    }
+#endif
+  }
+  npz_put(writer, data, size);
+}
+
+// These functions write little-endian integers into ZIP records.
+static unsigned char *put_u16(unsigned char *p, uint16_t value) {
+  for (int i = 0; i < 2; ++i) p[i] = (unsigned char)(value >> (8*i));
+  return p + 2;
+}
+
+static unsigned char *put_u32(unsigned char *p, uint32_t value) {
+  for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(value >> (8*i));
+  return p + 4;
+}
+
+static unsigned char *put_u64(unsigned char *p, uint64_t value) {
+  for (int i = 0; i < 8; ++i) p[i] = (unsigned char)(value >> (8*i));
+  return p + 8;
+}
+
+// Returns the ZIP version needed to extract an entry or archive.
+static uint16_t zip_version(bool zip64) {
+  return zip64 ? 45 : 20;
+}
+
+// Begins writing an array named group.name (with the given suffix) with the
+// given element type (a NumPy type descriptor), element size, and shape (of
+// the given rank) to the archive. The array's data must then be written (in C
+// order) with npz_write, followed by a call to npz_end_array.
+static void npz_begin_array(npz_writer_t *writer, const char *group,
+                            const char *name, const char *suffix,
+                            const char *descr, size_t item_size,
+                            int rank, const size_t *shape) {
+  // Build the .npy header, padded so the data is aligned to 64 bytes.
+  char header[256];
+  int length = snprintf(header, 256, "{'descr': '%s', 'fortran_order': False, "
+                        "'shape': (", descr);
+  uint64_t data_size = item_size;
+  for (int i = 0; i < rank; ++i) {
+    length += snprintf(&header[length], 256-length, "%s%zu",
+                       (i > 0) ? ", " : "", shape[i]);
+    data_size *= shape[i];
+  }
+  length += snprintf(&header[length], 256-length, "%s), }",
+                     (rank == 1) ? "," : "");
+  size_t preamble_length = 10, header_length = 64 *
+    ((preamble_length + length + 1 + 63) / 64) - preamble_length;
+  memset(&header[length], ' ', header_length - length - 1);
+  header[header_length - 1] = '\n';
+  data_size += preamble_length + header_length;
+
+  // Record the entry and write its local file header. Its checksum (and its
+  // compressed size) are filled in by npz_end_array. Compressed data can be a
+  // little larger than the data themselves.
+  npz_entry_t entry = {.offset = writer->position, .size = data_size,
+                       .stored_size = data_size,
+                       .compressed = writer->compress};
+  size_t name_length = strlen(group) + strlen(name) + strlen(suffix) + 5;
+  entry.name = malloc(name_length + 1);
+  snprintf(entry.name, name_length + 1, "%s.%s%s.npy", group, name, suffix);
+  kv_push(npz_entry_t, writer->entries, entry);
+  uint64_t max_stored_size = writer->compress ?
+                             data_size + (data_size >> 10) + 1024 : data_size;
+  bool zip64 = (max_stored_size >= zip_max_u32_);
+  unsigned char record[50], *p = record;
+  p = put_u32(p, 0x04034b50);         // local file header signature
+  p = put_u16(p, zip_version(zip64)); // version needed to extract
+  p = put_u16(p, 0);                  // flags
+  p = put_u16(p, writer->compress ? 8 : 0); // compression method
+  p = put_u16(p, 0);                  // modification time
+  p = put_u16(p, (1 << 5) | 1);       // modification date (1980-01-01)
+  p = put_u32(p, 0);                  // CRC-32 (filled in later)
+  p = put_u32(p, zip64 ? zip_max_u32_ : (uint32_t)data_size); // sizes
+  p = put_u32(p, zip64 ? zip_max_u32_ : (uint32_t)data_size);
+  p = put_u16(p, (uint16_t)name_length);
+  p = put_u16(p, zip64 ? 20 : 0);     // extra field length
+  if (fgetpos(writer->file, &writer->header_position))
+    writer->failed = true;
+  npz_write(writer, record, p - record);
+  npz_write(writer, entry.name, name_length);
+  if (zip64) {
+    p = record;
+    p = put_u16(p, 0x0001);           // ZIP64 extended information
+    p = put_u16(p, 16);
+    p = put_u64(p, data_size);
+    p = put_u64(p, data_size);
+    npz_write(writer, record, p - record);
+  }
+  writer->data_offset = writer->position;
+#ifdef SKYWALKER_HAVE_ZLIB
+  if (writer->compress) {
+    if (!writer->compressed) {
+      // Archives hold raw compressed data, without zlib's header.
+      writer->stream = (z_stream){.zalloc = Z_NULL};
+      deflateInit2(&writer->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                   -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+      writer->compressed = malloc(npz_buffer_size_);
+    } else {
+      deflateReset(&writer->stream);
+    }
+  }
+#endif
+
+  // Write the .npy preamble and header, which begin the entry's data.
+  writer->in_data = true;
+  writer->crc = 0;
+  unsigned char preamble[10] = {0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0};
+  put_u16(&preamble[8], (uint16_t)header_length);
+  npz_write(writer, preamble, preamble_length);
+  npz_write(writer, header, header_length);
+}
+
+// Finishes writing the current array to the archive.
+static void npz_end_array(npz_writer_t *writer) {
+  npz_entry_t *entry = &kv_A(writer->entries, kv_size(writer->entries)-1);
+#ifdef SKYWALKER_HAVE_ZLIB
+  if (entry->compressed)
+    npz_deflate(writer, NULL, 0, Z_FINISH);
+#endif
+  entry->crc = writer->crc;
+  entry->stored_size = writer->position - writer->data_offset;
+  writer->in_data = false;
+  assert(entry->compressed || (entry->stored_size == entry->size));
+
+  // Fill in the checksum and the compressed size (in the ZIP64 extra field,
+  // if the header has one).
+  size_t name_length = strlen(entry->name);
+  bool zip64 = (writer->data_offset - entry->offset > 30 + name_length);
+  unsigned char record[12], *p = record;
+  p = put_u32(p, entry->crc);
+  if (entry->compressed && !zip64)
+    p = put_u32(p, (uint32_t)entry->stored_size);
+  fpos_t end_position;
+  if (fgetpos(writer->file, &end_position) ||
+      fsetpos(writer->file, &writer->header_position) ||
+      fseek(writer->file, 14, SEEK_CUR) ||
+      (fwrite(record, 1, p - record, writer->file) != (size_t)(p - record)))
+    writer->failed = true;
+  if (entry->compressed && zip64) {
+    put_u64(record, entry->stored_size);
+    if (fseek(writer->file, (long)(30 + name_length + 12 - 18), SEEK_CUR) ||
+        (fwrite(record, 1, 8, writer->file) != 8))
+      writer->failed = true;
+  }
+  if (fsetpos(writer->file, &end_position))
+    writer->failed = true;
+}
+
+// Writes the archive's central directory, finishing the archive, and frees
+// the writer's resources. Returns true if the archive was written
+// successfully, false if not.
+static bool npz_writer_finish(npz_writer_t *writer) {
+  size_t num_entries = kv_size(writer->entries);
+  uint64_t directory_offset = writer->position;
+  unsigned char record[80], *p;
+  for (size_t i = 0; i < num_entries; ++i) {
+    npz_entry_t *entry = &kv_A(writer->entries, i);
+    bool large_size = (entry->size >= zip_max_u32_) ||
+                      (entry->stored_size >= zip_max_u32_);
+    bool large_offset = (entry->offset >= zip_max_u32_);
+    uint16_t extra_length = (large_size ? 16 : 0) + (large_offset ? 8 : 0);
+    if (extra_length > 0) extra_length += 4;
+    size_t name_length = strlen(entry->name);
+    p = record;
+    p = put_u32(p, 0x02014b50);       // central directory header signature
+    p = put_u16(p, zip_version(extra_length > 0)); // version made by
+    p = put_u16(p, zip_version(extra_length > 0)); // version needed to extract
+    p = put_u16(p, 0);                // flags
+    p = put_u16(p, entry->compressed ? 8 : 0); // compression method
+    p = put_u16(p, 0);                // modification time
+    p = put_u16(p, (1 << 5) | 1);     // modification date (1980-01-01)
+    p = put_u32(p, entry->crc);
+    p = put_u32(p, large_size ? zip_max_u32_ : (uint32_t)entry->stored_size);
+    p = put_u32(p, large_size ? zip_max_u32_ : (uint32_t)entry->size);
+    p = put_u16(p, (uint16_t)name_length);
+    p = put_u16(p, extra_length);
+    p = put_u16(p, 0);                // file comment length
+    p = put_u16(p, 0);                // disk number
+    p = put_u16(p, 0);                // internal file attributes
+    p = put_u32(p, 0);                // external file attributes
+    p = put_u32(p, large_offset ? zip_max_u32_ : (uint32_t)entry->offset);
+    npz_write(writer, record, p - record);
+    npz_write(writer, entry->name, name_length);
+    if (extra_length > 0) {
+      p = record;
+      p = put_u16(p, 0x0001);         // ZIP64 extended information
+      p = put_u16(p, extra_length - 4);
+      if (large_size) {
+        p = put_u64(p, entry->size);
+        p = put_u64(p, entry->stored_size);
+      }
+      if (large_offset) p = put_u64(p, entry->offset);
+      npz_write(writer, record, p - record);
+    }
+    free(entry->name);
+  }
+  uint64_t directory_size = writer->position - directory_offset;
+
+  bool zip64 = (num_entries >= 0xFFFF) || (directory_size >= zip_max_u32_) ||
+               (directory_offset >= zip_max_u32_);
+  if (zip64) {
+    uint64_t record_offset = writer->position;
+    p = record;
+    p = put_u32(p, 0x06064b50);       // ZIP64 end of central directory record
+    p = put_u64(p, 44);               // size of remaining record
+    p = put_u16(p, zip_version(true));
+    p = put_u16(p, zip_version(true));
+    p = put_u32(p, 0);                // disk number
+    p = put_u32(p, 0);                // disk with central directory
+    p = put_u64(p, num_entries);
+    p = put_u64(p, num_entries);
+    p = put_u64(p, directory_size);
+    p = put_u64(p, directory_offset);
+    p = put_u32(p, 0x07064b50);       // ZIP64 end of central directory locator
+    p = put_u32(p, 0);
+    p = put_u64(p, record_offset);
+    p = put_u32(p, 1);                // number of disks
+    npz_write(writer, record, p - record);
+  }
+  p = record;
+  p = put_u32(p, 0x06054b50);         // end of central directory record
+  p = put_u16(p, 0);                  // disk number
+  p = put_u16(p, 0);                  // disk with central directory
+  p = put_u16(p, zip64 ? 0xFFFF : (uint16_t)num_entries);
+  p = put_u16(p, zip64 ? 0xFFFF : (uint16_t)num_entries);
+  p = put_u32(p, zip64 ? zip_max_u32_ : (uint32_t)directory_size);
+  p = put_u32(p, zip64 ? zip_max_u32_ : (uint32_t)directory_offset);
+  p = put_u16(p, 0);                  // comment length
+  npz_write(writer, record, p - record);
+
+  kv_destroy(writer->entries);
+#ifdef SKYWALKER_HAVE_ZLIB
+  if (writer->compressed) {
+    deflateEnd(&writer->stream);
+    free(writer->compressed);
+  }
+#endif
+  return !writer->failed;
+}
+
+// Stores the NumPy type descriptor for values of the given type (f for
+// floating point, i for integer, U for Unicode strings) and size (in bytes,
+// or in characters for strings) in this machine's byte order.
+static void npy_descr(char type, size_t size, char descr[32]) {
+  const uint16_t one = 1;
+  char byte_order = (*(const char*)&one) ? '<' : '>';
+  snprintf(descr, 32, "%c%c%zu", byte_order, type, size);
+}
+
+// Begins writing an array of reals named group.name (with the given suffix)
+// with the given shape (of the given rank) to the archive, in the manner of
+// npz_begin_array. The array's values are then written with npz_write_reals.
+static void npz_begin_real_array(npz_writer_t *writer, const char *group,
+                                 const char *name, const char *suffix,
+                                 int rank, const size_t *shape) {
+  char descr[32];
+  npy_descr('f', writer->real_size, descr);
+  npz_begin_array(writer, group, name, suffix, descr, writer->real_size,
+                  rank, shape);
+}
+
+// Writes n reals to the current array, converting them to 32-bit floats if
+// the archive stores reals at reduced precision.
+static void npz_write_reals(npz_writer_t *writer, const sw_real_t *values,
+                            size_t n) {
+  if (writer->real_size == sizeof(sw_real_t)) {
+    npz_write(writer, values, sizeof(sw_real_t) * n);
+    return;
+  }
+  float buffer[1024];
+  for (size_t m = 0; m < n; m += 1024) {
+    size_t chunk_size = (n - m < 1024) ? n - m : 1024;
+    for (size_t i = 0; i < chunk_size; ++i)
+      buffer[i] = (float)values[m+i];
+    npz_write(writer, buffer, sizeof(float) * chunk_size);
+  }
+}
+
+// Writes a 1D array of n reals containing the values of the named input
+// parameter for the members of an ensemble to the given archive, or (once) a
+// 0D array containing its value.
+static void write_npz_input(npz_writer_t *writer, const char *name,
+                            const input_param_t *param, size_t n, bool once) {
+  if (once) {
+    npz_begin_real_array(writer, "input", name, "", 0, NULL);
+    npz_write_reals(writer, param->values, 1);
+    npz_end_array(writer);
+    return;
+  }
+  sw_real_t buffer[1024];
+  npz_begin_real_array(writer, "input", name, "", 1, &n);
+  for (size_t m = 0; m < n; m += 1024) {
+    size_t chunk_size = (n - m < 1024) ? n - m : 1024;
+    for (size_t i = 0; i < chunk_size; ++i)
+      buffer[i] = param->values[param_index(param, m+i)];
+    npz_write_reals(writer, buffer, chunk_size);
+  }
+  npz_end_array(writer);
+}
+
+// Writes the n arrays with the given sizes, with row i stored at rows[i], to
+// the given archive as an n x (maximum size) 2D array of reals named
+// group.name, padding short rows with NaN. If the arrays' sizes differ, they're
+// written to a second array named group.name.sizes.
+static void write_npz_rows(npz_writer_t *writer, const char *group,
+                           const char *name, size_t n, const sw_real_t **rows,
+                           const size_t *sizes) {
+  char descr[32];
+  size_t width = 0;
+  bool ragged = false;
+  for (size_t m = 0; m < n; ++m) {
+    if (sizes[m] > width) width = sizes[m];
+    if (sizes[m] != sizes[0]) ragged = true;
+  }
+  sw_real_t *padding = malloc(sizeof(sw_real_t) * (width + 1));
+  for (size_t j = 0; j < width; ++j)
+    padding[j] = NAN;
+  size_t shape[2] = {n, width};
+  npz_begin_real_array(writer, group, name, "", 2, shape);
+  for (size_t m = 0; m < n; ++m) {
+    npz_write_reals(writer, rows[m], sizes[m]);
+    npz_write_reals(writer, padding, width - sizes[m]);
+  }
+  npz_end_array(writer);
+  free(padding);
+
+  if (ragged) {
+    npy_descr('i', sizeof(int64_t), descr);
+    npz_begin_array(writer, group, name, ".sizes", descr, sizeof(int64_t), 1,
+                    &n);
+    for (size_t m = 0; m < n; ++m) {
+      int64_t size = (int64_t)sizes[m];
+      npz_write(writer, &size, sizeof(int64_t));
+    }
+    npz_end_array(writer);
+  }
+}
+
+// Writes the given ensemble's settings and inputs and the given outputs for
+// all of its members to a NumPy archive in the file with the given name, with
+// the given options.
+static sw_write_result_t write_npz_archive(sw_ensemble_t *ensemble,
+                                           const output_schema_t *schema,
+                                           const char *filename,
+                                           const sw_write_options_t *options) {
+  sw_write_result_t result = {.error_code = SW_SUCCESS};
+  if (ensemble->global_size == 0) {
+    result.error_code = SW_EMPTY_ENSEMBLE;
+    result.error_message = "The given ensemble is empty!";
+    return result;
+  }
+#ifndef SKYWALKER_HAVE_ZLIB
+  if (options->compress) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message = "NumPy archives can't be compressed: Skywalker "
+                           "was built without zlib (ENABLE_ZLIB).";
+    return result;
+  }
+#endif
+  FILE* file = fopen(filename, "wb");
+  if (!file) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "Could not write ensemble data to '%s'.", filename);
+    return result;
+  }
+  npz_writer_t writer;
+  npz_writer_init(&writer, file);
+  if ((options->precision > 0) && (options->precision <= 7))
+    writer.real_size = sizeof(float);
+  writer.compress = options->compress;
+  size_t n = ensemble->global_size;
+  char descr[32];
+
+  // Settings are stored as 0D arrays of Unicode strings.
+  if (ensemble->settings) {
+    khash_t(string_map) *settings = ensemble->settings->params;
+    const char *name, *value;
+    kh_foreach(settings, name, value,
+      if (!selects_quantity(options, "settings", name)) continue;
+      size_t length = strlen(value);
+      size_t num_chars = (length > 0) ? length : 1;
+      npy_descr('U', num_chars, descr);
+      npz_begin_array(&writer, "settings", name, "", descr, 4 * num_chars,
+                      0, NULL);
+      uint32_t c = 0;
+      for (size_t i = 0; i < length; ++i) {
+        c = (unsigned char)value[i];
+        npz_write(&writer, &c, 4);
+      }
+      if (length == 0) npz_write(&writer, &c, 4);
+      npz_end_array(&writer);
+    );
+  }
+
+  // Inputs.
+  const input_layout_t *layout = &ensemble->input_layout;
+  for (size_t h = 0; h < name_table_size(&layout->params); ++h) {
+    const char *name = kv_A(layout->params.names, h);
+    const input_param_t *param = &kv_A(layout->param_info, h);
+    if (selects_quantity(options, "input", name))
+      write_npz_input(&writer, name, param, n,
+                      writes_input_once(options, param));
+  }
+  const sw_real_t **rows = malloc(sizeof(sw_real_t*) * n);
+  size_t *sizes = malloc(sizeof(size_t) * n);
+  for (size_t h = 0; h < name_table_size(&layout->array_params); ++h) {
+    const char *name = kv_A(layout->array_params.names, h);
+    const input_param_t *param = &kv_A(layout->array_param_info, h);
+    if (!selects_quantity(options, "input", name)) continue;
+    // A parameter written once is a single row.
+    size_t num_rows = writes_input_once(options, param) ? 1 : n;
+    for (size_t m = 0; m < num_rows; ++m) {
+      const real_vec_t *array = &param->arrays[param_index(param, m)];
+      rows[m] = array->a;
+      sizes[m] = kv_size(*array);
+    }
+    write_npz_rows(&writer, "input", name, num_rows, rows, sizes);
+  }
+
+  // Outputs. Unset quantities are NaN (or empty, for arrays).
+  const output_index_t *index = schema->metrics.index;
+  for (size_t h = 0; h < schema->metrics.size; ++h) {
+    if (!selects_quantity(options, "output", index->names[h])) continue;
+    npz_begin_real_array(&writer, "output", index->names[h], "", 1, &n);
+    npz_write_reals(&writer, index->columns[h], n);
+    npz_end_array(&writer);
+  }
+  index = schema->array_metrics.index;
+  for (size_t h = 0; h < schema->array_metrics.size; ++h) {
+    if (!selects_quantity(options, "output", index->names[h])) continue;
+    const array_column_t *column = index->columns[h];
+    for (size_t m = 0; m < n; ++m)
+      rows[m] = array_column_row(column, m);
+    write_npz_rows(&writer, "output", index->names[h], n, rows,
+                   column->sizes);
+  }
+  free(rows);
+  free(sizes);
+
+  // Statistics (except the write time) are stored as 0D arrays.
+  if (ensemble->collect_stats) {
+    sw_ensemble_stats_t stats = ensemble_stats(ensemble);
+    const char *time_names[4] = {"parse_time", "build_time", "traversal_time",
+                                 "driver_time"};
+    double times[4] = {stats.parse_time, stats.build_time,
+                       stats.traversal_time, stats.driver_time};
+    npy_descr('f', sizeof(double), descr);
+    for (int i = 0; i < 4; ++i) {
+      npz_begin_array(&writer, "stats", time_names[i], "", descr,
+                      sizeof(double), 0, NULL);
+      npz_write(&writer, &times[i], sizeof(double));
+      npz_end_array(&writer);
+    }
+    const char *size_names[3] = {"input_bytes", "output_bytes",
+                                 "string_bytes"};
+    int64_t sizes[3] = {(int64_t)stats.input_bytes,
+                        (int64_t)stats.output_bytes,
+                        (int64_t)stats.string_bytes};
+    npy_descr('i', sizeof(int64_t), descr);
+    for (int i = 0; i < 3; ++i) {
+      npz_begin_array(&writer, "stats", size_names[i], "", descr,
+                      sizeof(int64_t), 0, NULL);
+      npz_write(&writer, &sizes[i], sizeof(int64_t));
+      npz_end_array(&writer);
+    }
+  }
+
+  bool succeeded = npz_writer_finish(&writer);
+  if (fclose(file) || !succeeded) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "Could not write ensemble data to '%s'.", filename);
+  }
+  return result;
+}
+
+// Writes the given ensemble's settings and inputs and the given outputs for
+// all of its members to the file with the given name with the given options.
+static sw_write_result_t write_module(sw_ensemble_t *ensemble,
+                                      const output_schema_t *schema,
+                                      const char *filename,
+                                      const sw_write_options_t *options) {
+  if (options->format == SW_NUMPY_ARCHIVE) {
+    return write_npz_archive(ensemble, schema, filename, options);
+  } else {
+    return write_py_module(ensemble, schema, filename, options);
+  }
+}
+
+#ifdef SKYWALKER_HAVE_MPI
+
+// A buffer of bytes for sending output data between processes.
+typedef kvec_t(char) byte_vec_t;
+
+// Appends the given data to the given buffer.
+static void pack_bytes(byte_vec_t *buffer, const void *data, size_t size) {
+  if (kv_size(*buffer) + size > kv_max(*buffer))
+    kv_resize(char, *buffer, 2 * kv_max(*buffer) + size);
+  memcpy(&buffer->a[kv_size(*buffer)], data, size);
+  kv_size(*buffer) += size;
+}
+
+// Copies data from the given position in a buffer, returning the position
+// that follows it.
+static const char *unpack_bytes(const char *position, void *data,
+                                size_t size) {
+  memcpy(data, position, size);
+  return position + size;
+}
+
+// Appends the names and values of all quantities in the given output schema
+// to the given buffer.
+static void pack_outputs(const output_schema_t *schema, byte_vec_t *buffer) {
+  size_t n = schema->num_members;
+  const output_index_t *index = schema->metrics.index;
+  uint64_t count = schema->metrics.size;
+  pack_bytes(buffer, &count, sizeof(uint64_t));
+  for (size_t h = 0; h < count; ++h) {
+    pack_bytes(buffer, index->names[h], strlen(index->names[h]) + 1);
+    pack_bytes(buffer, index->columns[h], sizeof(sw_real_t) * n);
+  }
+
+  index = schema->array_metrics.index;
+  count = schema->array_metrics.size;
+  pack_bytes(buffer, &count, sizeof(uint64_t));
+  for (size_t h = 0; h < count; ++h) {
+    const array_column_t *column = index->columns[h];
+    pack_bytes(buffer, index->names[h], strlen(index->names[h]) + 1);
+    for (size_t m = 0; m < n; ++m) {
+      uint64_t size = column->sizes[m];
+      pack_bytes(buffer, &size, sizeof(uint64_t));
+      if (size > 0)
+        pack_bytes(buffer, array_column_row(column, m),
+                   sizeof(sw_real_t) * size);
+    }
+  }
+}
+
+// Stores the outputs packed in the given buffer for members [offset, offset +
+// n) in the given output schema, registering quantities as needed.
+static void unpack_outputs(const char *buffer, size_t offset, size_t n,
+                           output_schema_t *schema) {
+  const char *p = buffer;
+  uint64_t count;
+  p = unpack_bytes(p, &count, sizeof(uint64_t));
+  for (size_t i = 0; i < count; ++i) {
+    const char *name = p;
+    p += strlen(name) + 1;
+    sw_handle_t h = output_schema_handle(schema, name);
+    sw_real_t *column = output_column(&schema->metrics, h);
+    p = unpack_bytes(p, &column[offset], sizeof(sw_real_t) * n);
+  }
+
+  real_vec_t values;
+  kv_init(values);
+  p = unpack_bytes(p, &count, sizeof(uint64_t));
+  for (size_t i = 0; i < count; ++i) {
+    const char *name = p;
+    p += strlen(name) + 1;
+    sw_handle_t h = output_schema_array_handle(schema, name);
+    for (size_t m = 0; m < n; ++m) {
+      uint64_t size;
+      p = unpack_bytes(p, &size, sizeof(uint64_t));
+      if (size > 0) { // members that didn't set the array are left unset
+        if (size > kv_max(values)) kv_resize(sw_real_t, values, size);
+        p = unpack_bytes(p, values.a, sizeof(sw_real_t) * size);
+        sw_output_t output = {.schema = schema, .index = offset + m};
+        sw_output_set_array_h(&output, h, values.a, size);
+      }
+    }
+  }
+  kv_destroy(values);
+}
+
+// Sends the contents of the given buffer to the given process.
+static void send_bytes(const byte_vec_t *buffer, int dest, MPI_Comm comm) {
+  uint64_t size = kv_size(*buffer);
+  MPI_Send(&size, 1, MPI_UINT64_T, dest, 0, comm);
+  for (size_t i = 0; i < size; i += INT_MAX) {
+    int chunk_size = (size - i < INT_MAX) ? (int)(size - i) : INT_MAX;
+    MPI_Send(&buffer->a[i], chunk_size, MPI_BYTE, dest, 0, comm);
+  }
+}
+
+// Receives a buffer sent by the given process with send_bytes, returning a
+// newly-allocated copy of its contents.
+static char *receive_bytes(int source, MPI_Comm comm) {
+  uint64_t size;
+  MPI_Recv(&size, 1, MPI_UINT64_T, source, 0, comm, MPI_STATUS_IGNORE);
+  char *buffer = malloc(size + 1);
+  for (size_t i = 0; i < size; i += INT_MAX) {
+    int chunk_size = (size - i < INT_MAX) ? (int)(size - i) : INT_MAX;
+    MPI_Recv(&buffer[i], chunk_size, MPI_BYTE, source, 0, comm,
+             MPI_STATUS_IGNORE);
+  }
+  return buffer;
+}
+
+// Gathers the outputs of an ensemble distributed across processes to the
+// first process, which writes them to the file with the given name with the
+// given options. The result of the write is shared with all processes.
+static sw_write_result_t write_distributed_module(
+  sw_ensemble_t *ensemble, const char *filename,
+  const sw_write_options_t *options) {
+  MPI_Comm comm = ensemble->comm;
+  int rank, num_ranks;
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &num_ranks);
+
+  sw_write_result_t result = {.error_code = SW_SUCCESS};
+  byte_vec_t buffer;
+  kv_init(buffer);
+  pack_outputs(&ensemble->output_schema, &buffer);
+  if (rank == 0) {
+    // Assemble the outputs for the whole ensemble, one process at a time.
+    output_schema_t schema;
+    output_schema_init(&schema, ensemble->global_size);
+    unpack_outputs(buffer.a, ensemble->offset, ensemble->size, &schema);
+    for (int r = 1; r < num_ranks; ++r) {
+      size_t offset, size;
+      partition_ensemble(ensemble->global_size, (size_t)r, (size_t)num_ranks,
+                         &offset, &size);
+      char *bytes = receive_bytes(r, comm);
+      unpack_outputs(bytes, offset, size, &schema);
+      free(bytes);
     }
+    result = write_module(ensemble, &schema, filename, options);
+    output_schema_destroy(&schema);
   } else {
-    result.error_code = data.error_code;
-    result.error_message = data.error_message;
+    send_bytes(&buffer, 0, comm);
   }
+  kv_destroy(buffer);
+
+  // Share the result with the other processes.
+  MPI_Bcast(&result.error_code, 1, MPI_INT, 0, comm);
+  if (result.error_code != SW_SUCCESS) {
+    int length = (rank == 0) ? (int)strlen(result.error_message) + 1 : 0;
+    MPI_Bcast(&length, 1, MPI_INT, 0, comm);
+    char *message = malloc(length);
+    if (rank == 0) memcpy(message, result.error_message, length);
+    MPI_Bcast(message, length, MPI_CHAR, 0, comm);
+    if (rank != 0)
+      result.error_message = pool_string(ensemble->strings, message);
+    free(message);
+  }
+  return result;
+}
 
-  // Clean up.
-  free_yaml_data(data);
-  free_yaml_strings(); // delete YAML string pool
+#endif
 
-  return result;
+sw_write_result_t sw_ensemble_write(sw_ensemble_t *ensemble,
+                                    const char *module_filename) {
+  // Files ending in .npz are written as NumPy archives.
+  size_t length = strlen(module_filename);
+  sw_write_format_t format = SW_PYTHON_MODULE;
+  if ((length >= 4) && !strcmp(&module_filename[length-4], ".npz"))
+    format = SW_NUMPY_ARCHIVE;
+  return sw_ensemble_write_format(ensemble, module_filename, format);
 }
 
-size_t sw_ensemble_size(sw_ensemble_t* ensemble) {
-  return ensemble->size;
+sw_write_result_t sw_ensemble_write_format(sw_ensemble_t *ensemble,
+                                           const char *filename,
+                                           sw_write_format_t format) {
+  sw_write_options_t options = default_write_options_;
+  options.format = format;
+  return sw_ensemble_write_options(ensemble, filename, &options);
 }
 
-bool sw_ensemble_next(sw_ensemble_t *ensemble,
-                      sw_input_t **input,
-                      sw_output_t **output) {
-  if (ensemble->position >= (int)ensemble->size) {
-    ensemble->position = 0; // reset for next traversal
-    *input = NULL;
-    *output = NULL;
-    return false;
+sw_write_result_t sw_ensemble_write_options(sw_ensemble_t *ensemble,
+                                            const char *filename,
+                                            const sw_write_options_t *options) {
+  sw_write_format_t format = options->format;
+  if ((format != SW_PYTHON_MODULE) && (format != SW_NUMPY_ARCHIVE)) {
+    sw_write_result_t result = {.error_code = SW_WRITE_FAILURE};
+    result.error_message = pool_format(ensemble->strings,
+                                       "Invalid write format: %d", (int)format);
+    return result;
+  }
+  if (ensemble->stream && (options->quantities ||
+                           options->fixed_inputs_once ||
+                           options->precision || options->compress)) {
+    sw_write_result_t result = {.error_code = SW_WRITE_FAILURE};
+    result.error_message =
+      pool_format(ensemble->strings,
+                  "The ensemble's outputs were streamed to '%s', so write "
+                  "options can't be applied to them.",
+                  ensemble->stream->filename);
+    return result;
   }
+  double start = sw_clock();
+  sw_write_result_t result;
+  if (ensemble->stream)
+    result = write_streamed_module(ensemble, filename, format);
+#ifdef SKYWALKER_HAVE_MPI
+  else if (ensemble->comm != MPI_COMM_NULL)
+    result = write_distributed_module(ensemble, filename, options);
+#endif
+  else
+    result = write_module(ensemble, &ensemble->output_schema, filename,
+                          options);
+  ensemble->stats.write_time += sw_clock() - start;
+  return result;
+}
 
-  *input = &ensemble->inputs[ensemble->position];
-  *output = &ensemble->outputs[ensemble->position];
-  ++ensemble->position;
-  return true;
+void sw_ensemble_free(sw_ensemble_t *ensemble) {
+#ifdef SKYWALKER_HAVE_MPI
+  if (ensemble->comm != MPI_COMM_NULL) {
+    int finalized;
+    MPI_Finalized(&finalized);
+    if (!finalized) MPI_Comm_free(&ensemble->comm);
+  }
+#endif
+  if (ensemble->stream) {
+    // An unfinished stream is left as an interrupted program would leave it,
+    // so it can be restarted.
+    if (ensemble->stream->file) close_stream(ensemble->stream);
+    free((char*)ensemble->stream->filename);
+    free(ensemble->stream);
+  }
+  if (ensemble->memo)
+    free_memo(ensemble->memo);
+  if (ensemble->settings)
+    sw_settings_free(ensemble->settings);
+  if (ensemble->batch)
+    batch_free(ensemble->batch);
+  free(ensemble->inputs);
+  free(ensemble->outputs);
+  output_schema_destroy(&ensemble->output_schema);
+  input_layout_destroy(&ensemble->input_layout);
+  free_yaml_data(ensemble->data);
+  string_pool_free(ensemble->strings);
+  free(ensemble);
 }
 
-// We use this to sort input and output quantity names.
-static int string_cmp(const void *s1, const void *s2) {
-  return strcmp(*(const char**)s1, *(const char**)s2);
+//------------------------------------------------------------------------
+//                 NumPy archive (.npz) merging and slicing
+//------------------------------------------------------------------------
+
+// Archives are merged and sliced without loading their arrays: each archive
+// is mapped into memory, and the arrays' data are copied from the mappings
+// into the new archive, so only the pages being copied need to be resident.
+
+// An array in a mapped NumPy archive.
+typedef struct npz_array_t {
+  char *name;                // name of the array (its .npy file, less ".npy")
+  npy_header_t header;       // the array's .npy header
+  const unsigned char *data; // the array's data
+  size_t item_size;          // size of each of the array's elements
+  bool is_sizes;             // true for the row sizes of a 2D array
+  bool is_fixed;             // true for an input written once for all members
+} npz_array_t;
+
+// A NumPy archive mapped into memory.
+typedef struct npz_archive_t {
+  const char *filename;
+  void *map;
+  size_t map_length;
+  kvec_t(npz_array_t) arrays;
+  size_t num_members; // number of members whose data the archive holds
+} npz_archive_t;
+
+// These functions read little-endian integers from ZIP records.
+static uint64_t get_u16(const unsigned char *p) {
+  return (uint64_t)p[0] | ((uint64_t)p[1] << 8);
 }
 
-sw_write_result_t sw_ensemble_write(sw_ensemble_t *ensemble,
-                                    const char *module_filename) {
-  const char *float_format = 4<sizeof(sw_real_t) ? "%.10g, " : "%.6g, ";
-  sw_write_result_t result = {.error_code = SW_SUCCESS};
-  if (ensemble->size == 0) {
-    result.error_code = SW_EMPTY_ENSEMBLE;
-    result.error_message = new_string("The given ensemble is empty!");
-    return result;
-  }
-  FILE* file = fopen(module_filename, "w");
-  if (!file) {
-    result.error_code = SW_WRITE_FAILURE;
-    result.error_message = new_string("Could not write ensemble data to '%s'.",
-                                      module_filename);
-    return result;
+static uint64_t get_u32(const unsigned char *p) {
+  return get_u16(p) | (get_u16(p+2) << 16);
+}
+
+static uint64_t get_u64(const unsigned char *p) {
+  return get_u32(p) | (get_u32(p+4) << 32);
+}
+
+// Returns the size of an element with the given NumPy type descriptor.
+static size_t npy_item_size(const char *descr) {
+  size_t size = (size_t)strtoul(&descr[2], NULL, 10);
+  return (descr[1] == 'U') ? 4 * size : size;
+}
+
+// Returns the array with the given name in the given archive, or NULL if the
+// archive has no such array.
+static const npz_array_t *find_npz_array(const npz_archive_t *archive,
+                                         const char *name) {
+  for (size_t i = 0; i < kv_size(archive->arrays); ++i) {
+    if (!strcmp(kv_A(archive->arrays, i).name, name))
+      return &kv_A(archive->arrays, i);
   }
-  fprintf(file, "# This file was automatically generated by skywalker.\n\n");
-  fprintf(file, "from math import nan as nan, inf as inf\n\n");
-  fprintf(file,
-      "# Object is just a dynamic container that stores input/output data.\n");
-  fprintf(file, "class Object(object):\n");
-  fprintf(file, "    pass\n\n");
+  return NULL;
+}
 
-  // Write settings (if present), sorted by name.
-  if (ensemble->settings) {
-    fprintf(file, "# Settings are stored here.\n");
-    fprintf(file, "settings = Object()\n");
-    khash_t(string_map) *settings = ensemble->settings->params;
-    size_t num_settings = kh_size(settings);
-    const char **setting_names = malloc(sizeof(const char*) * num_settings);
-    size_t i = 0;
-    for (khiter_t iter = kh_begin(settings); iter != kh_end(settings); ++iter) {
-      if (!kh_exist(settings, iter)) continue;
-      setting_names[i++] = kh_key(settings, iter);
-    }
-    qsort(setting_names, num_settings, sizeof(const char*), string_cmp);
+// Unmaps the given archive and frees its resources.
+static void close_npz_archive(npz_archive_t *archive) {
+  for (size_t i = 0; i < kv_size(archive->arrays); ++i)
+    free(kv_A(archive->arrays, i).name);
+  kv_destroy(archive->arrays);
+  unmap_file(archive->map, archive->map_length);
+  archive->map = NULL;
+}
 
-    for (i = 0; i < num_settings; ++i) {
-      const char *name = setting_names[i];
-      khiter_t iter = kh_get(string_map, settings, name);
-      const char* value = kh_val(settings, iter);
-      fprintf(file, "settings.%s = '%s'\n", name, value);
+// Reads the directory of the archive in the file with the given name, mapping
+// it into memory. Returns an error message (in the global string pool) if the
+// file isn't a NumPy archive holding ensemble data, or NULL on success.
+static const char *open_npz_archive(const char *filename,
+                                    npz_archive_t *archive) {
+  *archive = (npz_archive_t){.filename = filename};
+  kv_init(archive->arrays);
+  const char *message = map_file(filename, &archive->map,
+                                 &archive->map_length);
+  if (message) return message;
+  const unsigned char *map = archive->map;
+  size_t length = archive->map_length;
+
+  // Find the end of central directory record, which is followed only by the
+  // archive's comment.
+  const unsigned char *end = NULL;
+  for (size_t i = 22; (i <= length) && (i <= 22 + 0xFFFF) && !end; ++i) {
+    if (get_u32(&map[length - i]) == 0x06054b50)
+      end = &map[length - i];
+  }
+  if (!end) {
+    close_npz_archive(archive);
+    return new_string("The file '%s' is not a NumPy archive.", filename);
+  }
+  uint64_t num_entries = get_u16(&end[10]);
+  uint64_t directory_size = get_u32(&end[12]);
+  uint64_t directory_offset = get_u32(&end[16]);
+  if (((num_entries == 0xFFFF) || (directory_size == zip_max_u32_) ||
+       (directory_offset == zip_max_u32_)) &&
+      (end - map >= 20) && (get_u32(end - 20) == 0x07064b50)) {
+    // Read the ZIP64 end of central directory record.
+    uint64_t record_offset = get_u64(end - 12);
+    if (record_offset + 56 <= length) {
+      const unsigned char *record = &map[record_offset];
+      if (get_u32(record) == 0x06064b50) {
+        num_entries = get_u64(&record[32]);
+        directory_size = get_u64(&record[40]);
+        directory_offset = get_u64(&record[48]);
+      }
     }
-    free(setting_names);
   }
 
-  // Write input data, sorted by quantity name.
-  {
-    fprintf(file, "# Input is stored here.\n");
-    fprintf(file, "input = Object()\n");
-    khash_t(param_map) *params_0 = ensemble->inputs[0].params;
-    size_t num_inputs = kh_size(params_0);
-    const char **input_names = malloc(sizeof(const char*) * num_inputs);
-    size_t i = 0;
-    for (khiter_t iter = kh_begin(params_0); iter != kh_end(params_0); ++iter) {
-      if (!kh_exist(params_0, iter)) continue;
-      input_names[i++] = kh_key(params_0, iter);
+  // Read the central directory, finding each array's data.
+  const char *problem = NULL;
+  if ((directory_offset > length) ||
+      (directory_size > length - directory_offset))
+    problem = "has a truncated directory";
+  const unsigned char *p = &map[directory_offset];
+  const unsigned char *directory_end = p + directory_size;
+  for (uint64_t i = 0; (i < num_entries) && !problem; ++i) {
+    if ((directory_end - p < 46) || (get_u32(p) != 0x02014b50)) {
+      problem = "has an invalid directory";
+      break;
+    }
+    uint64_t size = get_u32(&p[20]);
+    size_t name_length = get_u16(&p[28]), extra_length = get_u16(&p[30]);
+    size_t comment_length = get_u16(&p[32]);
+    uint64_t offset = get_u32(&p[42]);
+    const unsigned char *name = &p[46], *extra = name + name_length;
+    if ((size_t)(directory_end - name) <
+        name_length + extra_length + comment_length) {
+      problem = "has an invalid directory";
+      break;
+    }
+    if (get_u16(&p[10]) != 0) {
+      problem = "contains compressed arrays";
+      break;
     }
-    qsort(input_names, num_inputs, sizeof(const char*), string_cmp);
 
-    for (i = 0; i < num_inputs; ++i) {
-      const char *name = input_names[i];
-      fprintf(file, "input.%s = [", name);
-      for (size_t i = 0; i < ensemble->size; ++i) {
-        khash_t(param_map) *params_i = ensemble->inputs[i].params;
-        khiter_t iter = kh_get(param_map, params_i, name);
-        sw_real_t value = kh_val(params_i, iter);
-        fprintf(file, float_format, value);
+    // Sizes and offsets too large for 32 bits are in a ZIP64 extra field.
+    for (const unsigned char *e = extra; e + 4 <= extra + extra_length;
+         e += 4 + get_u16(&e[2])) {
+      if (get_u16(e) != 0x0001) continue;
+      const unsigned char *field = &e[4], *field_end = field + get_u16(&e[2]);
+      if ((get_u32(&p[24]) == zip_max_u32_) && (field + 8 <= field_end))
+        field += 8; // uncompressed size (equal to the stored size)
+      if ((size == zip_max_u32_) && (field + 8 <= field_end)) {
+        size = get_u64(field);
+        field += 8;
       }
-      fprintf(file, "]\n");
+      if ((offset == zip_max_u32_) && (field + 8 <= field_end))
+        offset = get_u64(field);
     }
-    free(input_names);
 
-    khash_t(array_param_map) *array_params_0 = ensemble->inputs[0].array_params;
-    size_t num_array_inputs = kh_size(array_params_0);
-    const char **array_input_names = malloc(sizeof(const char*) * num_array_inputs);
-    i = 0;
-    for (khiter_t iter = kh_begin(array_params_0); iter != kh_end(array_params_0); ++iter) {
-      if (!kh_exist(array_params_0, iter)) continue;
-      array_input_names[i++] = kh_key(array_params_0, iter);
+    // Each entry's data follow its local header.
+    if ((offset > length) || (length - offset < 30) ||
+        (get_u32(&map[offset]) != 0x04034b50)) {
+      problem = "has an invalid directory";
+      break;
     }
-    qsort(array_input_names, num_array_inputs, sizeof(const char*), string_cmp);
-
-    for (i = 0; i < num_array_inputs; ++i) {
-      const char *name = array_input_names[i];
-      fprintf(file, "input.%s = [", name);
-      for (size_t i = 0; i < ensemble->size; ++i) {
-        khash_t(array_param_map) *array_params_i = ensemble->inputs[i].array_params;
-        khiter_t iter = kh_get(array_param_map, array_params_i, name);
-        real_vec_t arrays = kh_val(array_params_i, iter);
-        size_t size = kv_size(arrays);
-        fprintf(file, "[");
-        for (size_t i=0; i<size; ++i)
-          fprintf(file, float_format, kv_A(arrays, i));
-        fprintf(file, "],");
-      }
-      fprintf(file, "]\n");
+    uint64_t data_offset = offset + 30 + get_u16(&map[offset + 26]) +
+                           get_u16(&map[offset + 28]);
+    if ((data_offset > length) || (size > length - data_offset)) {
+      problem = "is truncated";
+      break;
+    }
+    if ((name_length <= 4) ||
+        strncmp((const char*)&name[name_length - 4], ".npy", 4)) {
+      problem = "contains a file that isn't a NumPy array";
+      break;
+    }
+    npz_array_t array = {.data = &map[data_offset]};
+    const char *npy_message = read_npy_header(array.data, (size_t)size,
+                                              &array.header);
+    if (npy_message) {
+      problem = "contains an invalid NumPy array";
+      break;
+    }
+    array.name = malloc(name_length - 3);
+    memcpy(array.name, name, name_length - 4);
+    array.name[name_length - 4] = '\0';
+    array.data += array.header.offset;
+    array.item_size = npy_item_size(array.header.descr);
+    size_t num_items = 1;
+    for (int r = 0; r < array.header.rank; ++r)
+      num_items *= array.header.shape[r];
+    kv_push(npz_array_t, archive->arrays, array);
+    if ((array.header.rank > 2) || array.header.fortran_order) {
+      problem = "contains an array that isn't a 0D, 1D, or (C-ordered) 2D "
+                "array";
+    } else if ((size - array.header.offset) / array.item_size < num_items) {
+      problem = "contains a truncated array";
     }
-    free(array_input_names);
+    p = extra + extra_length + comment_length;
   }
 
-  // Write output data, sorted by quantity name.
-  fprintf(file, "\n# Output data is stored here.\n");
-  fprintf(file, "output = Object()\n");
-  if (ensemble->size > 0) {
-    khash_t(param_map) *params_0 = ensemble->outputs[0].metrics;
-    size_t num_outputs = kh_size(params_0);
-    const char **output_names = malloc(sizeof(const char*) * num_outputs);
-    size_t i = 0;
-    for (khiter_t iter = kh_begin(params_0); iter != kh_end(params_0); ++iter) {
-      if (!kh_exist(params_0, iter)) continue;
-      output_names[i++] = kh_key(params_0, iter);
+  // Every input and output array has one element (or row) per member, except
+  // for inputs written once for all members (as 0D arrays, or 2D arrays with
+  // one row).
+  for (size_t i = 0; (i < kv_size(archive->arrays)) && !problem; ++i) {
+    npz_array_t *array = &kv_A(archive->arrays, i);
+    if (!strchr(array->name, '.') || (array->name[0] == '.')) {
+      problem = "contains an array with an invalid name";
+    } else if (!strncmp(array->name, "input.", 6) ||
+               !strncmp(array->name, "output.", 7)) {
+      if ((array->header.rank > 0) &&
+          (array->header.shape[0] > archive->num_members))
+        archive->num_members = array->header.shape[0];
+    } else if (array->header.rank != 0) {
+      // Settings and statistics are 0D arrays.
+      problem = "contains a setting that isn't a 0D array";
+    }
+  }
+  for (size_t i = 0; (i < kv_size(archive->arrays)) && !problem; ++i) {
+    npz_array_t *array = &kv_A(archive->arrays, i);
+    bool is_input = !strncmp(array->name, "input.", 6);
+    if (!is_input && strncmp(array->name, "output.", 7))
+      continue;
+
+    // An array of row sizes (if any) follows its rows.
+    size_t name_length = strlen(array->name);
+    if ((name_length > 6) && !strcmp(&array->name[name_length - 6], ".sizes")) {
+      array->name[name_length - 6] = '\0';
+      const npz_array_t *rows = find_npz_array(archive, array->name);
+      array->is_sizes = (rows && (rows->header.rank == 2));
+      array->name[name_length - 6] = '.';
+      char descr[32];
+      npy_descr('i', sizeof(int64_t), descr);
+      if (array->is_sizes && (strcmp(array->header.descr, descr) ||
+                              (array->header.rank != 1)))
+        problem = "has invalid row sizes";
+    }
+    if (array->header.rank == 0) {
+      array->is_fixed = is_input;
+      if (!is_input) problem = "contains an output quantity with no members";
+    } else if (array->header.shape[0] != archive->num_members) {
+      array->is_fixed = is_input && (array->header.rank == 2) &&
+                        (array->header.shape[0] == 1);
+      if (!array->is_fixed)
+        problem = "contains arrays for different numbers of members";
     }
-    qsort(output_names, num_outputs, sizeof(const char*), string_cmp);
+    if ((array->header.rank == 2) && (array->header.descr[1] != 'f'))
+      problem = "contains a 2D array that isn't floating point";
+  }
+  if ((archive->num_members == 0) && !problem)
+    problem = "contains no data for individual members";
+  if (problem) {
+    close_npz_archive(archive);
+    return new_string("The NumPy archive '%s' %s.", filename, problem);
+  }
+  return NULL;
+}
 
-    for (i = 0; i < num_outputs; ++i) {
-      const char *name = output_names[i];
-      fprintf(file, "output.%s = [", name);
-      for (size_t i = 0; i < ensemble->size; ++i) {
-        khash_t(param_map) *params_i = ensemble->outputs[i].metrics;
-        khiter_t iter = kh_get(param_map, params_i, name);
-        sw_real_t value = kh_val(params_i, iter);
-        if (isnan(value)) {
-          fprintf(file, "nan, ");
-        } else {
-          fprintf(file, float_format, value);
-        }
+// Returns true if the given array holds a setting (or a statistic), and false
+// if it holds an input parameter or output quantity.
+static bool is_npz_setting(const npz_array_t *array) {
+  return strncmp(array->name, "input.", 6) &&
+         strncmp(array->name, "output.", 7);
+}
+
+// Returns true if the given arrays, both written once for all members, hold
+// the same values.
+static bool npz_fixed_arrays_equal(const npz_array_t *a,
+                                   const npz_array_t *b) {
+  size_t size = a->item_size * ((a->header.rank == 2) ? a->header.shape[1] : 1);
+  return (a->header.rank == b->header.rank) &&
+         ((a->header.rank != 2) || (a->header.shape[1] == b->header.shape[1])) &&
+         !memcmp(a->data, b->data, size);
+}
+
+// Writes n elements of NaN with the given size (4 or 8 bytes) to the given
+// archive.
+static void write_npz_nans(npz_writer_t *writer, size_t item_size, size_t n) {
+  static const float float_nan = NAN;
+  static const double double_nan = NAN;
+  const void *nan = (item_size == sizeof(float)) ? (const void*)&float_nan :
+                                                   (const void*)&double_nan;
+  for (size_t i = 0; i < n; ++i)
+    npz_write(writer, nan, item_size);
+}
+
+// Returns the size of row m of the given 2D array, whose row sizes (if they
+// differ) are in the given array.
+static size_t npz_row_size(const npz_array_t *rows, const npz_array_t *sizes,
+                           size_t m) {
+  size_t width = rows->header.shape[1];
+  if (sizes) {
+    int64_t size;
+    memcpy(&size, &sizes->data[sizeof(int64_t) * m], sizeof(int64_t));
+    return (size < 0) ? 0 : ((uint64_t)size < width) ? (size_t)size : width;
+  } else {
+    return width;
+  }
+}
+
+// Writes a new NumPy archive to the file with the given name containing the
+// data for members [begins[i], ends[i]) of each of the given archives, in
+// order. The archives must hold data for ensembles with the same settings,
+// input parameters, and output quantities. Array rows are padded to the length
+// of the longest row in the new archive. Statistics (which describe the runs
+// that wrote the archives) are left out.
+static sw_write_result_t write_combined_archive(size_t num_archives,
+                                                const npz_archive_t *archives,
+                                                const size_t *begins,
+                                                const size_t *ends,
+                                                const char *filename) {
+  sw_write_result_t result = {.error_code = SW_SUCCESS};
+
+  // Make sure the archives hold the same data, finding the arrays in the
+  // first one.
+  const npz_archive_t *first = &archives[0];
+  kvec_t(const npz_array_t*) arrays;
+  kv_init(arrays);
+  for (size_t i = 0; i < kv_size(first->arrays); ++i) {
+    const npz_array_t *array = &kv_A(first->arrays, i);
+    if (!array->is_sizes && strncmp(array->name, "stats.", 6))
+      kv_push(const npz_array_t*, arrays, array);
+  }
+  for (size_t a = 1; a < num_archives; ++a) {
+    const npz_archive_t *archive = &archives[a];
+    size_t num_arrays = 0;
+    for (size_t i = 0; i < kv_size(archive->arrays); ++i) {
+      const npz_array_t *array = &kv_A(archive->arrays, i);
+      if (!array->is_sizes && strncmp(array->name, "stats.", 6))
+        ++num_arrays;
+    }
+    const char *problem = NULL, *name = NULL;
+    if (num_arrays != kv_size(arrays))
+      problem = "has different settings, inputs, or outputs than";
+    for (size_t i = 0; (i < kv_size(arrays)) && !problem; ++i) {
+      const npz_array_t *array0 = kv_A(arrays, i);
+      const npz_array_t *array = find_npz_array(archive, array0->name);
+      name = array0->name;
+      if (!array) {
+        problem = "is missing an array found in";
+      } else if (is_npz_setting(array0) &&
+                 ((array->header.rank != 0) ||
+                  strcmp(array->header.descr, array0->header.descr) ||
+                  memcmp(array->data, array0->data, array0->item_size))) {
+        problem = "has a different setting than";
+      } else if (strcmp(array->header.descr, array0->header.descr) ||
+                 ((array->header.rank == 2) != (array0->header.rank == 2))) {
+        problem = "has a different type of array than";
       }
-      fprintf(file, "]\n");
     }
-    free(output_names);
+    if (problem) {
+      result.error_code = SW_INVALID_ARCHIVE;
+      result.error_message = name ?
+        new_string("The NumPy archive '%s' %s '%s' ('%s').",
+                   archive->filename, problem, first->filename, name) :
+        new_string("The NumPy archive '%s' %s '%s'.", archive->filename,
+                   problem, first->filename);
+      kv_destroy(arrays);
+      return result;
+    }
+  }
+  size_t n = 0;
+  for (size_t a = 0; a < num_archives; ++a)
+    n += ends[a] - begins[a];
+  if (n == 0) {
+    result.error_code = SW_EMPTY_ENSEMBLE;
+    result.error_message = new_string("The NumPy archive '%s' would have no "
+                                      "members!", filename);
+    kv_destroy(arrays);
+    return result;
+  }
 
-    khash_t(array_param_map) *array_params_0 = ensemble->outputs[0].array_metrics;
-    size_t num_array_outputs = kh_size(array_params_0);
-    const char **array_output_names = malloc(sizeof(const char*) * num_array_outputs);
-    i = 0;
-    for (khiter_t iter = kh_begin(array_params_0); iter != kh_end(array_params_0); ++iter) {
-      if (!kh_exist(array_params_0, iter)) continue;
-      array_output_names[i++] = kh_key(array_params_0, iter);
+  FILE* file = fopen(filename, "wb");
+  if (!file) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message = new_string("Could not write ensemble data to '%s'.",
+                                      filename);
+    kv_destroy(arrays);
+    return result;
+  }
+  npz_writer_t writer;
+  npz_writer_init(&writer, file);
+  const npz_array_t **sources = malloc(2 * num_archives *
+                                       sizeof(npz_array_t*));
+  const npz_array_t **source_sizes = &sources[num_archives];
+  for (size_t i = 0; i < kv_size(arrays); ++i) {
+    const npz_array_t *array0 = kv_A(arrays, i);
+    const npy_header_t *header = &array0->header;
+    size_t item_size = array0->item_size;
+
+    // An input written once for all members of every archive is written once
+    // (if its values agree). Otherwise, those written once are repeated for
+    // each member.
+    bool fixed = !is_npz_setting(array0);
+    for (size_t a = 0; a < num_archives; ++a) {
+      sources[a] = find_npz_array(&archives[a], array0->name);
+      source_sizes[a] = NULL;
+      fixed = fixed && sources[a]->is_fixed &&
+              npz_fixed_arrays_equal(sources[a], array0);
     }
-    qsort(array_output_names, num_array_outputs, sizeof(const char*), string_cmp);
 
-    for (i = 0; i < num_array_outputs; ++i) {
-      const char *name = array_output_names[i];
-      fprintf(file, "output.%s = [", name);
-      for (size_t i = 0; i < ensemble->size; ++i) {
-        khash_t(array_param_map) *array_params_i = ensemble->outputs[i].array_metrics;
-        khiter_t iter = kh_get(array_param_map, array_params_i, name);
-        real_vec_t arrays = kh_val(array_params_i, iter);
-        size_t size = kv_size(arrays);
-        fprintf(file, "[");
-        for (size_t i=0; i<size; ++i) {
-          if (isnan(kv_A(arrays, i))) {
-            fprintf(file, "nan, ");
-          } else {
-            fprintf(file, float_format, kv_A(arrays, i));
+    // Each array's name is group.name.
+    size_t name_length = strlen(array0->name);
+    char *group = malloc(name_length + 8);
+    memcpy(group, array0->name, name_length + 1);
+    char *name = strchr(group, '.');
+    *name++ = '\0';
+
+    if (is_npz_setting(array0) || (fixed && (header->rank == 0))) {
+      // Settings are taken from the first archive.
+      npz_begin_array(&writer, group, name, "", header->descr, item_size, 0,
+                      NULL);
+      npz_write(&writer, array0->data, item_size);
+      npz_end_array(&writer);
+    } else if (header->rank < 2) {
+      npz_begin_array(&writer, group, name, "", header->descr, item_size, 1,
+                      &n);
+      for (size_t a = 0; a < num_archives; ++a) {
+        if (sources[a]->is_fixed) {
+          for (size_t m = begins[a]; m < ends[a]; ++m)
+            npz_write(&writer, sources[a]->data, item_size);
+        } else {
+          npz_write(&writer, &sources[a]->data[item_size * begins[a]],
+                    item_size * (ends[a] - begins[a]));
+        }
+      }
+      npz_end_array(&writer);
+    } else {
+      // Find the length of the longest row, and whether rows differ. A
+      // fixed array's row is used for every member.
+      char *sizes_name = malloc(name_length + 7);
+      snprintf(sizes_name, name_length + 7, "%s.sizes", array0->name);
+      size_t width = 0, first_size = 0;
+      bool ragged = false;
+      for (size_t a = 0; a < num_archives; ++a) {
+        const npz_array_t *sizes = find_npz_array(&archives[a], sizes_name);
+        if (sizes && sizes->is_sizes) source_sizes[a] = sizes;
+        size_t row_step = sources[a]->is_fixed ? 0 : 1;
+        for (size_t m = begins[a]; m < ends[a]; ++m) {
+          size_t size = npz_row_size(sources[a], source_sizes[a],
+                                     row_step * m);
+          if (size > width) width = size;
+          if ((a == 0) && (m == begins[0])) first_size = size;
+          if (size != first_size) ragged = true;
+        }
+      }
+      free(sizes_name);
+
+      // Rows are already padded with NaN to the length of the longest row in
+      // their archive, so they're copied whole (or truncated) and padded.
+      size_t shape[2] = {fixed ? 1 : n, width};
+      npz_begin_array(&writer, group, name, "", header->descr, item_size, 2,
+                      shape);
+      for (size_t a = 0; a < (fixed ? 1 : num_archives); ++a) {
+        size_t row_length = sources[a]->header.shape[1];
+        size_t length = (row_length < width) ? row_length : width;
+        size_t row_step = sources[a]->is_fixed ? 0 : 1;
+        for (size_t m = begins[a]; m < (fixed ? begins[a] + 1 : ends[a]); ++m) {
+          npz_write(&writer,
+                    &sources[a]->data[item_size * row_length * row_step * m],
+                    item_size * length);
+          write_npz_nans(&writer, item_size, width - length);
+        }
+      }
+      npz_end_array(&writer);
+
+      if (ragged) {
+        char descr[32];
+        npy_descr('i', sizeof(int64_t), descr);
+        npz_begin_array(&writer, group, name, ".sizes", descr,
+                        sizeof(int64_t), 1, &n);
+        for (size_t a = 0; a < num_archives; ++a) {
+          size_t row_step = sources[a]->is_fixed ? 0 : 1;
+          for (size_t m = begins[a]; m < ends[a]; ++m) {
+            int64_t size = (int64_t)npz_row_size(sources[a], source_sizes[a],
+                                                 row_step * m);
+            npz_write(&writer, &size, sizeof(int64_t));
           }
         }
-        fprintf(file, "],");
+        npz_end_array(&writer);
       }
-      fprintf(file, "]\n");
     }
-    free(array_output_names);
+    free(group);
   }
+  free(sources);
+  kv_destroy(arrays);
 
-  fclose(file);
+  bool succeeded = npz_writer_finish(&writer);
+  if (fclose(file) || !succeeded) {
+    result.error_code = SW_WRITE_FAILURE;
+    result.error_message = new_string("Could not write ensemble data to '%s'.",
+                                      filename);
+  }
   return result;
 }
 
-void sw_ensemble_free(sw_ensemble_t *ensemble) {
-  if (ensemble->settings)
-    sw_settings_free(ensemble->settings);
-  if (ensemble->inputs) {
-    for (size_t i = 0; i < ensemble->size; ++i) {
-      kh_destroy(param_map, ensemble->inputs[i].params);
-      real_vec_t arrays;
-      kh_foreach_value(ensemble->inputs[i].array_params, arrays,
-        kv_destroy(arrays);
-      );
-      kh_destroy(array_param_map, ensemble->inputs[i].array_params);
-      kh_destroy(param_map, ensemble->outputs[i].metrics);
-      kh_foreach_value(ensemble->outputs[i].array_metrics, arrays,
-        kv_destroy(arrays);
-      );
-      kh_destroy(array_param_map, ensemble->outputs[i].array_metrics);
-    }
-    free(ensemble->inputs);
-    free(ensemble->outputs);
+// Opens the NumPy archives in the files with the given names, storing them in
+// the given array. Returns an error message if any of them can't be opened (in
+// which case none are left open), or NULL if all of them are.
+static const char *open_npz_archives(size_t num_archives,
+                                     const char **filenames,
+                                     const char *output_filename,
+                                     npz_archive_t *archives) {
+  for (size_t a = 0; a < num_archives; ++a) {
+    const char *message = NULL;
+    if (!strcmp(filenames[a], output_filename)) {
+      message = new_string("The NumPy archive '%s' can't be overwritten with "
+                           "its own data.", filenames[a]);
+    } else {
+      message = open_npz_archive(filenames[a], &archives[a]);
+    }
+    if (message) {
+      for (size_t i = 0; i < a; ++i)
+        close_npz_archive(&archives[i]);
+      return message;
+    }
   }
-  free(ensemble);
+  return NULL;
+}
+
+sw_write_result_t sw_archive_merge(size_t num_archives,
+                                   const char **archive_filenames,
+                                   const char *merged_filename) {
+  sw_write_result_t result = {.error_code = SW_SUCCESS};
+  if (num_archives == 0) {
+    result.error_code = SW_INVALID_ARCHIVE;
+    result.error_message = "No NumPy archives were given to merge!";
+    return result;
+  }
+  npz_archive_t *archives = malloc(sizeof(npz_archive_t) * num_archives);
+  size_t *begins = malloc(2 * sizeof(size_t) * num_archives);
+  size_t *ends = &begins[num_archives];
+  const char *message = open_npz_archives(num_archives, archive_filenames,
+                                          merged_filename, archives);
+  if (message) {
+    result.error_code = SW_INVALID_ARCHIVE;
+    result.error_message = message;
+  } else {
+    for (size_t a = 0; a < num_archives; ++a) {
+      begins[a] = 0;
+      ends[a] = archives[a].num_members;
+    }
+    result = write_combined_archive(num_archives, archives, begins, ends,
+                                    merged_filename);
+    for (size_t a = 0; a < num_archives; ++a)
+      close_npz_archive(&archives[a]);
+  }
+  free(begins);
+  free(archives);
+  return result;
+}
+
+sw_write_result_t sw_archive_slice(const char *archive_filename,
+                                   size_t begin, size_t end,
+                                   const char *sliced_filename) {
+  sw_write_result_t result = {.error_code = SW_SUCCESS};
+  npz_archive_t archive;
+  const char *message = open_npz_archives(1, &archive_filename,
+                                          sliced_filename, &archive);
+  if (message) {
+    result.error_code = SW_INVALID_ARCHIVE;
+    result.error_message = message;
+    return result;
+  }
+  if ((begin > end) || (end > archive.num_members)) {
+    result.error_code = SW_INVALID_ARCHIVE;
+    result.error_message =
+      new_string("Invalid member range [%zu, %zu) for the NumPy archive '%s', "
+                 "which holds %zu members.", begin, end, archive_filename,
+                 archive.num_members);
+  } else {
+    result = write_combined_archive(1, &archive, &begin, &end,
+                                    sliced_filename);
+  }
+  close_npz_archive(&archive);
+  return result;
 }
 
 //----------------------------
@@ -1449,6 +6810,22 @@ void sw_load_ensemble_f90(const char *yaml_file, const char *settings_block,
   *error_message = result.error_message;
 }
 
+#ifdef SKYWALKER_HAVE_MPI
+void sw_load_ensemble_mpi_f90(const char *yaml_file, const char *settings_block,
+                              MPI_Fint *comm, sw_settings_t **settings,
+                              sw_ensemble_t **ensemble, int *error_code,
+                              const char **error_message) {
+  sw_ensemble_result_t result = sw_load_ensemble_mpi(yaml_file, settings_block,
+                                                     MPI_Comm_f2c(*comm));
+  if (result.error_code == SW_SUCCESS) {
+    *settings = result.settings;
+    *ensemble = result.ensemble;
+  }
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+#endif
+
 void sw_settings_get_f90(sw_settings_t *settings, const char *name,
                          const char **value, int *error_code,
                          const char **error_message) {
@@ -1487,6 +6864,86 @@ void sw_output_set_array_f90(sw_output_t *output, const char *name,
   sw_output_set_array(output, name, values, *size);
 }
 
+void sw_output_reserve_array_f90(sw_output_t *output, const char *name,
+                                 size_t *size, sw_real_t **values) {
+  *values = sw_output_reserve_array(output, name, *size);
+}
+
+void sw_input_handle_f90(sw_ensemble_t *ensemble, const char *name,
+                         sw_handle_t *handle, int *error_code,
+                         const char **error_message) {
+  sw_handle_result_t result = sw_input_handle(ensemble, name);
+  *handle = result.handle;
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+
+void sw_input_array_handle_f90(sw_ensemble_t *ensemble, const char *name,
+                               sw_handle_t *handle, int *error_code,
+                               const char **error_message) {
+  sw_handle_result_t result = sw_input_array_handle(ensemble, name);
+  *handle = result.handle;
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+
+void sw_input_get_h_f90(sw_input_t *input, sw_handle_t handle,
+                        sw_real_t *value, int *error_code,
+                        const char **error_message) {
+  sw_input_result_t result = sw_input_get_h(input, handle);
+  if (result.error_code == SW_SUCCESS) {
+    *value = result.value;
+  }
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+
+void sw_input_get_array_h_f90(sw_input_t *input, sw_handle_t handle,
+                              sw_real_t **values, size_t *size,
+                              int *error_code, const char **error_message) {
+  sw_input_array_result_t result = sw_input_get_array_h(input, handle);
+  if (result.error_code == SW_SUCCESS) {
+    *values = result.values;
+    *size = result.size;
+  }
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+
+void sw_output_set_array_h_f90(sw_output_t *output, sw_handle_t handle,
+                               const sw_real_t *values, size_t *size) {
+  sw_output_set_array_h(output, handle, values, *size);
+}
+
+void sw_output_reserve_array_h_f90(sw_output_t *output, sw_handle_t handle,
+                                   size_t *size, sw_real_t **values) {
+  *values = sw_output_reserve_array_h(output, handle, *size);
+}
+
+
+void sw_batch_input_get_f90(sw_batch_t *batch, const char *name,
+                            sw_real_t **values, size_t *size,
+                            int *error_code, const char **error_message) {
+  sw_input_array_result_t result = sw_batch_input_get(batch, name);
+  if (result.error_code == SW_SUCCESS) {
+    *values = result.values;
+    *size = result.size;
+  }
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+
+void sw_batch_input_get_h_f90(sw_batch_t *batch, sw_handle_t handle,
+                              sw_real_t **values, size_t *size,
+                              int *error_code, const char **error_message) {
+  sw_input_array_result_t result = sw_batch_input_get_h(batch, handle);
+  if (result.error_code == SW_SUCCESS) {
+    *values = result.values;
+    *size = result.size;
+  }
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
 
 void sw_ensemble_write_f90(sw_ensemble_t *ensemble, const char *module_filename,
                           int *error_code, const char **error_message) {
@@ -1495,14 +6952,94 @@ void sw_ensemble_write_f90(sw_ensemble_t *ensemble, const char *module_filename,
   *error_message = result.error_message;
 }
 
-// Returns a newly-allocated C string for the given Fortran string pointer with
-// the given length. Strings of this sort are freed at program exit.
+void sw_ensemble_stream_f90(sw_ensemble_t *ensemble, const char *filename,
+                            size_t chunk_size, int *error_code,
+                            const char **error_message) {
+  sw_write_result_t result = sw_ensemble_stream(ensemble, filename, chunk_size);
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+
+void sw_ensemble_restart_f90(sw_ensemble_t *ensemble, const char *filename,
+                             size_t chunk_size, int *error_code,
+                             const char **error_message) {
+  sw_write_result_t result = sw_ensemble_restart(ensemble, filename,
+                                                 chunk_size);
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+
+void sw_ensemble_write_format_f90(sw_ensemble_t *ensemble, const char *filename,
+                                  int format, int *error_code,
+                                  const char **error_message) {
+  sw_write_result_t result = sw_ensemble_write_format(ensemble, filename,
+                                                      (sw_write_format_t)format);
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+
+void sw_ensemble_write_options_f90(sw_ensemble_t *ensemble,
+                                   const char *filename, int format,
+                                   size_t num_quantities,
+                                   const char **quantities,
+                                   bool fixed_inputs_once, int precision,
+                                   bool compress, int *error_code,
+                                   const char **error_message) {
+  // Fortran passes no quantities if it selects all of them.
+  sw_write_options_t options = {
+    .format = (sw_write_format_t)format,
+    .num_quantities = num_quantities,
+    .quantities = (num_quantities > 0) ? quantities : NULL,
+    .fixed_inputs_once = fixed_inputs_once,
+    .precision = precision,
+    .compress = compress
+  };
+  sw_write_result_t result = sw_ensemble_write_options(ensemble, filename,
+                                                       &options);
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+
+void sw_ensemble_memoize_f90(sw_ensemble_t *ensemble, const char *filename,
+                             int *error_code, const char **error_message) {
+  sw_write_result_t result = sw_ensemble_memoize(ensemble, filename);
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+
+void sw_ensemble_stats_f90(sw_ensemble_t *ensemble,
+                           sw_ensemble_stats_t *stats) {
+  *stats = sw_ensemble_stats(ensemble);
+}
+
+void sw_archive_merge_f90(size_t num_archives, const char **archive_filenames,
+                          const char *merged_filename, int *error_code,
+                          const char **error_message) {
+  sw_write_result_t result = sw_archive_merge(num_archives, archive_filenames,
+                                              merged_filename);
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+
+void sw_archive_slice_f90(const char *archive_filename, size_t begin,
+                          size_t end, const char *sliced_filename,
+                          int *error_code, const char **error_message) {
+  sw_write_result_t result = sw_archive_slice(archive_filename, begin, end,
+                                              sliced_filename);
+  *error_code = result.error_code;
+  *error_message = result.error_message;
+}
+
+// Returns a C string for the given Fortran string pointer with the given
+// length. Strings of this sort are pooled, so converting the same name many
+// times stores it once, and are freed at program exit.
 const char* sw_new_c_string_f90(char* f_str_ptr, int f_str_len) {
   char* s = malloc(sizeof(char) * (f_str_len+1));
   memcpy(s, f_str_ptr, sizeof(char) * f_str_len);
   s[f_str_len] = '\0';
-  append_string((const char*)s);
-  return (const char*)s;
+  const char *c_string = new_string("%s", s);
+  free(s);
+  return c_string;
 }
 
 #ifdef __cplusplus
@@ -107,6 +107,12 @@ int main(int argc, char **argv) {
 
     // Add a "qoi" metric set to 4.
     sw_output_set(output, "qoi", 4.0);
+
+    // Compute an array of outputs in place.
+    sw_real_t *profile = sw_output_reserve_array(output, "profile", 3);
+    assert(profile != NULL);
+    for (int k = 0; k < 3; ++k)
+      profile[k] = k * in_result.value;
   }
 
   // Write out a Python module.
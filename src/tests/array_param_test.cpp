@@ -84,6 +84,12 @@ int main(int argc, char **argv) {
     assert(approx_equal(p1[2], 2+p1[0]));
     assert(approx_equal(p1[3], 3+p1[0]));
 
+    // A view refers to the same values without copying them.
+    auto p1_view = input.get_array_view("p1");
+    assert(p1_view.size() == 4);
+    assert(p1_view.data() == input.get_array_view("p1").data());
+    assert(std::equal(p1_view.begin(), p1_view.end(), p1.begin()));
+
     assert(input.has_array("p2"));
     auto p2 = input.get_array("p2");
     assert(p2.size() == 3);
@@ -96,11 +102,19 @@ int main(int argc, char **argv) {
 
     // Add a "qoi" metric set to 4.
     output.set("qoi", 4.0);
+
+    // Compute an array of outputs in place.
+    Real* profile = output.reserve_array("profile", 3);
+    for (int k = 0; k < 3; ++k)
+      profile[k] = k * input.get("p3");
   });
 
   // Write out a Python module.
   ensemble->write("array_param_test_cpp.py");
 
+  // We can also write the data to a NumPy archive.
+  ensemble->write("array_param_test_cpp.npz", SW_NUMPY_ARCHIVE);
+
   // Clean up.
   delete ensemble;
 }
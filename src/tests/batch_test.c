@@ -0,0 +1,247 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C interface for processing ensemble members
+// in batches.
+
+#include <skywalker.h>
+
+#include <assert.h>
+#include <string.h>
+#include <tgmath.h>
+
+void usage(const char *prog_name) {
+  fprintf(stderr, "%s: usage:\n", prog_name);
+  fprintf(stderr, "%s <input.yaml>\n", prog_name);
+  exit(0);
+}
+
+static bool approx_equal(sw_real_t x, sw_real_t y) {
+  return (fabs(x - y) < 1e-14);
+}
+
+// Returns true if the file with the given name contains the given text.
+static bool file_contains(const char *filename, const char *text) {
+  FILE *file = fopen(filename, "r");
+  assert(file);
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *contents = malloc(size + 1);
+  size_t num_read = fread(contents, 1, size, file);
+  contents[num_read] = '\0';
+  fclose(file);
+  bool found = (strstr(contents, text) != NULL);
+  free(contents);
+  return found;
+}
+
+// Loads the ensemble in the given file, exiting on failure.
+static sw_ensemble_t *load(const char *input_file) {
+  sw_ensemble_result_t load_result = sw_load_ensemble(input_file, "settings");
+  if (load_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", load_result.error_message);
+    exit(-1);
+  }
+  return load_result.ensemble;
+}
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  const char* input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  sw_print_banner();
+
+  // Load the ensemble. Any error encountered is fatal.
+  fprintf(stderr, "batch_test: Loading ensemble from %s\n", input_file);
+  sw_ensemble_t *ensemble = load(input_file);
+  assert(sw_ensemble_size(ensemble) == 12);
+
+  sw_batch_t *batch;
+  assert(!sw_ensemble_next_batch(ensemble, 0, &batch));
+  assert(batch == NULL);
+
+  // Process the ensemble in batches of 5 members, the last of which has only
+  // 2 members. Enumerated values vary fastest: member i has e1 = e1[i % 4]
+  // and l1 = 1 + i / 4.
+  sw_handle_t e1 = sw_input_handle(ensemble, "e1").handle;
+  sw_handle_t qoi = sw_output_handle(ensemble, "qoi");
+  size_t num_batches = 0, num_members = 0;
+  while (sw_ensemble_next_batch(ensemble, 5, &batch)) {
+    size_t n = sw_batch_size(batch);
+    assert(sw_batch_begin(batch) == num_members);
+    assert(n == ((num_batches < 2) ? 5 : 2));
+
+    sw_input_array_result_t f1 = sw_batch_input_get(batch, "f1");
+    assert(f1.error_code == SW_SUCCESS);
+    assert(f1.size == n);
+    sw_input_array_result_t l1 = sw_batch_input_get(batch, "l1");
+    assert(l1.error_code == SW_SUCCESS);
+    sw_input_array_result_t e1_values = sw_batch_input_get_h(batch, e1);
+    assert(e1_values.error_code == SW_SUCCESS);
+    assert(e1_values.size == n);
+    assert(sw_batch_input_get(batch, "ea").error_code == SW_PARAM_NOT_FOUND);
+    assert(sw_batch_input_get(batch, "nope").error_code == SW_PARAM_NOT_FOUND);
+    assert(sw_batch_input_get_h(batch, -1).error_code == SW_PARAM_NOT_FOUND);
+
+    // Compute scalar outputs for all members at once.
+    assert(sw_batch_output_reserve_h(batch, -1) == NULL);
+    assert(sw_batch_output_reserve_h(batch, 1000) == NULL);
+    sw_real_t *qoi_values = sw_batch_output_reserve_h(batch, qoi);
+    sw_real_t *sum_values = sw_batch_output_reserve(batch, "sum");
+    for (size_t i = 0; i < n; ++i) {
+      size_t m = num_members + i;
+      assert(approx_equal(f1.values[i], 1.0));
+      assert(approx_equal(l1.values[i], 1.0 + m / 4));
+      assert(approx_equal(e1_values.values[i], 10.0 * (1 + m % 4)));
+      qoi_values[i] = l1.values[i] * e1_values.values[i];
+      sum_values[i] = l1.values[i] + e1_values.values[i];
+    }
+
+    // Array-valued parameters are accessed member by member, and agree with
+    // the batch's scalars.
+    sw_input_t *input;
+    sw_output_t *output;
+    for (size_t i = 0; i < n; ++i) {
+      assert(sw_batch_get(batch, i, &input, &output));
+      assert(approx_equal(sw_input_get(input, "e1").value,
+                          e1_values.values[i]));
+      sw_input_array_result_t ea = sw_input_get_array(input, "ea");
+      assert(ea.error_code == SW_SUCCESS);
+      assert(ea.size == 2);
+      assert(approx_equal(ea.values[0], 1.0 + 2 * ((num_members + i) % 4)));
+      sw_real_t values[2] = {l1.values[i], ea.values[1]};
+      sw_output_set_array(output, "qoi_array", values, 2);
+    }
+    assert(!sw_batch_get(batch, n, &input, &output));
+    assert((input == NULL) && (output == NULL));
+
+    ++num_batches;
+    num_members += n;
+  }
+  assert(num_batches == 3);
+  assert(num_members == 12);
+
+  // The ensemble can be traversed again, member by member, and each member
+  // has the outputs computed for its batch.
+  sw_input_t *input;
+  sw_output_t *output;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_real_t l1 = sw_input_get(input, "l1").value;
+    sw_real_t e1 = sw_input_get(input, "e1").value;
+    sw_output_set(output, "check", l1 * e1);
+  }
+
+  // Inputs for all members can be copied into a single buffer with each
+  // parameter's values stored contiguously, and outputs copied back from one.
+  const char *input_names[2] = {"l1", "e1"};
+  sw_real_t exported[24];
+  sw_transfer_result_t t_result =
+    sw_ensemble_export_inputs(ensemble, 2, input_names, exported);
+  assert(t_result.error_code == SW_SUCCESS);
+  for (size_t i = 0; i < 12; ++i) {
+    assert(approx_equal(exported[i], 1.0 + i / 4));
+    assert(approx_equal(exported[12 + i], 10.0 * (1 + i % 4)));
+  }
+  const char *bad_names[2] = {"e1", "ea"}; // not a scalar parameter
+  t_result = sw_ensemble_export_inputs(ensemble, 2, bad_names, exported);
+  assert(t_result.error_code == SW_PARAM_NOT_FOUND);
+  assert(approx_equal(exported[0], 1.0)); // nothing was copied
+
+  const char *output_names[2] = {"product", "difference"};
+  sw_real_t imported[24];
+  for (size_t i = 0; i < 12; ++i) {
+    imported[i] = exported[i] * exported[12 + i];
+    imported[12 + i] = (i == 0) ? NAN : exported[12 + i] - exported[i];
+  }
+  t_result = sw_ensemble_import_outputs(ensemble, 2, output_names, imported);
+  assert(t_result.error_code == SW_SUCCESS);
+
+  // NaN values don't overwrite quantities that were already set.
+  const char *qoi_name = "qoi";
+  sw_real_t qoi_values[12];
+  for (size_t i = 0; i < 12; ++i)
+    qoi_values[i] = (i == 0) ? 5 : NAN;
+  t_result = sw_ensemble_import_outputs(ensemble, 1, &qoi_name, qoi_values);
+  assert(t_result.error_code == SW_SUCCESS);
+
+  // Write out a Python module containing the output data.
+  sw_write_result_t w_result = sw_ensemble_write(ensemble, "batch_test.py");
+  if (w_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", w_result.error_message);
+    exit(-1);
+  }
+  assert(file_contains("batch_test.py",
+    "output.qoi = [5, 20, 30, 40, 20, 40, 60, 80, 30, 60, 90, 120, ]"));
+  assert(file_contains("batch_test.py",
+    "output.check = [10, 20, 30, 40, 20, 40, 60, 80, 30, 60, 90, 120, ]"));
+  assert(file_contains("batch_test.py",
+    "output.sum = [11, 21, 31, 41, 12, 22, 32, 42, 13, 23, 33, 43, ]"));
+  assert(file_contains("batch_test.py",
+    "output.product = [10, 20, 30, 40, 20, 40, 60, 80, 30, 60, 90, 120, ]"));
+  assert(file_contains("batch_test.py",
+    "output.difference = [nan, 19, 29, 39, 8, 18, 28, 38, 7, 17, 27, 37, ]"));
+  sw_ensemble_free(ensemble);
+
+  // Batches of a streaming ensemble end with the chunks they belong to.
+  ensemble = load(input_file);
+  const char *module_filename = "batch_test_stream.py";
+  w_result = sw_ensemble_stream(ensemble, module_filename, 3);
+  assert(w_result.error_code == SW_SUCCESS);
+  t_result = sw_ensemble_import_outputs(ensemble, 2, output_names, imported);
+  assert(t_result.error_code == SW_WRITE_FAILURE);
+  num_batches = num_members = 0;
+  while (sw_ensemble_next_batch(ensemble, 2, &batch)) {
+    size_t n = sw_batch_size(batch);
+    assert(n == ((num_batches % 2) ? 1 : 2));
+    assert(sw_batch_begin(batch) == num_members);
+    sw_input_array_result_t e1_values = sw_batch_input_get(batch, "e1");
+    sw_real_t *qoi_values = sw_batch_output_reserve(batch, "qoi");
+    for (size_t i = 0; i < n; ++i)
+      qoi_values[i] = e1_values.values[i];
+    ++num_batches;
+    num_members += n;
+  }
+  assert(num_batches == 8);
+  assert(num_members == 12);
+  assert(!sw_ensemble_next_batch(ensemble, 2, &batch));
+  assert(file_contains(module_filename, "_extend('qoi', 3, [40, 10, 20, ])"));
+  assert(file_contains(module_filename, "_finish(12)\n"));
+  sw_ensemble_free(ensemble);
+}
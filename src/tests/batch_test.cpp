@@ -0,0 +1,156 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C++ interface for processing ensemble members
+// in batches.
+
+#include <skywalker.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+void usage(const std::string& prog_name) {
+  std::cerr << prog_name << ": usage:" << std::endl;
+  std::cerr << prog_name << " <input.yaml>" << std::endl;
+  exit(0);
+}
+
+using namespace skywalker;
+
+static bool approx_equal(Real x, Real y) {
+  return (std::abs(x - y) < 1e-14);
+}
+
+// Returns the contents of the file with the given name.
+static std::string file_contents(const std::string& filename) {
+  std::ifstream file(filename);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  std::string input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  print_banner();
+
+  // Load the ensemble. Any error encountered is fatal.
+  std::cerr << "batch_test: Loading ensemble from " << input_file << std::endl;
+  Ensemble* ensemble = load_ensemble(input_file, "settings");
+  assert(ensemble->size() == 12);
+
+  // Process the ensemble in batches of 5 members. Enumerated values vary
+  // fastest: member i has e1 = e1[i % 4] and l1 = 1 + i / 4.
+  Handle e1 = ensemble->input_handle("e1");
+  Handle qoi = ensemble->output_handle("qoi");
+  size_t num_members = 0;
+  ensemble->process_batch(5, [&](const Batch& batch) {
+    size_t n = batch.size();
+    assert(batch.begin() == num_members);
+    assert(n == ((num_members < 10) ? 5 : 2));
+
+    ArrayView l1_values = batch.get_input("l1");
+    ArrayView e1_values = batch.get_input(e1);
+    assert(l1_values.size() == n);
+    assert(e1_values.size() == n);
+    try {
+      batch.get_input("ea"); // array parameters aren't batched
+      assert(false);
+    } catch (Exception&) {
+    }
+
+    Real* qoi_values = batch.reserve_output(qoi);
+    Real* sum_values = batch.reserve_output("sum");
+    for (size_t i = 0; i < n; ++i) {
+      size_t m = num_members + i;
+      assert(approx_equal(l1_values[i], 1 + m / 4));
+      assert(approx_equal(e1_values[i], 10 * (1 + m % 4)));
+      qoi_values[i] = l1_values[i] * e1_values[i];
+      sum_values[i] = l1_values[i] + e1_values[i];
+    }
+
+    // Array-valued parameters are accessed member by member.
+    Input input;
+    Output output;
+    for (size_t i = 0; i < n; ++i) {
+      assert(batch.get(i, input, output));
+      auto ea = input.get_array_view("ea");
+      assert(ea.size() == 2);
+      output.set("qoi_array", std::vector<Real>({l1_values[i], ea[1]}));
+    }
+    assert(!batch.get(n, input, output));
+    num_members += n;
+  });
+  assert(num_members == 12);
+
+  // Inputs and outputs for all members can be copied in bulk.
+  auto exported = ensemble->export_inputs({"l1", "e1"});
+  assert(exported.size() == 24);
+  std::vector<Real> imported(12);
+  for (size_t i = 0; i < 12; ++i) {
+    assert(approx_equal(exported[i], 1 + i / 4));
+    imported[i] = exported[i] * exported[12 + i];
+  }
+  ensemble->import_outputs({"product"}, imported.data());
+  try {
+    ensemble->export_inputs({"missing"});
+    assert(false);
+  } catch (Exception&) {
+  }
+
+  // Write out a Python module containing the output data.
+  ensemble->write("batch_test_cpp.py");
+  auto contents = file_contents("batch_test_cpp.py");
+  assert(contents.find(
+    "output.qoi = [10, 20, 30, 40, 20, 40, 60, 80, 30, 60, 90, 120, ]") !=
+    std::string::npos);
+  assert(contents.find(
+    "output.sum = [11, 21, 31, 41, 12, 22, 32, 42, 13, 23, 33, 43, ]") !=
+    std::string::npos);
+  assert(contents.find(
+    "output.product = [10, 20, 30, 40, 20, 40, 60, 80, 30, 60, 90, 120, ]") !=
+    std::string::npos);
+
+  // Clean up.
+  delete ensemble;
+}
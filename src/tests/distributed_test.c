@@ -0,0 +1,166 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C interface for distributing an ensemble
+// across MPI processes. It must be run on several processes.
+
+#include <skywalker.h>
+
+#include <assert.h>
+#include <string.h>
+#include <tgmath.h>
+
+void usage(const char *prog_name) {
+  fprintf(stderr, "%s: usage:\n", prog_name);
+  fprintf(stderr, "%s <input.yaml>\n", prog_name);
+  exit(0);
+}
+
+// Computes outputs for the ensemble member with the given (global) index. Some
+// quantities are set only for some members, and the order in which quantities
+// are first set differs between processes.
+static void compute_outputs(sw_input_t *input, sw_output_t *output,
+                            size_t index, int rank) {
+  sw_real_t l1 = sw_input_get(input, "l1").value;
+  sw_real_t e1 = sw_input_get(input, "e1").value;
+  sw_real_t values[3] = {l1, e1, (sw_real_t)index};
+  size_t size = 1 + index % 3;
+  if (rank % 2) {
+    sw_output_set_array(output, "values", values, size);
+    sw_output_set(output, "qoi", l1 * e1);
+  } else {
+    sw_output_set(output, "qoi", l1 * e1);
+    sw_output_set_array(output, "values", values, size);
+  }
+  if (index >= 15) {
+    sw_output_set(output, "late_qoi", l1 + e1);
+  }
+}
+
+// Returns true if the files with the given names have identical contents.
+static bool same_contents(const char *file1, const char *file2) {
+  FILE *f1 = fopen(file1, "r"), *f2 = fopen(file2, "r");
+  assert(f1 && f2);
+  int c1, c2;
+  do {
+    c1 = fgetc(f1);
+    c2 = fgetc(f2);
+  } while ((c1 == c2) && (c1 != EOF));
+  fclose(f1);
+  fclose(f2);
+  return (c1 == c2);
+}
+
+int main(int argc, char **argv) {
+
+  MPI_Init(&argc, &argv);
+  int rank, num_ranks;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  const char* input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  if (rank == 0) {
+    sw_print_banner();
+  }
+
+  // Errors are reported on every process.
+  sw_ensemble_result_t load_result =
+    sw_load_ensemble_mpi("nonexistent.yaml", "settings", MPI_COMM_WORLD);
+  assert(load_result.error_code == SW_YAML_FILE_NOT_FOUND);
+
+  // Load the ensemble. Any error encountered is fatal.
+  fprintf(stderr, "distributed_test: Loading ensemble from %s on rank %d\n",
+          input_file, rank);
+  load_result = sw_load_ensemble_mpi(input_file, "settings", MPI_COMM_WORLD);
+  if (load_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", load_result.error_message);
+    exit(-1);
+  }
+  sw_ensemble_t *ensemble = load_result.ensemble;
+
+  // The processes' blocks are contiguous and cover the ensemble.
+  unsigned long size = sw_ensemble_size(ensemble), offset = 0, total_size;
+  MPI_Exscan(&size, &offset, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+  if (rank == 0) offset = 0;
+  assert(sw_ensemble_offset(ensemble) == offset);
+  MPI_Allreduce(&size, &total_size, 1, MPI_UNSIGNED_LONG, MPI_SUM,
+                MPI_COMM_WORLD);
+  assert(total_size == 20);
+
+  sw_input_t *input;
+  sw_output_t *output;
+  size_t index = sw_ensemble_offset(ensemble);
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    compute_outputs(input, output, index, rank);
+    ++index;
+  }
+
+  // Gather outputs into a single Python module.
+  sw_write_result_t w_result = sw_ensemble_write(ensemble, "distributed_test.py");
+  if (w_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", w_result.error_message);
+    exit(-1);
+  }
+
+  // Write failures are also reported on every process.
+  w_result = sw_ensemble_write(ensemble, "/nonexistent/distributed_test.py");
+  assert(w_result.error_code == SW_WRITE_FAILURE);
+  assert(w_result.error_message != NULL);
+  sw_ensemble_free(ensemble);
+
+  // The module matches the one written for the same ensemble by one process.
+  if (rank == 0) {
+    load_result = sw_load_ensemble(input_file, "settings");
+    assert(load_result.error_code == SW_SUCCESS);
+    ensemble = load_result.ensemble;
+    assert(sw_ensemble_size(ensemble) == 20);
+    index = 0;
+    while (sw_ensemble_next(ensemble, &input, &output)) {
+      compute_outputs(input, output, index, 0);
+      ++index;
+    }
+    w_result = sw_ensemble_write(ensemble, "distributed_test_serial.py");
+    assert(w_result.error_code == SW_SUCCESS);
+    sw_ensemble_free(ensemble);
+    assert(same_contents("distributed_test.py", "distributed_test_serial.py"));
+  }
+
+  MPI_Finalize();
+}
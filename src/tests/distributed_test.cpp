@@ -0,0 +1,124 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C++ interface for distributing an ensemble
+// across MPI processes. It must be run on several processes.
+
+#include <skywalker.hpp>
+
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+void usage(const std::string& prog_name) {
+  std::cerr << prog_name << ": usage:" << std::endl;
+  std::cerr << prog_name << " <input.yaml>" << std::endl;
+  exit(0);
+}
+
+using namespace skywalker;
+
+// Computes outputs for all members of the given ensemble.
+static void compute_outputs(Ensemble* ensemble) {
+  size_t index = ensemble->offset();
+  ensemble->process([&](const Input& input, Output& output) {
+    Real l1 = input.get("l1");
+    Real e1 = input.get("e1");
+    output.set("qoi", l1 * e1);
+    output.set("index", std::vector<Real>(1 + index % 2, Real(index)));
+    ++index;
+  });
+}
+
+// Returns the contents of the file with the given name.
+static std::string contents(const std::string& filename) {
+  std::ifstream file(filename);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char **argv) {
+
+  MPI_Init(&argc, &argv);
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  std::string input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  if (rank == 0) {
+    print_banner();
+  }
+
+  // Errors are reported on every process.
+  bool caught = false;
+  try {
+    load_ensemble_mpi("nonexistent.yaml", "settings", MPI_COMM_WORLD);
+  }
+  catch (Exception&) {
+    caught = true;
+  }
+  assert(caught);
+
+  // Load the ensemble. Any error encountered is fatal.
+  std::cerr << "distributed_test: Loading ensemble from " << input_file << std::endl;
+  Ensemble* ensemble = load_ensemble_mpi(input_file, "settings",
+                                         MPI_COMM_WORLD);
+  unsigned long size = ensemble->size(), total_size;
+  MPI_Allreduce(&size, &total_size, 1, MPI_UNSIGNED_LONG, MPI_SUM,
+                MPI_COMM_WORLD);
+  assert(total_size == 20);
+
+  // Gather outputs into a single Python module.
+  compute_outputs(ensemble);
+  ensemble->write("distributed_test_cpp.py");
+  delete ensemble;
+
+  // The module matches the one written for the same ensemble by one process.
+  if (rank == 0) {
+    ensemble = load_ensemble(input_file, "settings");
+    assert(ensemble->size() == 20);
+    compute_outputs(ensemble);
+    ensemble->write("distributed_test_cpp_serial.py");
+    delete ensemble;
+    assert(contents("distributed_test_cpp.py") == contents("distributed_test_cpp_serial.py"));
+  }
+
+  MPI_Finalize();
+}
@@ -105,6 +105,7 @@ int main(int argc, char **argv) {
   assert(sw_ensemble_size(ensemble) == 11);
   sw_input_t *input;
   sw_output_t *output;
+  const char *not_found_message = NULL;
   while (sw_ensemble_next(ensemble, &input, &output)) {
     sw_input_result_t in_result;
 
@@ -148,6 +149,10 @@ int main(int argc, char **argv) {
     assert(in_result.error_code == SW_PARAM_NOT_FOUND);
     assert(in_result.error_message != NULL);
 
+    // Every member's failed lookup shares a single message.
+    if (!not_found_message) not_found_message = in_result.error_message;
+    assert(in_result.error_message == not_found_message);
+
     // Add a "qoi" metric set to 4.
     sw_output_set(output, "qoi", 4.0);
   }
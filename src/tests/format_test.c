@@ -0,0 +1,275 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// This program tests the formatting of real numbers in Python modules written
+// by Skywalker, which uses the shortest representation that reads back as the
+// same number.
+
+#include <skywalker.h>
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void write_test_input(const char* yaml_text, const char* filename) {
+  FILE *f = fopen(filename, "w");
+  fprintf(f, "%s", yaml_text);
+  fclose(f);
+}
+
+// Reads the entire contents of the text file with the given name.
+static char *read_file(const char *filename) {
+  FILE *f = fopen(filename, "rb");
+  assert(f);
+  fseek(f, 0, SEEK_END);
+  size_t size = (size_t)ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char *text = malloc(size + 1);
+  assert(fread(text, 1, size, f) == size);
+  text[size] = '\0';
+  fclose(f);
+  return text;
+}
+
+// A real number and the text we expect for it.
+typedef struct formatted_real_t {
+  sw_real_t value;
+  const char *text;
+} formatted_real_t;
+
+// Values written exactly the same way in single and double precision.
+static const formatted_real_t common_reals_[] = {
+  {0.0, "0"},
+  {-0.0, "-0"},
+  {1.0, "1"},
+  {-2.5, "-2.5"},
+  {123456.0, "123456"},
+  {16777216.0, "16777216"},
+  {0.1, "0.1"},
+  {0.3, "0.3"},
+  {0.0001, "0.0001"},
+  {0.00001, "1e-05"},
+  {1e10, "10000000000"},
+  {1e20, "1e+20"},
+  {1e-20, "1e-20"},
+};
+
+// Values written in double precision only.
+static const formatted_real_t double_reals_[] = {
+  {123.456, "123.456"},
+  {1.0/3.0, "0.3333333333333333"},
+  {1e15, "1000000000000000"},
+  {1e16, "1e+16"},
+  {1e22, "1e+22"},
+  {1e23, "1e+23"},
+  {9007199254740992.0, "9007199254740992"},
+  {DBL_MAX, "1.7976931348623157e+308"},
+  {-DBL_MAX, "-1.7976931348623157e+308"},
+  {DBL_MIN, "2.2250738585072014e-308"},
+  {4.9406564584124654e-324, "5e-324"},             // smallest subnormal
+  {2.2250738585072009e-308, "2.225073858507201e-308"}, // largest subnormal
+  {1e-310, "1e-310"},
+};
+
+// Values written in single precision only.
+static const formatted_real_t float_reals_[] = {
+  {(float)(1.0/3.0), "0.33333334"},
+  {(float)123.456, "123.456"},
+  {FLT_MAX, "3.4028235e+38"},
+  {-FLT_MAX, "-3.4028235e+38"},
+  {FLT_MIN, "1.1754944e-38"},
+  {1.40129846e-45f, "1e-45"},          // smallest subnormal
+  {1.17549421e-38f, "1.1754942e-38"},  // largest subnormal
+  {1e-40f, "1e-40"},
+};
+
+#define NUM_REALS(a) (sizeof(a) / sizeof(formatted_real_t))
+
+// Returns a pseudorandom 64-bit integer (xorshift64*).
+static uint64_t next_random(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * UINT64_C(2685821657736338717);
+}
+
+// Returns a pseudorandom finite real with arbitrary bits.
+static sw_real_t random_real(uint64_t *state) {
+  for (;;) {
+    uint64_t bits = next_random(state);
+    sw_real_t x;
+    if (sizeof(sw_real_t) == sizeof(double)) {
+      double d;
+      memcpy(&d, &bits, sizeof(double));
+      x = (sw_real_t)d;
+    } else {
+      uint32_t bits32 = (uint32_t)(bits >> 32);
+      float f;
+      memcpy(&f, &bits32, sizeof(float));
+      x = (sw_real_t)f;
+    }
+    if (isfinite(x)) return x;
+  }
+}
+
+// Returns true if x and y have the same bits.
+static bool same_real(sw_real_t x, sw_real_t y) {
+  return !memcmp(&x, &y, sizeof(sw_real_t));
+}
+
+// Reads back the real at the start of the given text, storing the end of its
+// text.
+static sw_real_t read_real(const char *text, char **end) {
+  if (sizeof(sw_real_t) == sizeof(double))
+    return (sw_real_t)strtod(text, end);
+  else
+    return (sw_real_t)strtof(text, end);
+}
+
+// Finds the array output with the given name in the text of a Python module,
+// returning a pointer to the first value of its first member.
+static const char *find_output_array(const char *module, const char *name) {
+  char prefix[64];
+  snprintf(prefix, 64, "output.%s = [[", name);
+  const char *p = strstr(module, prefix);
+  assert(p);
+  return p + strlen(prefix);
+}
+
+int main(int argc, char **argv) {
+
+  // We ignore command line arguments in favor of a generated input.
+
+  // Print a banner with Skywalker's version info.
+  sw_print_banner();
+
+  const char* yaml =
+    "settings:\n  s1: format\n\n"
+    "input:\n"
+    "  enumerated:\n    e1: [1, 2]\n";
+  write_test_input(yaml, "format_test.yaml");
+  sw_ensemble_result_t load_result = sw_load_ensemble("format_test.yaml",
+                                                      "settings");
+  assert(load_result.error_code == SW_SUCCESS);
+  sw_ensemble_t *ensemble = load_result.ensemble;
+  assert(sw_ensemble_size(ensemble) == 2);
+
+  // Gather the values with known text.
+  bool is_double = (sizeof(sw_real_t) == sizeof(double));
+  const formatted_real_t *reals = is_double ? double_reals_ : float_reals_;
+  size_t num_reals = is_double ? NUM_REALS(double_reals_)
+                               : NUM_REALS(float_reals_);
+  size_t num_exact = NUM_REALS(common_reals_) + num_reals;
+  formatted_real_t *exact = malloc(sizeof(formatted_real_t) * num_exact);
+  memcpy(exact, common_reals_, sizeof(common_reals_));
+  memcpy(&exact[NUM_REALS(common_reals_)], reals,
+         sizeof(formatted_real_t) * num_reals);
+
+  // Gather values to be read back: powers of 10 throughout the range of
+  // normal numbers, values with arbitrary bits, and their neighbors.
+  int max_exponent = is_double ? DBL_MAX_10_EXP : FLT_MAX_10_EXP;
+  int min_exponent = is_double ? DBL_MIN_10_EXP : FLT_MIN_10_EXP;
+  size_t num_random = 10000;
+  size_t num_tested = (size_t)(max_exponent - min_exponent + 1) +
+                      3 * num_random;
+  sw_real_t *tested = malloc(sizeof(sw_real_t) * num_tested);
+  size_t n = 0;
+  for (int e = min_exponent; e <= max_exponent; ++e) {
+    char power[16];
+    snprintf(power, 16, "1e%d", e);
+    tested[n++] = read_real(power, NULL);
+  }
+  uint64_t state = 88172645463325252ULL;
+  for (size_t i = 0; i < num_random; ++i) {
+    sw_real_t x = random_real(&state);
+    tested[n++] = x;
+    tested[n++] = is_double ? (sw_real_t)nextafter(x, INFINITY)
+                            : (sw_real_t)nextafterf(x, INFINITY);
+    tested[n++] = is_double ? (sw_real_t)nextafter(x, 0.0)
+                            : (sw_real_t)nextafterf(x, 0.0f);
+  }
+  assert(n == num_tested);
+
+  // Write all of these values to a module for each member.
+  sw_input_t *input;
+  sw_output_t *output;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_real_t *values = sw_output_reserve_array(output, "exact", num_exact);
+    for (size_t i = 0; i < num_exact; ++i)
+      values[i] = exact[i].value;
+    sw_output_set_array(output, "tested", tested, num_tested);
+  }
+  sw_write_result_t w_result = sw_ensemble_write(ensemble, "format_test.py");
+  assert(w_result.error_code == SW_SUCCESS);
+  sw_ensemble_free(ensemble);
+
+  // Check the text of each value with known text, and that it reads back.
+  char *module = read_file("format_test.py");
+  const char *p = find_output_array(module, "exact");
+  for (size_t i = 0; i < num_exact; ++i) {
+    size_t len = strlen(exact[i].text);
+    if (strncmp(p, exact[i].text, len) || strncmp(&p[len], ", ", 2)) {
+      fprintf(stderr, "format_test: expected %s, got %.32s\n",
+              exact[i].text, p);
+      exit(1);
+    }
+    char *end;
+    assert(same_real(read_real(p, &end), exact[i].value));
+    assert(end == p + len);
+    p += len + 2;
+  }
+  assert(*p == ']');
+
+  // Check that every other value reads back as itself.
+  p = find_output_array(module, "tested");
+  for (size_t i = 0; i < num_tested; ++i) {
+    char *end;
+    sw_real_t x = read_real(p, &end);
+    if (!same_real(x, tested[i])) {
+      fprintf(stderr, "format_test: %.*s doesn't read back as %.17g\n",
+              (int)(end - p), p, (double)tested[i]);
+      exit(1);
+    }
+    assert(!strncmp(end, ", ", 2));
+    p = end + 2;
+  }
+  assert(*p == ']');
+
+  free(module);
+  free(tested);
+  free(exact);
+}
@@ -0,0 +1,181 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C interface for accessing input parameters
+// and output quantities using handles.
+
+#include <skywalker.h>
+
+#include <assert.h>
+#include <string.h>
+#include <tgmath.h>
+
+void usage(const char *prog_name) {
+  fprintf(stderr, "%s: usage:\n", prog_name);
+  fprintf(stderr, "%s <input.yaml>\n", prog_name);
+  exit(0);
+}
+
+static bool approx_equal(sw_real_t x, sw_real_t y) {
+  return (fabs(x - y) < 1e-14);
+}
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  const char* input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  sw_print_banner();
+
+  // Load the ensemble. Any error encountered is fatal.
+  fprintf(stderr, "handle_test: Loading ensemble from %s\n", input_file);
+  sw_ensemble_result_t load_result = sw_load_ensemble(input_file, "settings");
+  if (load_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", load_result.error_message);
+    exit(-1);
+  }
+
+  sw_ensemble_t *ensemble = load_result.ensemble;
+  assert(sw_ensemble_size(ensemble) == 6);
+
+  // Fetch handles for input parameters.
+  sw_handle_result_t h_result;
+  h_result = sw_input_handle(ensemble, "f1");
+  assert(h_result.error_code == SW_SUCCESS);
+  assert(h_result.error_message == NULL);
+  sw_handle_t f1 = h_result.handle;
+  h_result = sw_input_handle(ensemble, "l1");
+  assert(h_result.error_code == SW_SUCCESS);
+  sw_handle_t l1 = h_result.handle;
+  h_result = sw_input_handle(ensemble, "e1");
+  assert(h_result.error_code == SW_SUCCESS);
+  sw_handle_t e1 = h_result.handle;
+  h_result = sw_input_array_handle(ensemble, "fa");
+  assert(h_result.error_code == SW_SUCCESS);
+  sw_handle_t fa = h_result.handle;
+  h_result = sw_input_array_handle(ensemble, "ea");
+  assert(h_result.error_code == SW_SUCCESS);
+  sw_handle_t ea = h_result.handle;
+
+  // Look for parameters that don't exist.
+  h_result = sw_input_handle(ensemble, "invalid_param");
+  assert(h_result.error_code == SW_PARAM_NOT_FOUND);
+  assert(h_result.error_message != NULL);
+  h_result = sw_input_array_handle(ensemble, "f1");
+  assert(h_result.error_code == SW_PARAM_NOT_FOUND);
+  assert(h_result.error_message != NULL);
+
+  // Fetch handles for output quantities. A name always gets the same handle.
+  sw_handle_t qoi = sw_output_handle(ensemble, "qoi");
+  assert(sw_output_handle(ensemble, "qoi") == qoi);
+  sw_handle_t qoi_array = sw_output_array_handle(ensemble, "qoi_array");
+
+  sw_input_t *input;
+  sw_output_t *output;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_input_result_t in_result;
+    sw_input_array_result_t in_array_result;
+
+    // Handles give the same values as names.
+    in_result = sw_input_get_h(input, f1);
+    assert(in_result.error_code == SW_SUCCESS);
+    assert(in_result.error_message == NULL);
+    assert(approx_equal(in_result.value, 1.0));
+
+    in_result = sw_input_get_h(input, l1);
+    assert(in_result.error_code == SW_SUCCESS);
+    assert(approx_equal(in_result.value, sw_input_get(input, "l1").value));
+    assert(in_result.value >= 1.0);
+    assert(in_result.value <= 3.0);
+    sw_real_t l1_value = in_result.value;
+
+    in_result = sw_input_get_h(input, e1);
+    assert(in_result.error_code == SW_SUCCESS);
+    assert(approx_equal(in_result.value, sw_input_get(input, "e1").value));
+    sw_real_t e1_value = in_result.value;
+
+    in_array_result = sw_input_get_array_h(input, fa);
+    assert(in_array_result.error_code == SW_SUCCESS);
+    assert(in_array_result.error_message == NULL);
+    assert(in_array_result.size == 3);
+    assert(approx_equal(in_array_result.values[0], 1.0));
+    assert(approx_equal(in_array_result.values[1], 2.0));
+    assert(approx_equal(in_array_result.values[2], 3.0));
+
+    in_array_result = sw_input_get_array_h(input, ea);
+    assert(in_array_result.error_code == SW_SUCCESS);
+    assert(in_array_result.size == 2);
+    assert(approx_equal(in_array_result.values[1],
+                        in_array_result.values[0] + 1.0));
+    assert(in_array_result.values ==
+           sw_input_get_array(input, "ea").values);
+
+    // Try some invalid handles.
+    in_result = sw_input_get_h(input, -1);
+    assert(in_result.error_code == SW_PARAM_NOT_FOUND);
+    assert(in_result.error_message != NULL);
+    in_result = sw_input_get_h(input, 1000);
+    assert(in_result.error_code == SW_PARAM_NOT_FOUND);
+    in_array_result = sw_input_get_array_h(input, 1000);
+    assert(in_array_result.error_code == SW_PARAM_NOT_FOUND);
+    assert(in_array_result.error_message != NULL);
+
+    // Invalid output handles are ignored (and register nothing).
+    sw_output_set_h(output, -1, 1.0);
+    sw_output_set_h(output, 1000, 1.0);
+    sw_real_t ignored[2] = {1.0, 1.0};
+    sw_output_set_array_h(output, -1, ignored, 2);
+    assert(sw_output_reserve_array_h(output, 1000, 2) == NULL);
+
+    // Set outputs using handles and names.
+    sw_output_set_h(output, qoi, l1_value * e1_value);
+    sw_output_set(output, "named_qoi", e1_value);
+    sw_real_t qoi_values[2] = {l1_value, e1_value};
+    sw_output_set_array_h(output, qoi_array, qoi_values, 2);
+  }
+
+  // Write out a Python module.
+  sw_write_result_t w_result = sw_ensemble_write(ensemble, "handle_test.py");
+  if (w_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", w_result.error_message);
+    exit(-1);
+  }
+
+  // Clean up.
+  sw_ensemble_free(ensemble);
+}
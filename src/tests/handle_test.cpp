@@ -0,0 +1,130 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C++ interface for accessing input parameters
+// and output quantities using handles.
+
+#include <skywalker.hpp>
+
+#include <cassert>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+
+void usage(const std::string& prog_name) {
+  std::cerr << prog_name << ": usage:" << std::endl;
+  std::cerr << prog_name << " <input.yaml>" << std::endl;
+  exit(0);
+}
+
+static bool approx_equal(sw_real_t x, sw_real_t y) {
+  return (std::abs(x - y) < 1e-14);
+}
+
+using namespace skywalker;
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  std::string input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  print_banner();
+
+  // Load the ensemble. Any error encountered is fatal.
+  std::cerr << "handle_test: Loading ensemble from " << input_file << std::endl;
+  Ensemble* ensemble = load_ensemble(input_file, "settings");
+  assert(ensemble->size() == 6);
+
+  // Fetch handles for input parameters and output quantities.
+  Handle f1 = ensemble->input_handle("f1");
+  Handle l1 = ensemble->input_handle("l1");
+  Handle e1 = ensemble->input_handle("e1");
+  Handle fa = ensemble->input_array_handle("fa");
+  Handle ea = ensemble->input_array_handle("ea");
+  Handle qoi = ensemble->output_handle("qoi");
+  assert(ensemble->output_handle("qoi") == qoi);
+  Handle qoi_array = ensemble->output_array_handle("qoi_array");
+
+  // Look for a parameter that doesn't exist.
+  try {
+    ensemble->input_handle("invalid_param");
+    assert(false);
+  } catch (Exception&) {
+  }
+
+  ensemble->process([=](const Input& input, Output& output) {
+    // Handles give the same values as names.
+    assert(approx_equal(input.get(f1), 1.0));
+    Real l1_value = input.get(l1);
+    assert(approx_equal(l1_value, input.get("l1")));
+    assert(l1_value >= 1.0);
+    assert(l1_value <= 3.0);
+    Real e1_value = input.get(e1);
+    assert(approx_equal(e1_value, input.get("e1")));
+
+    auto fa_values = input.get_array(fa);
+    assert(fa_values.size() == 3);
+    assert(approx_equal(fa_values[0], 1.0));
+    assert(approx_equal(fa_values[1], 2.0));
+    assert(approx_equal(fa_values[2], 3.0));
+
+    auto ea_values = input.get_array(ea);
+    assert(ea_values == input.get_array("ea"));
+    assert(input.get_array_view(ea).to_vector() == ea_values);
+    assert(ea_values.size() == 2);
+    assert(approx_equal(ea_values[1], ea_values[0] + 1.0));
+
+    // Try an invalid handle.
+    try {
+      input.get(1000);
+      assert(false);
+    } catch (Exception&) {
+    }
+
+    // Set outputs using handles and names.
+    output.set(qoi, l1_value * e1_value);
+    output.set("named_qoi", e1_value);
+    output.set(qoi_array, std::vector<Real>({l1_value, e1_value}));
+  });
+
+  // Write out a Python module.
+  ensemble->write("handle_test_cpp.py");
+
+  // Clean up.
+  delete ensemble;
+}
@@ -0,0 +1,194 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+// This program tests Skywalker's C interface for memoizing ensemble members.
+
+#include <skywalker.h>
+
+#include <assert.h>
+#include <string.h>
+#include <tgmath.h>
+
+void usage(const char *prog_name) {
+  fprintf(stderr, "%s: usage:\n", prog_name);
+  fprintf(stderr, "%s <input.yaml>\n", prog_name);
+  exit(0);
+}
+
+// Returns true if the file with the given name contains the given text.
+static bool file_contains(const char *filename, const char *text) {
+  FILE *file = fopen(filename, "r");
+  assert(file);
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *contents = malloc(size + 1);
+  size_t num_read = fread(contents, 1, size, file);
+  contents[num_read] = '\0';
+  fclose(file);
+  bool found = (strstr(contents, text) != NULL);
+  free(contents);
+  return found;
+}
+
+// Loads the ensemble in the given file, which has the given number of members,
+// and memoizes its members in memo_test.memo. Any error encountered is fatal.
+static sw_ensemble_t *load(const char *input_file, size_t size) {
+  sw_ensemble_result_t load_result = sw_load_ensemble(input_file, "settings");
+  if (load_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", load_result.error_message);
+    exit(-1);
+  }
+  assert(sw_ensemble_size(load_result.ensemble) == size);
+  sw_write_result_t w_result = sw_ensemble_memoize(load_result.ensemble,
+                                                   "memo_test.memo");
+  assert(w_result.error_code == SW_SUCCESS);
+  return load_result.ensemble;
+}
+
+// Sets outputs for an ensemble member.
+static void process(sw_input_t *input, sw_output_t *output) {
+  sw_input_result_t in_result = sw_input_get(input, "x");
+  assert(in_result.error_code == SW_SUCCESS);
+  sw_real_t x = in_result.value;
+  sw_output_set(output, "x2", x * x);
+  if (x >= 5.0) {
+    sw_output_set(output, "late", x);
+  }
+  sw_real_t values[3] = {x, x + 1, x + 2};
+  sw_output_set_array(output, "xs", values, (x < 3.0) ? 2 : 3);
+}
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  const char* input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  sw_print_banner();
+
+  fprintf(stderr, "memo_test: Loading ensemble from %s\n", input_file);
+  remove("memo_test.memo");
+
+  // Process 4 members, stopping before the traversal moves past the fourth.
+  // Only the first 3 are memoized.
+  sw_ensemble_t *ensemble = load(input_file, 10);
+  sw_input_t *input;
+  sw_output_t *output;
+  size_t i = 0;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    process(input, output);
+    if (++i == 4) break;
+  }
+  sw_ensemble_free(ensemble);
+
+  // Simulate an interruption during the writing of a record.
+  FILE *file = fopen("memo_test.memo", "ab");
+  fprintf(file, "partial");
+  fclose(file);
+
+  // Process the ensemble again. Memoized members are skipped, and their
+  // outputs filled from the memo.
+  ensemble = load(input_file, 10);
+  i = 0;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    if (i == 0) {
+      sw_input_result_t in_result = sw_input_get(input, "x");
+      assert(in_result.value == 4.0);
+    }
+    process(input, output);
+    ++i;
+  }
+  assert(i == 7);
+  sw_write_result_t w_result = sw_ensemble_write(ensemble, "memo_test.py");
+  assert(w_result.error_code == SW_SUCCESS);
+  sw_ensemble_free(ensemble);
+  assert(file_contains("memo_test.py",
+                       "output.x2 = [1, 4, 9, 16, 25, 36, 49, 64, 81, 100, ]"));
+  assert(file_contains("memo_test.py",
+                       "output.late = [nan, nan, nan, nan, 5, "));
+  assert(file_contains("memo_test.py",
+                       "output.xs = [[1, 2, ],[2, 3, ],[3, 4, 5, ],"));
+
+  // Refine the lattice. Only the new members are processed.
+  file = fopen("memo_test_refined.yaml", "w");
+  fprintf(file, "settings:\n  s1: memo\n\n"
+                "input:\n"
+                "  fixed:\n    fa: [1, 2]\n    f1: 1\n"
+                "  lattice:\n    x: [1, 10, 0.5]\n");
+  fclose(file);
+  ensemble = load("memo_test_refined.yaml", 19);
+  i = 0;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_input_result_t in_result = sw_input_get(input, "x");
+    assert(in_result.value != floor(in_result.value));
+    process(input, output);
+    ++i;
+  }
+  assert(i == 9);
+  w_result = sw_ensemble_write(ensemble, "memo_test.py");
+  assert(w_result.error_code == SW_SUCCESS);
+  sw_ensemble_free(ensemble);
+  assert(file_contains("memo_test.py", "output.x2 = [1, 2.25, 4, 6.25, 9, "));
+
+  // Every member of the refined lattice is now memoized.
+  ensemble = load("memo_test_refined.yaml", 19);
+  assert(!sw_ensemble_next(ensemble, &input, &output));
+
+  // Members can be memoized only once, and only before a traversal.
+  w_result = sw_ensemble_memoize(ensemble, "memo_test.memo");
+  assert(w_result.error_code == SW_WRITE_FAILURE);
+  sw_ensemble_free(ensemble);
+  sw_ensemble_result_t load_result = sw_load_ensemble(input_file, "settings");
+  assert(load_result.error_code == SW_SUCCESS);
+  ensemble = load_result.ensemble;
+  assert(sw_ensemble_next(ensemble, &input, &output));
+  w_result = sw_ensemble_memoize(ensemble, "memo_test.memo");
+  assert(w_result.error_code == SW_WRITE_FAILURE);
+  sw_ensemble_free(ensemble);
+
+  // A file that isn't a memo can't be used as one.
+  file = fopen("memo_test_other.memo", "w");
+  fprintf(file, "This isn't a memo file.\n");
+  fclose(file);
+  load_result = sw_load_ensemble(input_file, "settings");
+  assert(load_result.error_code == SW_SUCCESS);
+  ensemble = load_result.ensemble;
+  w_result = sw_ensemble_memoize(ensemble, "memo_test_other.memo");
+  assert(w_result.error_code == SW_WRITE_FAILURE);
+  assert(w_result.error_message != NULL);
+  sw_ensemble_free(ensemble);
+}
@@ -0,0 +1,397 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's ability to write ensemble data to NumPy
+// archives (.npz files).
+
+#include <skywalker.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+static void write_test_input(const char* yaml_text, const char* filename) {
+  FILE *f = fopen(filename, "w");
+  fprintf(f, "%s", yaml_text);
+  fclose(f);
+}
+
+// Reads the entire contents of the file with the given name, storing its size.
+static unsigned char *read_file(const char *filename, size_t *size) {
+  FILE *f = fopen(filename, "rb");
+  assert(f);
+  fseek(f, 0, SEEK_END);
+  *size = (size_t)ftell(f);
+  fseek(f, 0, SEEK_SET);
+  unsigned char *bytes = malloc(*size);
+  assert(fread(bytes, 1, *size, f) == *size);
+  fclose(f);
+  return bytes;
+}
+
+static size_t get_u16(const unsigned char *p) {
+  return (size_t)p[0] | ((size_t)p[1] << 8);
+}
+
+static size_t get_u32(const unsigned char *p) {
+  return get_u16(p) | (get_u16(p+2) << 16);
+}
+
+// Finds the .npy file for the array with the given name in the given archive,
+// returning a pointer to the array's data (or NULL if it isn't found) and
+// storing its header.
+static const unsigned char *find_array(const unsigned char *archive,
+                                       size_t size, const char *name,
+                                       char header[256]) {
+  char filename[128];
+  snprintf(filename, 128, "%s.npy", name);
+  const unsigned char *p = archive;
+  while ((p + 30 <= archive + size) && (get_u32(p) == 0x04034b50)) {
+    size_t data_size = get_u32(&p[18]);
+    size_t name_length = get_u16(&p[26]), extra_length = get_u16(&p[28]);
+    assert(get_u16(&p[8]) == 0); // stored, not compressed
+    const unsigned char *data = p + 30 + name_length + extra_length;
+    if ((name_length == strlen(filename)) &&
+        !strncmp((const char*)&p[30], filename, name_length)) {
+      assert(!memcmp(data, "\x93NUMPY", 6));
+      size_t header_length = get_u16(&data[8]);
+      assert((10 + header_length) % 64 == 0);
+      memcpy(header, &data[10], header_length);
+      header[header_length] = '\0';
+      return &data[10 + header_length];
+    }
+    p = data + data_size;
+  }
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+
+  // We ignore command line arguments in favor of a generated input.
+
+  // Print a banner with Skywalker's version info.
+  sw_print_banner();
+
+  const char* yaml =
+    "settings:\n  s1: npz\n\n"
+    "input:\n"
+    "  fixed:\n    f1: 1\n    fa: [5, 6]\n"
+    "  lattice:\n    l1: [1, 3, 1]\n"
+    "  enumerated:\n    e1: [0.1, 0.2]\n    ea: [[1, 2], [3, 4]]\n";
+  write_test_input(yaml, "npz_test.yaml");
+  sw_ensemble_result_t load_result = sw_load_ensemble("npz_test.yaml",
+                                                      "settings");
+  assert(load_result.error_code == SW_SUCCESS);
+  sw_ensemble_t *ensemble = load_result.ensemble;
+  assert(sw_ensemble_size(ensemble) == 6);
+
+  // Set some outputs, leaving some unset and making some arrays ragged.
+  sw_input_t *input;
+  sw_output_t *output;
+  size_t i = 0;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_real_t e1 = sw_input_get(input, "e1").value;
+    sw_output_set(output, "qoi", e1 / 3);
+    if (i % 2) sw_output_set(output, "odd_qoi", (sw_real_t)i);
+    sw_real_t values[3] = {e1, 2 * e1, 3 * e1};
+    sw_output_set_array(output, "ragged", values, 1 + i % 3);
+    sw_output_set_array(output, "even", values, 2);
+    ++i;
+  }
+
+  // Write a NumPy archive, selecting the format by the file's extension.
+  sw_write_result_t w_result = sw_ensemble_write(ensemble, "npz_test.npz");
+  assert(w_result.error_code == SW_SUCCESS);
+  w_result = sw_ensemble_write_format(ensemble, "npz_test_npz",
+                                      SW_NUMPY_ARCHIVE);
+  assert(w_result.error_code == SW_SUCCESS);
+  w_result = sw_ensemble_write_format(ensemble, "npz_test.py",
+                                      SW_PYTHON_MODULE);
+  assert(w_result.error_code == SW_SUCCESS);
+  w_result = sw_ensemble_write_format(ensemble, "/nonexistent/npz_test.npz",
+                                      SW_NUMPY_ARCHIVE);
+  assert(w_result.error_code == SW_WRITE_FAILURE);
+  assert(w_result.error_message != NULL);
+  w_result = sw_ensemble_write_format(ensemble, "npz_test.npz",
+                                      (sw_write_format_t)42);
+  assert(w_result.error_code == SW_WRITE_FAILURE);
+
+  // Read the archive back and check its contents.
+  size_t size, size2;
+  unsigned char *archive = read_file("npz_test.npz", &size);
+  unsigned char *archive2 = read_file("npz_test_npz", &size2);
+  assert((size == size2) && !memcmp(archive, archive2, size));
+  free(archive2);
+  char header[256];
+  const char *real_descr = (sizeof(sw_real_t) == 8) ? "f8" : "f4";
+
+  const unsigned char *data = find_array(archive, size, "settings.s1", header);
+  assert(data);
+  assert(strstr(header, "U3'"));
+  assert(strstr(header, "'shape': ()"));
+  assert((data[0] == 'n') && (data[4] == 'p') && (data[8] == 'z'));
+
+  data = find_array(archive, size, "input.f1", header);
+  assert(data);
+  assert(strstr(header, real_descr));
+  assert(strstr(header, "'shape': (6,)"));
+  sw_real_t values[12];
+  memcpy(values, data, 6 * sizeof(sw_real_t));
+  for (i = 0; i < 6; ++i) assert(values[i] == 1);
+
+  data = find_array(archive, size, "input.e1", header);
+  assert(data);
+  memcpy(values, data, 6 * sizeof(sw_real_t));
+  for (i = 0; i < 6; ++i)
+    assert(values[i] == ((i % 2) ? (sw_real_t)0.2 : (sw_real_t)0.1));
+
+  data = find_array(archive, size, "input.ea", header);
+  assert(data);
+  assert(strstr(header, "'shape': (6, 2)"));
+  assert(!find_array(archive, size, "input.ea.sizes", header));
+  memcpy(values, data, 12 * sizeof(sw_real_t));
+  assert((values[2] == 3) && (values[3] == 4));
+
+  // Outputs are stored at full precision.
+  data = find_array(archive, size, "output.qoi", header);
+  assert(data);
+  memcpy(values, data, 6 * sizeof(sw_real_t));
+  assert(values[0] == (sw_real_t)0.1 / 3);
+  assert(values[1] == (sw_real_t)0.2 / 3);
+
+  data = find_array(archive, size, "output.odd_qoi", header);
+  assert(data);
+  memcpy(values, data, 6 * sizeof(sw_real_t));
+  assert(isnan(values[0]) && (values[1] == 1));
+
+  data = find_array(archive, size, "output.ragged", header);
+  assert(data);
+  assert(strstr(header, "'shape': (6, 3)"));
+  memcpy(values, data, 12 * sizeof(sw_real_t));
+  assert(values[0] == (sw_real_t)0.1);
+  assert(isnan(values[1]) && isnan(values[2]));
+  data = find_array(archive, size, "output.ragged.sizes", header);
+  assert(data);
+  assert(strstr(header, "i8"));
+  int64_t sizes[6];
+  memcpy(sizes, data, sizeof(sizes));
+  for (i = 0; i < 6; ++i) assert(sizes[i] == (int64_t)(1 + i % 3));
+
+  data = find_array(archive, size, "output.even", header);
+  assert(data);
+  assert(strstr(header, "'shape': (6, 2)"));
+  assert(!find_array(archive, size, "output.even.sizes", header));
+
+  // Slice the archive, and check that the slices' rows are padded only to the
+  // length of their own longest rows.
+  w_result = sw_archive_slice("npz_test.npz", 0, 2, "npz_test_0.npz");
+  assert(w_result.error_code == SW_SUCCESS);
+  w_result = sw_archive_slice("npz_test.npz", 2, 3, "npz_test_1.npz");
+  assert(w_result.error_code == SW_SUCCESS);
+  w_result = sw_archive_slice("npz_test.npz", 3, 6, "npz_test_2.npz");
+  assert(w_result.error_code == SW_SUCCESS);
+  unsigned char *slice = read_file("npz_test_0.npz", &size2);
+  data = find_array(slice, size2, "input.e1", header);
+  assert(data);
+  assert(strstr(header, "'shape': (2,)"));
+  memcpy(values, data, 2 * sizeof(sw_real_t));
+  assert((values[0] == (sw_real_t)0.1) && (values[1] == (sw_real_t)0.2));
+  data = find_array(slice, size2, "output.ragged", header);
+  assert(data);
+  assert(strstr(header, "'shape': (2, 2)"));
+  assert(find_array(slice, size2, "output.ragged.sizes", header));
+  free(slice);
+  slice = read_file("npz_test_1.npz", &size2);
+  data = find_array(slice, size2, "output.ragged", header);
+  assert(data);
+  assert(strstr(header, "'shape': (1, 3)"));
+  assert(!find_array(slice, size2, "output.ragged.sizes", header));
+  data = find_array(slice, size2, "output.odd_qoi", header);
+  assert(data);
+  memcpy(values, data, sizeof(sw_real_t));
+  assert(isnan(values[0]));
+  free(slice);
+
+  // Merging the slices reproduces the original archive.
+  const char *slices[3] = {"npz_test_0.npz", "npz_test_1.npz",
+                           "npz_test_2.npz"};
+  w_result = sw_archive_merge(3, slices, "npz_test_merged.npz");
+  assert(w_result.error_code == SW_SUCCESS);
+  unsigned char *merged = read_file("npz_test_merged.npz", &size2);
+  assert((size == size2) && !memcmp(archive, merged, size));
+  free(merged);
+
+  // Invalid slices and merges.
+  w_result = sw_archive_slice("npz_test.npz", 4, 7, "npz_test_0.npz");
+  assert(w_result.error_code == SW_INVALID_ARCHIVE);
+  assert(w_result.error_message != NULL);
+  w_result = sw_archive_slice("npz_test.npz", 4, 3, "npz_test_0.npz");
+  assert(w_result.error_code == SW_INVALID_ARCHIVE);
+  w_result = sw_archive_slice("npz_test.npz", 3, 3, "npz_test_0.npz");
+  assert(w_result.error_code == SW_EMPTY_ENSEMBLE);
+  w_result = sw_archive_slice("npz_test.npz", 0, 3, "npz_test.npz");
+  assert(w_result.error_code == SW_INVALID_ARCHIVE);
+  w_result = sw_archive_slice("npz_test.py", 0, 3, "npz_test_0.npz");
+  assert(w_result.error_code == SW_INVALID_ARCHIVE);
+  w_result = sw_archive_slice("nonexistent.npz", 0, 3, "npz_test_0.npz");
+  assert(w_result.error_code == SW_INVALID_ARCHIVE);
+  w_result = sw_archive_merge(0, slices, "npz_test_merged.npz");
+  assert(w_result.error_code == SW_INVALID_ARCHIVE);
+  w_result = sw_archive_merge(3, slices, "/nonexistent/npz_test.npz");
+  assert(w_result.error_code == SW_WRITE_FAILURE);
+
+  // Archives for different ensembles can't be merged.
+  write_test_input("settings:\n  s1: npy\n\ninput:\n  fixed:\n    f1: 1\n",
+                   "npz_test_other.yaml");
+  load_result = sw_load_ensemble("npz_test_other.yaml", "settings");
+  assert(load_result.error_code == SW_SUCCESS);
+  w_result = sw_ensemble_write(load_result.ensemble, "npz_test_other.npz");
+  assert(w_result.error_code == SW_SUCCESS);
+  sw_ensemble_free(load_result.ensemble);
+  const char *others[2] = {"npz_test.npz", "npz_test_other.npz"};
+  w_result = sw_archive_merge(2, others, "npz_test_merged.npz");
+  assert(w_result.error_code == SW_INVALID_ARCHIVE);
+  assert(strstr(w_result.error_message, "npz_test_other.npz"));
+
+  // Write fixed inputs once.
+  sw_write_options_t options = {.format = SW_NUMPY_ARCHIVE,
+                                .fixed_inputs_once = true};
+  w_result = sw_ensemble_write_options(ensemble, "npz_test_once.npz",
+                                       &options);
+  assert(w_result.error_code == SW_SUCCESS);
+  unsigned char *once = read_file("npz_test_once.npz", &size2);
+  assert(size2 < size);
+  data = find_array(once, size2, "input.f1", header);
+  assert(data);
+  assert(strstr(header, "'shape': ()"));
+  memcpy(values, data, sizeof(sw_real_t));
+  assert(values[0] == 1);
+  data = find_array(once, size2, "input.fa", header);
+  assert(data);
+  assert(strstr(header, "'shape': (1, 2)"));
+  memcpy(values, data, 2 * sizeof(sw_real_t));
+  assert((values[0] == 5) && (values[1] == 6));
+  data = find_array(once, size2, "input.e1", header);
+  assert(data);
+  assert(strstr(header, "'shape': (6,)"));
+  free(once);
+
+  // Slices of such an archive keep fixed inputs once, and merging one with a
+  // slice of the original archive repeats them.
+  w_result = sw_archive_slice("npz_test_once.npz", 0, 3, "npz_test_0.npz");
+  assert(w_result.error_code == SW_SUCCESS);
+  slice = read_file("npz_test_0.npz", &size2);
+  assert(find_array(slice, size2, "input.f1", header));
+  assert(strstr(header, "'shape': ()"));
+  assert(find_array(slice, size2, "input.fa", header));
+  assert(strstr(header, "'shape': (1, 2)"));
+  free(slice);
+  const char *mixed[2] = {"npz_test_0.npz", "npz_test_2.npz"};
+  w_result = sw_archive_merge(2, mixed, "npz_test_merged.npz");
+  assert(w_result.error_code == SW_SUCCESS);
+  merged = read_file("npz_test_merged.npz", &size2);
+  assert((size == size2) && !memcmp(archive, merged, size));
+  free(merged);
+
+  // Write selected quantities.
+  const char *quantities[2] = {"output", "input.e1"};
+  options = (sw_write_options_t){.format = SW_NUMPY_ARCHIVE,
+                                 .num_quantities = 2,
+                                 .quantities = quantities};
+  w_result = sw_ensemble_write_options(ensemble, "npz_test_selected.npz",
+                                       &options);
+  assert(w_result.error_code == SW_SUCCESS);
+  unsigned char *selected = read_file("npz_test_selected.npz", &size2);
+  assert(!find_array(selected, size2, "settings.s1", header));
+  assert(!find_array(selected, size2, "input.f1", header));
+  assert(find_array(selected, size2, "input.e1", header));
+  assert(find_array(selected, size2, "output.qoi", header));
+  assert(find_array(selected, size2, "output.ragged.sizes", header));
+  free(selected);
+
+  // Write values with reduced precision.
+  options = (sw_write_options_t){.format = SW_NUMPY_ARCHIVE, .precision = 6};
+  w_result = sw_ensemble_write_options(ensemble, "npz_test_f4.npz", &options);
+  assert(w_result.error_code == SW_SUCCESS);
+  unsigned char *reduced = read_file("npz_test_f4.npz", &size2);
+  data = find_array(reduced, size2, "output.qoi", header);
+  assert(data);
+  assert(strstr(header, "'<f4'"));
+  float fvalue;
+  memcpy(&fvalue, data, sizeof(float));
+  assert(fvalue == (float)((sw_real_t)0.1 / 3));
+  free(reduced);
+  options.format = SW_PYTHON_MODULE;
+  w_result = sw_ensemble_write_options(ensemble, "npz_test_f4.py", &options);
+  assert(w_result.error_code == SW_SUCCESS);
+  char *module = (char*)read_file("npz_test_f4.py", &size2);
+  module = realloc(module, size2 + 1);
+  module[size2] = '\0';
+  assert(strstr(module, "0.0333333, "));
+  assert(!strstr(module, "0.03333333"));
+  free(module);
+
+  // Write a compressed archive, if we can.
+  options = (sw_write_options_t){.format = SW_NUMPY_ARCHIVE, .compress = true};
+  w_result = sw_ensemble_write_options(ensemble, "npz_test_compressed.npz",
+                                       &options);
+#ifdef SKYWALKER_HAVE_ZLIB
+  assert(w_result.error_code == SW_SUCCESS);
+  unsigned char *compressed = read_file("npz_test_compressed.npz", &size2);
+  assert(size2 < size);
+  assert(get_u16(&compressed[8]) == 8); // deflated
+  free(compressed);
+  w_result = sw_archive_slice("npz_test_compressed.npz", 0, 3,
+                              "npz_test_0.npz");
+  assert(w_result.error_code == SW_INVALID_ARCHIVE);
+#else
+  assert(w_result.error_code == SW_WRITE_FAILURE);
+#endif
+
+  // Options other than the format can't be applied to a stream.
+  load_result = sw_load_ensemble("npz_test_other.yaml", "settings");
+  assert(load_result.error_code == SW_SUCCESS);
+  w_result = sw_ensemble_stream(load_result.ensemble, "npz_test_stream.py", 1);
+  assert(w_result.error_code == SW_SUCCESS);
+  options = (sw_write_options_t){.fixed_inputs_once = true};
+  w_result = sw_ensemble_write_options(load_result.ensemble,
+                                       "npz_test_stream.py", &options);
+  assert(w_result.error_code == SW_WRITE_FAILURE);
+  sw_ensemble_free(load_result.ensemble);
+
+  free(archive);
+  sw_ensemble_free(ensemble);
+}
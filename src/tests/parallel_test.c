@@ -0,0 +1,163 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C interface for accessing ensemble members by
+// index and traversing ensembles in independent ranges.
+
+#include <skywalker.h>
+
+#include <assert.h>
+#include <string.h>
+#include <tgmath.h>
+
+void usage(const char *prog_name) {
+  fprintf(stderr, "%s: usage:\n", prog_name);
+  fprintf(stderr, "%s <input.yaml>\n", prog_name);
+  exit(0);
+}
+
+static bool approx_equal(sw_real_t x, sw_real_t y) {
+  return (fabs(x - y) < 1e-14);
+}
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  const char* input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  sw_print_banner();
+
+  // Load the ensemble. Any error encountered is fatal.
+  fprintf(stderr, "parallel_test: Loading ensemble from %s\n", input_file);
+  sw_ensemble_result_t load_result = sw_load_ensemble(input_file, "settings");
+  if (load_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", load_result.error_message);
+    exit(-1);
+  }
+
+  sw_ensemble_t *ensemble = load_result.ensemble;
+  size_t size = sw_ensemble_size(ensemble);
+  assert(size == 330);
+
+  // Record the inputs visited by a sequential traversal.
+  sw_input_t **inputs = malloc(sizeof(sw_input_t*) * size);
+  sw_output_t **outputs = malloc(sizeof(sw_output_t*) * size);
+  sw_real_t *l1 = malloc(sizeof(sw_real_t) * size);
+  sw_real_t *e1 = malloc(sizeof(sw_real_t) * size);
+  sw_input_t *input;
+  sw_output_t *output;
+  size_t m = 0;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    inputs[m] = input;
+    outputs[m] = output;
+    l1[m] = sw_input_get(input, "l1").value;
+    e1[m] = sw_input_get(input, "e1").value;
+    ++m;
+  }
+  assert(m == size);
+
+  // Inputs stay valid for the lifetime of the ensemble.
+  for (m = 0; m < size; ++m) {
+    assert(approx_equal(sw_input_get(inputs[m], "l1").value, l1[m]));
+    assert(approx_equal(sw_input_get(inputs[m], "e1").value, e1[m]));
+  }
+
+  // Access members by index.
+  for (size_t i = 0; i < size; ++i) {
+    assert(sw_ensemble_get(ensemble, i, &input, &output));
+    assert(input == inputs[i]);
+    assert(output == outputs[i]);
+    assert(approx_equal(sw_input_get(input, "f1").value, 1.0));
+    assert(approx_equal(sw_input_get(input, "l1").value, l1[i]));
+    assert(approx_equal(sw_input_get(input, "e1").value, e1[i]));
+    sw_input_array_result_t e2 = sw_input_get_array(input, "e2");
+    assert(e2.size == 2);
+    assert(approx_equal(e2.values[0], e1[i]));
+    assert(approx_equal(e2.values[1], e1[i] + 1.0));
+  }
+  assert(!sw_ensemble_get(ensemble, size, &input, &output));
+  assert(input == NULL);
+  assert(output == NULL);
+
+  // Ranges are clipped to the ensemble.
+  sw_ensemble_range_t range = sw_ensemble_range(ensemble, 300, 1000);
+  assert(range.position == 300);
+  assert(range.end == size);
+  range = sw_ensemble_range(ensemble, 1000, 2000);
+  assert(!sw_ensemble_range_next(&range, &input, &output));
+
+  // Traverse the ensemble in 4 interleaved ranges, setting outputs with a
+  // handle.
+  sw_handle_t qoi = sw_output_handle(ensemble, "qoi");
+  size_t chunk_size = (size + 3) / 4;
+  sw_ensemble_range_t ranges[4];
+  for (int r = 0; r < 4; ++r) {
+    ranges[r] = sw_ensemble_range(ensemble, r * chunk_size,
+                                  (r + 1) * chunk_size);
+  }
+  size_t num_visited = 0;
+  bool visiting = true;
+  while (visiting) {
+    visiting = false;
+    for (int r = 0; r < 4; ++r) {
+      size_t i = ranges[r].position;
+      if (sw_ensemble_range_next(&ranges[r], &input, &output)) {
+        assert(input == inputs[i]);
+        assert(output == outputs[i]);
+        sw_output_set_h(output, qoi, l1[i] * e1[i]);
+        ++num_visited;
+        visiting = true;
+      }
+    }
+  }
+  assert(num_visited == size);
+
+  // Write out a Python module.
+  sw_write_result_t w_result = sw_ensemble_write(ensemble, "parallel_test.py");
+  if (w_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", w_result.error_message);
+    exit(-1);
+  }
+
+  // Clean up.
+  free(inputs);
+  free(outputs);
+  free(l1);
+  free(e1);
+  sw_ensemble_free(ensemble);
+}
@@ -0,0 +1,133 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C++ interface for processing ensemble members
+// in parallel.
+
+#include <skywalker.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+
+void usage(const std::string& prog_name) {
+  std::cerr << prog_name << ": usage:" << std::endl;
+  std::cerr << prog_name << " <input.yaml>" << std::endl;
+  exit(0);
+}
+
+static bool approx_equal(sw_real_t x, sw_real_t y) {
+  return (std::abs(x - y) < 1e-14);
+}
+
+using namespace skywalker;
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  std::string input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  print_banner();
+
+  // Load the ensemble. Any error encountered is fatal.
+  std::cerr << "parallel_test: Loading ensemble from " << input_file << std::endl;
+  Ensemble* ensemble = load_ensemble(input_file, "settings");
+  assert(ensemble->size() == 330);
+
+  Handle l1 = ensemble->input_handle("l1");
+  Handle e1 = ensemble->input_handle("e1");
+  Handle e2 = ensemble->input_array_handle("e2");
+  Handle qoi = ensemble->output_handle("qoi");
+
+  // Process the ensemble with a few threads, counting the visited members.
+  std::atomic<size_t> num_visited(0);
+  ensemble->process_parallel([&](const Input& input, Output& output) {
+    assert(approx_equal(input.get("f1"), 1.0));
+    Real l1_value = input.get(l1);
+    Real e1_value = input.get(e1);
+    auto e2_values = input.get_array(e2);
+    assert(e2_values.size() == 2);
+    assert(approx_equal(e2_values[0], e1_value));
+    output.set(qoi, l1_value * e1_value);
+    ++num_visited;
+  }, 4);
+  assert(num_visited == ensemble->size());
+
+  // Set outputs by name (including arrays of varying length) from several
+  // threads, registering new quantities as we go.
+  ensemble->process_parallel([&](const Input& input, Output& output) {
+    Real l1_value = input.get(l1);
+    Real e1_value = input.get(e1);
+    output.set("sum", l1_value + e1_value);
+    std::vector<Real> values(static_cast<size_t>(e1_value), l1_value);
+    output.set("values", values);
+  }, 4);
+
+  // Use the default number of threads.
+  num_visited = 0;
+  ensemble->process_parallel([&](const Input& input, Output& output) {
+    ++num_visited;
+  });
+  assert(num_visited == ensemble->size());
+
+  // Exceptions thrown by workers are passed along to the caller.
+  bool caught = false;
+  try {
+    ensemble->process_parallel([&](const Input& input, Output& output) {
+      if (approx_equal(input.get(l1), 5.0) && approx_equal(input.get(e1), 3.0))
+        throw std::runtime_error("member failed");
+    }, 3);
+  }
+  catch (std::runtime_error&) {
+    caught = true;
+  }
+  assert(caught);
+
+  // Quantities registered concurrently each got a single handle.
+  assert(ensemble->output_handle("sum") == 1);
+  assert(ensemble->output_array_handle("values") == 0);
+
+  // Write out a Python module.
+  ensemble->write("parallel_test_cpp.py");
+
+  // Clean up.
+  delete ensemble;
+}
@@ -0,0 +1,169 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C interface for restarting an interrupted
+// stream of ensemble outputs.
+
+#include <skywalker.h>
+
+#include <assert.h>
+#include <string.h>
+#include <tgmath.h>
+
+void usage(const char *prog_name) {
+  fprintf(stderr, "%s: usage:\n", prog_name);
+  fprintf(stderr, "%s <input.yaml>\n", prog_name);
+  exit(0);
+}
+
+// Returns true if the file with the given name contains the given text.
+static bool file_contains(const char *filename, const char *text) {
+  FILE *file = fopen(filename, "r");
+  assert(file);
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *contents = malloc(size + 1);
+  size_t num_read = fread(contents, 1, size, file);
+  contents[num_read] = '\0';
+  fclose(file);
+  bool found = (strstr(contents, text) != NULL);
+  free(contents);
+  return found;
+}
+
+// Loads the ensemble in the given file. Any error encountered is fatal.
+static sw_ensemble_t *load(const char *input_file) {
+  sw_ensemble_result_t load_result = sw_load_ensemble(input_file, "settings");
+  if (load_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", load_result.error_message);
+    exit(-1);
+  }
+  assert(sw_ensemble_size(load_result.ensemble) == 10);
+  return load_result.ensemble;
+}
+
+// Sets outputs for an ensemble member.
+static void process(sw_input_t *input, sw_output_t *output) {
+  sw_input_result_t in_result = sw_input_get(input, "x");
+  assert(in_result.error_code == SW_SUCCESS);
+  sw_real_t x = in_result.value;
+  sw_output_set(output, "x2", x * x);
+  if (x >= 5.0) {
+    sw_output_set(output, "late", x);
+  }
+  sw_real_t values[2] = {x, x + 1};
+  sw_output_set_array(output, "xs", values, 2);
+}
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  const char* input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  sw_print_banner();
+
+  fprintf(stderr, "restart_test: Loading ensemble from %s\n", input_file);
+  const char *module_filename = "restart_test.py";
+  remove(module_filename);
+
+  // Stream outputs in chunks of 3 members, stopping after 5 members. Only the
+  // first chunk is complete.
+  sw_ensemble_t *ensemble = load(input_file);
+  sw_write_result_t w_result = sw_ensemble_restart(ensemble, module_filename,
+                                                   3);
+  assert(w_result.error_code == SW_SUCCESS);
+  sw_input_t *input;
+  sw_output_t *output;
+  size_t i = 0;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    process(input, output);
+    if (++i == 5) break;
+  }
+  sw_ensemble_free(ensemble);
+  assert(file_contains(module_filename, "# completed members: 3\n"));
+  assert(!file_contains(module_filename, "del _extend"));
+
+  // Simulate an interruption during the writing of the next chunk.
+  FILE *file = fopen(module_filename, "a");
+  fprintf(file, "_extend('x2', 3, [16, ");
+  fclose(file);
+
+  // Restart the stream with a different chunk size. The traversal resumes with
+  // the first incomplete member.
+  ensemble = load(input_file);
+  w_result = sw_ensemble_restart(ensemble, module_filename, 4);
+  assert(w_result.error_code == SW_SUCCESS);
+  i = 0;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    if (i == 0) {
+      sw_input_result_t in_result = sw_input_get(input, "x");
+      assert(in_result.value == 4.0);
+    }
+    process(input, output);
+    ++i;
+  }
+  assert(i == 7);
+  w_result = sw_ensemble_write(ensemble, module_filename);
+  assert(w_result.error_code == SW_SUCCESS);
+  sw_ensemble_free(ensemble);
+
+  assert(!file_contains(module_filename, "[16, _extend"));
+  assert(file_contains(module_filename, "_extend('x2', 0, [1, 4, 9, ])\n"));
+  assert(file_contains(module_filename, "_extend('x2', 3, [16, 25, 36, 49, ])\n"));
+  assert(file_contains(module_filename, "_extend('late', 7, [8, 9, 10, ])\n"));
+  assert(file_contains(module_filename, "# completed members: 10\n"));
+  assert(file_contains(module_filename, "_finish(10)\n"));
+
+  // Restarting a finished stream skips every member and finishes it again.
+  ensemble = load(input_file);
+  w_result = sw_ensemble_restart(ensemble, module_filename, 4);
+  assert(w_result.error_code == SW_SUCCESS);
+  assert(!sw_ensemble_next(ensemble, &input, &output));
+  sw_ensemble_free(ensemble);
+  assert(file_contains(module_filename, "_finish(10)\n"));
+
+  // A module that wasn't streamed for the ensemble can't be restarted.
+  file = fopen("restart_test_other.py", "w");
+  fprintf(file, "# This isn't a streamed module.\n");
+  fclose(file);
+  ensemble = load(input_file);
+  w_result = sw_ensemble_restart(ensemble, "restart_test_other.py", 4);
+  assert(w_result.error_code == SW_WRITE_FAILURE);
+  sw_ensemble_free(ensemble);
+}
@@ -0,0 +1,116 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C++ interface for restarting an interrupted
+// stream of ensemble outputs.
+
+#include <skywalker.hpp>
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+void usage(const std::string& prog_name) {
+  std::cerr << prog_name << ": usage:" << std::endl;
+  std::cerr << prog_name << " <input.yaml>" << std::endl;
+  exit(0);
+}
+
+using namespace skywalker;
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  std::string input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  print_banner();
+
+  std::cerr << "restart_test: Loading ensemble from " << input_file << std::endl;
+  std::string module_filename = "restart_test_cpp.py";
+  std::remove(module_filename.c_str());
+
+  auto process = [](const Input& input, Output& output) {
+    Real x = input.get("x");
+    output.set("x2", x * x);
+    if (x >= 5.0) {
+      output.set("late", x);
+    }
+    output.set("xs", std::vector<Real>({x, x + 1}));
+  };
+
+  // Stream outputs in chunks of 3 members, failing at the sixth member. Only
+  // the first chunk is complete.
+  Ensemble* ensemble = load_ensemble(input_file, "settings");
+  ensemble->restart(module_filename, 3);
+  try {
+    ensemble->process([&](const Input& input, Output& output) {
+      if (input.get("x") == 6.0) {
+        throw std::runtime_error("interrupted");
+      }
+      process(input, output);
+    });
+    assert(false);
+  } catch (std::runtime_error&) {
+  }
+  delete ensemble;
+
+  // Restart the stream, which resumes with the first incomplete member.
+  ensemble = load_ensemble(input_file, "settings");
+  ensemble->restart(module_filename, 4);
+  size_t num_processed = 0;
+  ensemble->process([&](const Input& input, Output& output) {
+    if (num_processed == 0) {
+      assert(input.get("x") == 4.0);
+    }
+    process(input, output);
+    ++num_processed;
+  });
+  assert(num_processed == 7);
+  ensemble->write(module_filename);
+  delete ensemble;
+
+  // A stream can't be restarted from another ensemble's module.
+  ensemble = load_ensemble(input_file, "settings");
+  try {
+    ensemble->restart("restart_test.yaml", 4);
+    assert(false);
+  } catch (Exception&) {
+  }
+  delete ensemble;
+}
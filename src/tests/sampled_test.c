@@ -0,0 +1,138 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C interface with an ensemble that contains
+// parameters sampled from a Latin hypercube.
+
+#include <skywalker.h>
+
+#include <assert.h>
+#include <string.h>
+#include <tgmath.h>
+
+void usage(const char *prog_name) {
+  fprintf(stderr, "%s: usage:\n", prog_name);
+  fprintf(stderr, "%s <input.yaml>\n", prog_name);
+  exit(0);
+}
+
+static bool approx_equal(sw_real_t x, sw_real_t y) {
+  return (fabs(x - y) < 1e-14);
+}
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  const char* input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  sw_print_banner();
+
+  // Load the ensemble. Any error encountered is fatal.
+  fprintf(stderr, "sampled_test: Loading ensemble from %s\n", input_file);
+  sw_ensemble_result_t load_result = sw_load_ensemble(input_file, "settings");
+  if (load_result.error_code != SW_SUCCESS) {
+    printf("%s\n", load_result.error_message);
+    exit(-1);
+  }
+  assert(load_result.settings != NULL);
+  assert(load_result.ensemble != NULL);
+
+  // Ensemble data: 2 lattice values times 8 samples
+  sw_ensemble_t *ensemble = load_result.ensemble;
+  assert(sw_ensemble_size(ensemble) == 16);
+  sw_input_t *input;
+  sw_output_t *output;
+
+  // A Latin hypercube places exactly one sample in each of 8 equal intervals
+  // of each parameter's range. Each lattice value gets the same samples.
+  int x_hits[2][8] = {{0}}, k_hits[2][8] = {{0}};
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_input_result_t in_result;
+
+    // Fixed parameters
+    in_result = sw_input_get(input, "p1");
+    assert(in_result.error_code == SW_SUCCESS);
+    assert(approx_equal(in_result.value, 1.0));
+
+    // Lattice parameters
+    in_result = sw_input_get(input, "mode");
+    assert(in_result.error_code == SW_SUCCESS);
+    int mode = (int)in_result.value;
+    assert((mode == 1) || (mode == 2));
+
+    // Sampled parameters
+    assert(sw_input_has(input, "x"));
+    in_result = sw_input_get(input, "x");
+    assert(in_result.error_code == SW_SUCCESS);
+    sw_real_t x = in_result.value;
+    assert(x >= 0.0);
+    assert(x <= 1.0);
+    int x_interval = (int)(8 * x);
+    if (x_interval == 8) x_interval = 7; // (rounding at the upper bound)
+    ++x_hits[mode-1][x_interval];
+
+    assert(sw_input_has(input, "k"));
+    assert(!sw_input_has(input, "log10(k)"));
+    in_result = sw_input_get(input, "k");
+    assert(in_result.error_code == SW_SUCCESS);
+    sw_real_t k = in_result.value;
+    assert(k >= 1e-3);
+    assert(k <= 1.0);
+    int k_interval = (int)(8 * (log10(k) + 3) / 3);
+    if (k_interval == 8) k_interval = 7; // (rounding at the upper bound)
+    ++k_hits[mode-1][k_interval];
+
+    sw_output_set(output, "qoi", mode * x * k);
+  }
+  for (int m = 0; m < 2; ++m) {
+    for (int i = 0; i < 8; ++i) {
+      assert(x_hits[m][i] == 1);
+      assert(k_hits[m][i] == 1);
+    }
+  }
+
+  // Write out a Python module.
+  sw_write_result_t w_result = sw_ensemble_write(ensemble, "sampled_test.py");
+  if (w_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", w_result.error_message);
+    exit(-1);
+  }
+
+  // Clean up.
+  sw_ensemble_free(ensemble);
+}
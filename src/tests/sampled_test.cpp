@@ -0,0 +1,110 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C++ interface with an ensemble that contains
+// parameters sampled from a Latin hypercube.
+
+#include <skywalker.hpp>
+
+#include <cassert>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+
+void usage(const std::string& prog_name) {
+  std::cerr << prog_name << ": usage:" << std::endl;
+  std::cerr << prog_name << " <input.yaml>" << std::endl;
+  exit(0);
+}
+
+static bool approx_equal(sw_real_t x, sw_real_t y) {
+  return (std::abs(x - y) < 1e-14);
+}
+
+using namespace skywalker;
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  std::string input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  print_banner();
+
+  // Load the ensemble. Any error encountered is fatal.
+  std::cerr << "sampled_test: Loading ensemble from " << input_file << std::endl;
+  Ensemble* ensemble = load_ensemble(input_file, "settings");
+
+  // Ensemble data: 2 lattice values times 8 samples
+  assert(ensemble->size() == 16);
+
+  // A Latin hypercube places exactly one sample in each of 8 equal intervals
+  // of each parameter's range. Each lattice value gets the same samples.
+  int x_hits[2][8] = {{0}};
+  ensemble->process([&](const Input& input, Output& output) {
+    // Fixed parameters
+    assert(approx_equal(input.get("p1"), 1.0));
+
+    // Lattice parameters
+    int mode = static_cast<int>(input.get("mode"));
+    assert((mode == 1) or (mode == 2));
+
+    // Sampled parameters
+    assert(input.has("x"));
+    sw_real_t x = input.get("x");
+    assert((x >= 0.0) and (x <= 1.0));
+    ++x_hits[mode-1][std::min(static_cast<int>(8 * x), 7)];
+
+    assert(input.has("k"));
+    sw_real_t k = input.get("k");
+    assert((k >= 1e-3) and (k <= 1.0));
+
+    output.set("qoi", mode * x * k);
+  });
+  for (int m = 0; m < 2; ++m) {
+    for (int i = 0; i < 8; ++i) {
+      assert(x_hits[m][i] == 1);
+    }
+  }
+
+  // Write out a Python module.
+  ensemble->write("sampled_test_cpp.py");
+
+  // Clean up.
+  delete ensemble;
+}
@@ -0,0 +1,147 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests the C++ interface's typed schemas, which map the fields
+// of structs to input parameters and output quantities.
+
+#include <skywalker.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+void usage(const std::string& prog_name) {
+  std::cerr << prog_name << ": usage:" << std::endl;
+  std::cerr << prog_name << " <input.yaml>" << std::endl;
+  exit(0);
+}
+
+using namespace skywalker;
+
+static bool approx_equal(Real x, Real y) {
+  return (std::abs(x - y) < 1e-14);
+}
+
+// Returns the contents of the file with the given name.
+static std::string file_contents(const std::string& filename) {
+  std::ifstream file(filename);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+// Input parameters and output quantities for each ensemble member
+struct TestInput {
+  Real f1, l1, e1;
+  ArrayView ea;
+};
+
+struct TestOutput {
+  Real qoi, odd;
+  std::vector<Real> qoi_array;
+};
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  std::string input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  print_banner();
+
+  // Load the ensemble. Any error encountered is fatal.
+  std::cerr << "schema_test: Loading ensemble from " << input_file << std::endl;
+  Ensemble* ensemble = load_ensemble(input_file, "settings");
+  assert(ensemble->size() == 6);
+
+  auto input_schema = InputSchema<TestInput>().add("f1", &TestInput::f1)
+                                              .add("l1", &TestInput::l1)
+                                              .add("e1", &TestInput::e1)
+                                              .add("ea", &TestInput::ea);
+  auto output_schema = OutputSchema<TestOutput>()
+    .add("qoi", &TestOutput::qoi)
+    .add("odd", &TestOutput::odd)
+    .add("qoi_array", &TestOutput::qoi_array);
+
+  size_t n = 0;
+  ensemble->process(input_schema, output_schema,
+    [&](const TestInput& input, TestOutput& output) {
+      // Outputs are reset for each member.
+      assert(std::isnan(output.qoi));
+      assert(output.qoi_array.empty());
+
+      assert(approx_equal(input.f1, 1.0));
+      assert(approx_equal(input.l1, 1.0 + n / 2));
+      assert(approx_equal(input.e1, 10.0 * (1 + n % 2)));
+      assert(input.ea.size() == 2);
+      assert(approx_equal(input.ea[0], 1.0 + 2 * (n % 2)));
+
+      output.qoi = input.l1 * input.e1;
+      if (n % 2) { // set by odd members only
+        output.odd = input.l1;
+      }
+      output.qoi_array = {input.l1, input.ea[1]};
+      ++n;
+    });
+  assert(n == 6);
+
+  // A schema naming a missing input parameter can't be used.
+  struct Missing { Real x; };
+  try {
+    ensemble->process(InputSchema<Missing>().add("x", &Missing::x),
+                      OutputSchema<TestOutput>(),
+                      [](const Missing&, TestOutput&) { assert(false); });
+    assert(false);
+  } catch (Exception&) {
+  }
+
+  // Write out a Python module containing the output data.
+  ensemble->write("schema_test.py");
+  auto contents = file_contents("schema_test.py");
+  assert(contents.find("output.qoi = [10, 20, 20, 40, 30, 60, ]") !=
+         std::string::npos);
+  assert(contents.find("output.odd = [nan, 1, nan, 2, nan, 3, ]") !=
+         std::string::npos);
+  assert(contents.find(
+    "output.qoi_array = [[1, 2, ],[1, 4, ],[2, 2, ],[2, 4, ],[3, 2, ],[3, 4, ],]")
+    != std::string::npos);
+
+  // Clean up.
+  delete ensemble;
+}
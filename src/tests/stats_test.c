@@ -0,0 +1,250 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C interface for collecting timing and memory
+// statistics for an ensemble.
+
+#include <skywalker.h>
+
+#include <assert.h>
+#include <string.h>
+#include <tgmath.h>
+
+void usage(const char *prog_name) {
+  fprintf(stderr, "%s: usage:\n", prog_name);
+  fprintf(stderr, "%s <input.yaml>\n", prog_name);
+  exit(0);
+}
+
+// Returns true if the file with the given name contains the given text.
+static bool file_contains(const char *filename, const char *text) {
+  FILE *file = fopen(filename, "r");
+  assert(file);
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *contents = malloc(size + 1);
+  size_t num_read = fread(contents, 1, size, file);
+  contents[num_read] = '\0';
+  fclose(file);
+  bool found = (strstr(contents, text) != NULL);
+  free(contents);
+  return found;
+}
+
+// Returns true if the line in the file with the given name that begins with
+// the given prefix exists and doesn't contain the given text.
+static bool line_lacks(const char *filename, const char *prefix,
+                       const char *text) {
+  FILE *file = fopen(filename, "r");
+  assert(file);
+  static char line[65536];
+  bool found = false, lacks = false;
+  while (!found && fgets(line, 65536, file)) {
+    if (!strncmp(line, prefix, strlen(prefix))) {
+      found = true;
+      lacks = (strstr(line, text) == NULL);
+    }
+  }
+  fclose(file);
+  return found && lacks;
+}
+
+// Loads the ensemble in the given file with the given settings block, exiting
+// on failure.
+static sw_ensemble_t *load_block(const char *input_file,
+                                 const char *settings_block) {
+  sw_ensemble_result_t load_result = sw_load_ensemble(input_file,
+                                                      settings_block);
+  if (load_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", load_result.error_message);
+    exit(-1);
+  }
+  return load_result.ensemble;
+}
+
+// Loads the ensemble in the given file, exiting on failure.
+static sw_ensemble_t *load(const char *input_file) {
+  return load_block(input_file, "settings");
+}
+
+// Does some work for the given input, so the driver's time is measurable.
+static sw_real_t work(sw_input_t *input) {
+  sw_real_t x = sw_input_get(input, "x").value;
+  sw_real_t sum = 0.0;
+  for (int i = 0; i < 1000; ++i) {
+    sum += sin(x * i);
+  }
+  return sum;
+}
+
+int main(int argc, char **argv) {
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  const char *input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  sw_print_banner();
+
+  sw_ensemble_t *ensemble = load(input_file);
+  assert(sw_ensemble_size(ensemble) == 100);
+
+  // Loading is always timed, and memory is always measured.
+  sw_ensemble_stats_t stats = sw_ensemble_stats(ensemble);
+  assert(stats.parse_time > 0.0);
+  assert(stats.build_time >= 0.0);
+  assert(stats.traversal_time == 0.0);
+  assert(stats.driver_time == 0.0);
+  assert(stats.write_time == 0.0);
+  assert(stats.input_bytes >= sizeof(sw_real_t) * (1 + 10 + 10 + 20));
+  assert(stats.output_bytes > 0);
+  assert(stats.string_bytes == 0);
+
+  // Traversals aren't timed until we ask for it.
+  sw_input_t *input;
+  sw_output_t *output;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_output_set(output, "w", work(input));
+  }
+  stats = sw_ensemble_stats(ensemble);
+  assert(stats.traversal_time == 0.0);
+  assert(stats.driver_time == 0.0);
+  size_t output_bytes = stats.output_bytes;
+  assert(output_bytes >= sizeof(sw_real_t) * 100);
+
+  sw_ensemble_collect_stats(ensemble);
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_output_set(output, "w", work(input));
+    sw_real_t a[2] = {1.0, 2.0};
+    sw_output_set_array(output, "a", a, 2);
+  }
+  stats = sw_ensemble_stats(ensemble);
+  assert(stats.traversal_time > 0.0);
+  assert(stats.driver_time > 0.0);
+  assert(stats.output_bytes >= output_bytes + sizeof(sw_real_t) * 200);
+
+  // Batched traversals are timed as well.
+  double traversal_time = stats.traversal_time;
+  double driver_time = stats.driver_time;
+  sw_batch_t *batch;
+  while (sw_ensemble_next_batch(ensemble, 16, &batch)) {
+    sw_real_t *w = sw_batch_output_reserve(batch, "w");
+    for (size_t i = 0; i < sw_batch_size(batch); ++i) {
+      assert(sw_batch_get(batch, i, &input, &output));
+      w[i] = work(input);
+    }
+  }
+  stats = sw_ensemble_stats(ensemble);
+  assert(stats.traversal_time > traversal_time);
+  assert(stats.driver_time > driver_time);
+
+  // Error messages are stored in the ensemble's string pool.
+  assert(sw_input_get(input, "nonexistent").error_code == SW_PARAM_NOT_FOUND);
+  stats = sw_ensemble_stats(ensemble);
+  assert(stats.string_bytes > 0);
+
+  // The statistics are written to the module.
+  sw_write_result_t w_result = sw_ensemble_write(ensemble, "stats_test.py");
+  assert(w_result.error_code == SW_SUCCESS);
+  assert(file_contains("stats_test.py", "stats = Object()\n"));
+  assert(file_contains("stats_test.py", "stats.driver_time = "));
+  assert(file_contains("stats_test.py", "stats.string_bytes = "));
+  stats = sw_ensemble_stats(ensemble);
+  assert(stats.write_time > 0.0);
+  sw_ensemble_free(ensemble);
+
+  // An ensemble that doesn't collect statistics doesn't write them.
+  ensemble = load(input_file);
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_output_set(output, "w", 1.0);
+  }
+  w_result = sw_ensemble_write(ensemble, "stats_test_none.py");
+  assert(w_result.error_code == SW_SUCCESS);
+  assert(!file_contains("stats_test_none.py", "stats = Object()"));
+  sw_ensemble_free(ensemble);
+
+  // A streamed module gets its statistics when the stream finishes.
+  ensemble = load(input_file);
+  sw_ensemble_collect_stats(ensemble);
+  w_result = sw_ensemble_stream(ensemble, "stats_test_stream.py", 30);
+  assert(w_result.error_code == SW_SUCCESS);
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_output_set(output, "w", work(input));
+  }
+  assert(file_contains("stats_test_stream.py", "stats.traversal_time = "));
+  sw_ensemble_free(ensemble);
+
+  // A profiled ensemble records the time spent on each member.
+  ensemble = load(input_file);
+  sw_ensemble_profile(ensemble);
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_output_set(output, "w", work(input));
+  }
+  stats = sw_ensemble_stats(ensemble);
+  assert(stats.traversal_time == 0.0); // statistics aren't collected
+  assert(stats.driver_time == 0.0);
+  sw_ensemble_write(ensemble, "stats_test_profile.py");
+  assert(line_lacks("stats_test_profile.py", "output.skywalker_time = [",
+                    "nan"));
+  assert(!file_contains("stats_test_profile.py", "stats = Object()"));
+  sw_ensemble_free(ensemble);
+
+  // Members are profiled if the settings ask for it, including those of a
+  // streaming ensemble.
+  ensemble = load_block(input_file, "profiled");
+  w_result = sw_ensemble_stream(ensemble, "stats_test_profile_stream.py", 30);
+  assert(w_result.error_code == SW_SUCCESS);
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_output_set(output, "w", work(input));
+  }
+  assert(file_contains("stats_test_profile_stream.py",
+                       "_extend('skywalker_time', 90, ["));
+  sw_ensemble_free(ensemble);
+
+  // Members processed in batches aren't profiled.
+  ensemble = load_block(input_file, "profiled");
+  while (sw_ensemble_next_batch(ensemble, 16, &batch)) {
+    sw_real_t *w = sw_batch_output_reserve(batch, "w");
+    for (size_t i = 0; i < sw_batch_size(batch); ++i) {
+      assert(sw_batch_get(batch, i, &input, &output));
+      w[i] = work(input);
+    }
+  }
+  sw_ensemble_write(ensemble, "stats_test_profile_batch.py");
+  assert(file_contains("stats_test_profile_batch.py",
+                       "output.skywalker_time = [nan, nan, "));
+  sw_ensemble_free(ensemble);
+}
@@ -0,0 +1,127 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C++ interface for collecting timing and
+// memory statistics for an ensemble.
+
+#include <skywalker.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+void usage(const std::string& prog_name) {
+  std::cerr << prog_name << ": usage:" << std::endl;
+  std::cerr << prog_name << " <input.yaml>" << std::endl;
+  exit(0);
+}
+
+using namespace skywalker;
+
+// Returns the contents of the file with the given name.
+static std::string file_contents(const std::string& filename) {
+  std::ifstream file(filename);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+// Does some work for the given input, so the driver's time is measurable.
+static Real work(const Input& input) {
+  Real x = input.get("x");
+  Real sum = 0.0;
+  for (int i = 0; i < 1000; ++i) {
+    sum += std::sin(x * i);
+  }
+  return sum;
+}
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  std::string input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  print_banner();
+
+  // Load the ensemble. Any error encountered is fatal.
+  Ensemble* ensemble = load_ensemble(input_file, "settings");
+  assert(ensemble->size() == 100);
+
+  // Loading is always timed, and memory is always measured.
+  Stats stats = ensemble->stats();
+  assert(stats.parse_time > 0.0);
+  assert(stats.traversal_time == 0.0);
+  assert(stats.driver_time == 0.0);
+  assert(stats.input_bytes > 0);
+
+  // Processing is timed once we ask for it.
+  ensemble->collect_stats();
+  ensemble->process([](const Input& input, Output& output) {
+    output.set("w", work(input));
+  });
+  stats = ensemble->stats();
+  assert(stats.traversal_time > 0.0);
+  assert(stats.driver_time > 0.0);
+  assert(stats.output_bytes >= sizeof(Real) * 100);
+
+  // The statistics are written to the module.
+  ensemble->write("stats_test_cpp.py");
+  std::string contents = file_contents("stats_test_cpp.py");
+  assert(contents.find("stats = Object()\n") != std::string::npos);
+  assert(contents.find("stats.driver_time = ") != std::string::npos);
+  assert(ensemble->stats().write_time > 0.0);
+
+  // Clean up.
+  delete ensemble;
+
+  // A profiled ensemble records the time spent processing each member.
+  ensemble = load_ensemble(input_file, "settings");
+  ensemble->profile();
+  ensemble->process([](const Input& input, Output& output) {
+    output.set("w", work(input));
+  });
+  ensemble->write("stats_test_profile_cpp.py");
+  contents = file_contents("stats_test_profile_cpp.py");
+  size_t begin = contents.find("output.skywalker_time = [");
+  assert(begin != std::string::npos);
+  std::string times = contents.substr(begin, contents.find('\n', begin) - begin);
+  assert(times.find("nan") == std::string::npos);
+  delete ensemble;
+}
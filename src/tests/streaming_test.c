@@ -0,0 +1,155 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C interface for streaming ensemble outputs to
+// a Python module as the ensemble is traversed.
+
+#include <skywalker.h>
+
+#include <assert.h>
+#include <string.h>
+#include <tgmath.h>
+
+void usage(const char *prog_name) {
+  fprintf(stderr, "%s: usage:\n", prog_name);
+  fprintf(stderr, "%s <input.yaml>\n", prog_name);
+  exit(0);
+}
+
+// Returns true if the file with the given name contains the given text.
+static bool file_contains(const char *filename, const char *text) {
+  FILE *file = fopen(filename, "r");
+  assert(file);
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *contents = malloc(size + 1);
+  size_t num_read = fread(contents, 1, size, file);
+  contents[num_read] = '\0';
+  fclose(file);
+  bool found = (strstr(contents, text) != NULL);
+  free(contents);
+  return found;
+}
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  const char* input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  sw_print_banner();
+
+  // Load the ensemble. Any error encountered is fatal.
+  fprintf(stderr, "streaming_test: Loading ensemble from %s\n", input_file);
+  sw_ensemble_result_t load_result = sw_load_ensemble(input_file, "settings");
+  if (load_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", load_result.error_message);
+    exit(-1);
+  }
+
+  // Ensemble data
+  sw_ensemble_t *ensemble = load_result.ensemble;
+  assert(sw_ensemble_size(ensemble) == 10);
+
+  // Stream outputs in chunks of 3 members.
+  const char *module_filename = "streaming_test.py";
+  assert(sw_ensemble_stream(ensemble, module_filename, 0).error_code ==
+         SW_WRITE_FAILURE);
+  sw_write_result_t w_result = sw_ensemble_stream(ensemble, module_filename, 3);
+  if (w_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", w_result.error_message);
+    exit(-1);
+  }
+  assert(sw_ensemble_stream(ensemble, module_filename, 3).error_code ==
+         SW_WRITE_FAILURE);
+
+  // Inputs are written up front.
+  assert(file_contains(module_filename,
+                       "input.x = [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, ]"));
+
+  // Members of a streaming ensemble are available only in sequence.
+  sw_input_t *input;
+  sw_output_t *output;
+  assert(!sw_ensemble_get(ensemble, 0, &input, &output));
+  sw_ensemble_range_t range = sw_ensemble_range(ensemble, 0, 10);
+  assert(!sw_ensemble_range_next(&range, &input, &output));
+
+  size_t i = 0;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    // The first chunk is handed to the writer once the traversal moves past
+    // it, and is written by the time the traversal moves past the next one.
+    if (i == 6) {
+      assert(file_contains(module_filename, "_extend('x2', 0, [1, 4, 9, ])"));
+      assert(!file_contains(module_filename, "_extend('x2', 6,"));
+    }
+
+    sw_input_result_t in_result = sw_input_get(input, "x");
+    assert(in_result.error_code == SW_SUCCESS);
+    sw_real_t x = in_result.value;
+
+    sw_output_set(output, "x2", x * x);
+    if (x >= 5.0) { // set by members in later chunks only
+      sw_output_set(output, "late", x);
+    }
+    sw_real_t values[2] = {x, x + 1};
+    sw_output_set_array(output, "xs", values, (size_t)x % 3);
+    ++i;
+  }
+  assert(i == 10);
+
+  // The stream finishes at the end of the traversal, and its ensemble can't be
+  // traversed again.
+  assert(file_contains(module_filename, "_extend('x2', 9, [100, ])"));
+  assert(file_contains(module_filename, "_extend('late', 3, [nan, 5, 6, ])"));
+  assert(file_contains(module_filename,
+                       "_extend('xs', 6, [[7, ],[8, 9, ],[],], True)"));
+  assert(file_contains(module_filename, "_finish(10)\n"));
+  assert(!sw_ensemble_next(ensemble, &input, &output));
+
+  // The outputs can't be written anywhere else.
+  w_result = sw_ensemble_write(ensemble, "streaming_test_copy.py");
+  assert(w_result.error_code == SW_WRITE_FAILURE);
+  w_result = sw_ensemble_write(ensemble, module_filename);
+  if (w_result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "%s\n", w_result.error_message);
+    exit(-1);
+  }
+
+  // Clean up.
+  sw_ensemble_free(ensemble);
+}
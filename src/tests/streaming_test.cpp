@@ -0,0 +1,125 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program tests Skywalker's C++ interface for streaming ensemble outputs
+// to a Python module as the ensemble is processed.
+
+#include <skywalker.hpp>
+
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+void usage(const std::string& prog_name) {
+  std::cerr << prog_name << ": usage:" << std::endl;
+  std::cerr << prog_name << " <input.yaml>" << std::endl;
+  exit(0);
+}
+
+// Returns the contents of the file with the given name.
+static std::string file_contents(const std::string& filename) {
+  std::ifstream file(filename);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+using namespace skywalker;
+
+int main(int argc, char **argv) {
+
+  if (argc == 1) {
+    usage((const char*)argv[0]);
+  }
+  std::string input_file = argv[1];
+
+  // Print a banner with Skywalker's version info.
+  print_banner();
+
+  // Load the ensemble. Any error encountered is fatal.
+  std::cerr << "streaming_test: Loading ensemble from " << input_file << std::endl;
+  Ensemble* ensemble = load_ensemble(input_file, "settings");
+  assert(ensemble->size() == 10);
+
+  // Stream outputs in chunks of 4 members.
+  std::string module_filename = "streaming_test_cpp.py";
+  ensemble->stream(module_filename, 4);
+  try {
+    ensemble->stream(module_filename, 4);
+    assert(false);
+  } catch (Exception&) {
+  }
+
+  // Members of a streaming ensemble can't be processed in parallel.
+  ensemble->process_parallel([](const Input&, Output&) { assert(false); });
+
+  size_t i = 0;
+  ensemble->process([&](const Input& input, Output& output) {
+    // The first chunk is handed to the writer once processing moves past it,
+    // and is written by the time processing moves past the next one.
+    if (i == 8) {
+      auto contents = file_contents(module_filename);
+      assert(contents.find("_extend('x2', 0, [1, 4, 9, 16, ])") !=
+             std::string::npos);
+    }
+
+    Real x = input.get("x");
+    output.set("x2", x * x);
+    if (x >= 5.0) {
+      output.set("late", x);
+    }
+    output.set("xs", std::vector<Real>({x, x + 1}));
+    ++i;
+  });
+  assert(i == 10);
+
+  auto contents = file_contents(module_filename);
+  assert(contents.find("_extend('late', 4, [5, 6, 7, 8, ])") !=
+         std::string::npos);
+  assert(contents.find("_extend('xs', 8, [[9, 10, ],[10, 11, ],], True)") !=
+         std::string::npos);
+
+  // The outputs can't be written anywhere else.
+  try {
+    ensemble->write("streaming_test_cpp_copy.py");
+    assert(false);
+  } catch (Exception&) {
+  }
+  ensemble->write(module_filename);
+
+  // Clean up.
+  delete ensemble;
+}
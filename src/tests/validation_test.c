@@ -38,8 +38,15 @@
 #include <skywalker.h>
 
 #include <assert.h>
+#include <stdint.h>
 #include <string.h>
 
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 static void test_nonexistent_file() {
   sw_ensemble_result_t load_result = sw_load_ensemble("/nope", "settings");
   assert(load_result.error_code == SW_YAML_FILE_NOT_FOUND);
@@ -130,17 +137,99 @@ static void test_duplicate_param() {
   assert(load_result.error_message != NULL);
 }
 
-static void test_too_many_lattice_params() {
-  const char* bad_yaml =
+static void test_many_lattice_params() {
+  // A lattice can have any number of traversed parameters. Parameter xk takes
+  // the values 0 and 1, which form bit k of a code that identifies each member.
+  const char* yaml =
     "settings:\n  a: 1\n\n"
     "input:\n  lattice:\n"
-    "    x1: [1, 2]\n    x2: [2, 3]\n    x3: [3,4]\n"
-    "    x4: [4, 5]\n    x5: [5, 6]\n    x6: [6,7]\n"
-    "    x7: [7, 8]\n    x8: [8, 9]\n";
-  write_test_input(bad_yaml, "too_many_lattice_params.yaml");
+    "    x0: [0, 1]\n    x1: [0, 1]\n    x2: [0, 1]\n    x3: [0, 1]\n"
+    "    x4: [0, 1]\n    x5: [0, 1]\n    x6: [0, 1]\n    x7: [0, 1]\n"
+    "    x8: [0, 1]\n    x9: [0, 1]\n    x10: [0, 1]\n    x11: [0, 1]\n";
+  write_test_input(yaml, "many_lattice_params.yaml");
+  sw_ensemble_result_t load_result =
+    sw_load_ensemble("many_lattice_params.yaml", "settings");
+  assert(load_result.error_code == SW_SUCCESS);
+  sw_ensemble_t *ensemble = load_result.ensemble;
+  assert(sw_ensemble_size(ensemble) == 4096);
+
+  // Every combination of values appears exactly once.
+  static bool found[4096];
+  sw_input_t *input;
+  sw_output_t *output;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    int code = 0;
+    for (int k = 0; k < 12; ++k) {
+      char name[4];
+      snprintf(name, 4, "x%d", k);
+      sw_input_result_t in_result = sw_input_get(input, name);
+      assert(in_result.error_code == SW_SUCCESS);
+      code |= (int)in_result.value << k;
+    }
+    assert(!found[code]);
+    found[code] = true;
+  }
+  sw_ensemble_free(ensemble);
+}
+
+static void test_sobol_sampling() {
+  // The first points of the 2D Sobol sequence are (0, 0), (1/2, 1/2),
+  // (3/4, 1/4), and (1/4, 3/4). Dimensions are assigned alphabetically, so
+  // "a" gets the first and "b" the second.
+  const char* yaml =
+    "settings:\n  a: 1\n\n"
+    "input:\n  sampled:\n"
+    "    method: sobol\n    samples: 4\n"
+    "    b: [-1, 1]\n    a: [0, 4]\n";
+  write_test_input(yaml, "sobol_sampling.yaml");
+  sw_ensemble_result_t load_result =
+    sw_load_ensemble("sobol_sampling.yaml", "settings");
+  assert(load_result.error_code == SW_SUCCESS);
+  sw_ensemble_t *ensemble = load_result.ensemble;
+  assert(sw_ensemble_size(ensemble) == 4);
+
+  const sw_real_t a[4] = {0.0, 2.0, 3.0, 1.0}, b[4] = {-1.0, 0.0, -0.5, 0.5};
+  sw_input_t *input;
+  sw_output_t *output;
+  int i = 0;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    assert(sw_input_get(input, "a").value == a[i]);
+    assert(sw_input_get(input, "b").value == b[i]);
+    ++i;
+  }
+  sw_ensemble_free(ensemble);
+}
+
+static void test_invalid_sampling() {
+  // no number of samples
+  const char* bad_yaml =
+    "settings:\n  a: 1\n\n"
+    "input:\n  sampled:\n"
+    "    x: [0, 1]\n";
+  write_test_input(bad_yaml, "invalid_sampling.yaml");
   sw_ensemble_result_t load_result =
-    sw_load_ensemble("too_many_lattice_params.yaml", "settings");
-  assert(load_result.error_code == SW_TOO_MANY_LATTICE_PARAMS);
+    sw_load_ensemble("invalid_sampling.yaml", "settings");
+  assert(load_result.error_code == SW_INVALID_PARAM_VALUE);
+  assert(load_result.error_message != NULL);
+
+  // invalid method
+  bad_yaml =
+    "settings:\n  a: 1\n\n"
+    "input:\n  sampled:\n"
+    "    method: monte_carlo\n    samples: 4\n    x: [0, 1]\n";
+  write_test_input(bad_yaml, "invalid_sampling.yaml");
+  load_result = sw_load_ensemble("invalid_sampling.yaml", "settings");
+  assert(load_result.error_code == SW_INVALID_PARAM_VALUE);
+  assert(load_result.error_message != NULL);
+
+  // invalid range
+  bad_yaml =
+    "settings:\n  a: 1\n\n"
+    "input:\n  sampled:\n"
+    "    samples: 4\n    x: [1, 0]\n";
+  write_test_input(bad_yaml, "invalid_sampling.yaml");
+  load_result = sw_load_ensemble("invalid_sampling.yaml", "settings");
+  assert(load_result.error_code == SW_INVALID_PARAM_VALUE);
   assert(load_result.error_message != NULL);
 }
 
@@ -156,6 +245,274 @@ static void test_invalid_enumeration() {
   assert(load_result.error_message != NULL);
 }
 
+static void test_long_enumeration() {
+  // Long lists of enumerated values are parsed ahead of the YAML parser, and
+  // must produce exactly the values strtod produces for each number.
+  const char* formats[] = {"%d", "%d.%d", "-%de-%d", "%d.%de+%d", "1e%d"};
+  char values[256][32];
+  char yaml[16384];
+  int pos = sprintf(yaml, "settings:\n  a: 1\n\n"
+                          "input:\n  enumerated:\n    x: [");
+  for (int i = 0; i < 256; ++i) {
+    snprintf(values[i], 32, formats[i % 5], 12345 * i + 7, i % 37, i % 29);
+    pos += sprintf(&yaml[pos], (i < 255) ? "%s,%s" : "%s]\n", values[i],
+                   (i % 10 == 9) ? "\n       " : " ");
+  }
+  write_test_input(yaml, "long_enumeration.yaml");
+  sw_ensemble_result_t load_result =
+    sw_load_ensemble("long_enumeration.yaml", "settings");
+  assert(load_result.error_code == SW_SUCCESS);
+  sw_ensemble_t *ensemble = load_result.ensemble;
+  assert(sw_ensemble_size(ensemble) == 256);
+
+  sw_input_t *input;
+  sw_output_t *output;
+  int i = 0;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    sw_real_t x = strtod(values[i], NULL);
+    assert(sw_input_get(input, "x").value == x);
+    ++i;
+  }
+  sw_ensemble_free(ensemble);
+}
+
+// Writes n values of x(i) = 2 i + 1 to a .npy file with the given name, with
+// the given type descriptor.
+static void write_test_npy(const char *filename, const char *descr, size_t n) {
+  char header[128];
+  int len = snprintf(header, 128, "{'descr': '%s', 'fortran_order': False, "
+                     "'shape': (%zu,), }", descr, n);
+  while ((10 + len + 1) % 64) header[len++] = ' ';
+  header[len++] = '\n';
+  FILE *f = fopen(filename, "wb");
+  fwrite("\x93NUMPY\x01\x00", 1, 8, f);
+  unsigned char header_len[2] = {len & 0xff, len >> 8};
+  fwrite(header_len, 1, 2, f);
+  fwrite(header, 1, len, f);
+  for (size_t i = 0; i < n; ++i) {
+    sw_real_t x = 2 * i + 1;
+    fwrite(&x, sizeof(sw_real_t), 1, f);
+  }
+  fclose(f);
+}
+
+static void test_enumerated_files() {
+  // Enumerated parameters can read their values from .npy files and from
+  // files of raw sw_real_t values.
+  const uint16_t one = 1;
+  char descr[8];
+  snprintf(descr, 8, "%cf%zu", (*(const char*)&one) ? '<' : '>',
+           sizeof(sw_real_t));
+  write_test_npy("enumerated_x.npy", descr, 100);
+  FILE *f = fopen("enumerated_y.bin", "wb");
+  for (int i = 0; i < 100; ++i) {
+    sw_real_t y = -i;
+    fwrite(&y, sizeof(sw_real_t), 1, f);
+  }
+  fclose(f);
+  const char* yaml =
+    "settings:\n  a: 1\n\n"
+    "input:\n  lattice:\n    p: [1, 2]\n"
+    "  enumerated:\n"
+    "    x: !file enumerated_x.npy\n"
+    "    y: !file enumerated_y.bin\n";
+  write_test_input(yaml, "enumerated_files.yaml");
+  sw_ensemble_result_t load_result =
+    sw_load_ensemble("enumerated_files.yaml", "settings");
+  assert(load_result.error_code == SW_SUCCESS);
+  sw_ensemble_t *ensemble = load_result.ensemble;
+  assert(sw_ensemble_size(ensemble) == 200);
+  sw_input_t *input;
+  sw_output_t *output;
+  int i = 0;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    assert(sw_input_get(input, "p").value == 1 + i / 100);
+    assert(sw_input_get(input, "x").value == 2 * (i % 100) + 1);
+    assert(sw_input_get(input, "y").value == -(i % 100));
+    ++i;
+  }
+  sw_ensemble_free(ensemble);
+
+  // The number of values must match those of other enumerated parameters.
+  yaml =
+    "settings:\n  a: 1\n\n"
+    "input:\n  enumerated:\n"
+    "    x: !file enumerated_x.npy\n"
+    "    z: [1, 2, 3]\n";
+  write_test_input(yaml, "enumerated_files.yaml");
+  load_result = sw_load_ensemble("enumerated_files.yaml", "settings");
+  assert(load_result.error_code == SW_INVALID_ENUMERATION);
+
+  // Values must have the right type.
+  write_test_npy("enumerated_x.npy", "<i2", 100);
+  yaml =
+    "settings:\n  a: 1\n\n"
+    "input:\n  enumerated:\n"
+    "    x: !file enumerated_x.npy\n";
+  write_test_input(yaml, "enumerated_files.yaml");
+  load_result = sw_load_ensemble("enumerated_files.yaml", "settings");
+  assert(load_result.error_code == SW_INVALID_INPUT_FILE);
+  assert(load_result.error_message != NULL);
+
+  // Files must exist.
+  yaml =
+    "settings:\n  a: 1\n\n"
+    "input:\n  enumerated:\n"
+    "    x: !file nonexistent.npy\n";
+  write_test_input(yaml, "enumerated_files.yaml");
+  load_result = sw_load_ensemble("enumerated_files.yaml", "settings");
+  assert(load_result.error_code == SW_INVALID_INPUT_FILE);
+
+  // Only enumerated parameters can be read from files.
+  yaml =
+    "settings:\n  a: 1\n\n"
+    "input:\n  lattice:\n"
+    "    x: !file enumerated_y.bin\n";
+  write_test_input(yaml, "enumerated_files.yaml");
+  load_result = sw_load_ensemble("enumerated_files.yaml", "settings");
+  assert(load_result.error_code == SW_INVALID_PARAM_VALUE);
+}
+
+// Stores the values of the parameters x, y, z, and a[1] for all members of
+// the ensemble in the given YAML file (with 12 members) in values, checking
+// its settings.
+static void load_cached_ensemble(const char *yaml_file, sw_real_t values[48]) {
+  sw_ensemble_result_t load_result = sw_load_ensemble(yaml_file, "settings");
+  assert(load_result.error_code == SW_SUCCESS);
+  assert(!strcmp(sw_settings_get(load_result.settings, "a").value, "hi"));
+  sw_ensemble_t *ensemble = load_result.ensemble;
+  assert(sw_ensemble_size(ensemble) == 12);
+  sw_input_t *input;
+  sw_output_t *output;
+  int i = 0;
+  while (sw_ensemble_next(ensemble, &input, &output)) {
+    values[4*i]   = sw_input_get(input, "x").value;
+    values[4*i+1] = sw_input_get(input, "y").value;
+    values[4*i+2] = sw_input_get(input, "z").value;
+    sw_input_array_result_t a = sw_input_get_array(input, "a");
+    assert(a.size == 2);
+    values[4*i+3] = a.values[1];
+    ++i;
+  }
+  sw_ensemble_free(ensemble);
+}
+
+#ifndef _WIN32
+// Stores the path of the (only) cache file in the given directory.
+static void find_cache_file(const char *cache_dir, char path[512]) {
+  path[0] = '\0';
+  DIR *dir = opendir(cache_dir);
+  struct dirent *entry;
+  while ((entry = readdir(dir))) {
+    if (strstr(entry->d_name, ".swcache"))
+      snprintf(path, 512, "%s/%s", cache_dir, entry->d_name);
+  }
+  closedir(dir);
+  assert(path[0]);
+}
+#endif
+
+static void test_parse_cache() {
+#ifndef _WIN32
+  // Ensembles loaded from the cache are identical to parsed ones, and broken
+  // cache files are ignored.
+  mkdir("parse_cache", 0755);
+  setenv("SKYWALKER_CACHE_DIR", "parse_cache", 1);
+  FILE *f = fopen("parse_cache_z.bin", "wb");
+  for (int i = 0; i < 2; ++i) {
+    sw_real_t z = 10 * i;
+    fwrite(&z, sizeof(sw_real_t), 1, f);
+  }
+  fclose(f);
+  const char* yaml =
+    "settings:\n  a: hi\n\n"
+    "input:\n  fixed:\n    a: [1, 2]\n"
+    "  lattice:\n    x: [0, 1, 0.5]\n    log10(y): [1, 2]\n"
+    "  enumerated:\n    z: !file parse_cache_z.bin\n";
+  write_test_input(yaml, "parse_cache.yaml");
+
+  sw_real_t parsed[48], cached[48];
+  load_cached_ensemble("parse_cache.yaml", parsed); // writes the cache
+  load_cached_ensemble("parse_cache.yaml", cached); // reads it
+  assert(!memcmp(parsed, cached, sizeof(parsed)));
+
+  // Truncate the cache file.
+  char path[512];
+  find_cache_file("parse_cache", path);
+  assert(!truncate(path, 100));
+  load_cached_ensemble("parse_cache.yaml", cached);
+  assert(!memcmp(parsed, cached, sizeof(parsed)));
+
+  // A cache file built from different YAML text of the same length is ignored
+  // even if its name and hash match, as they would if the hashes of the texts
+  // collided. We fake a collision by copying the cache file for the first
+  // input over the one for the second, keeping the second one's header.
+  const char* other_yaml =
+    "settings:\n  a: hi\n\n"
+    "input:\n  fixed:\n    a: [1, 2]\n"
+    "  lattice:\n    x: [0, 2, 1.0]\n    log10(y): [1, 2]\n"
+    "  enumerated:\n    z: !file parse_cache_z.bin\n";
+  assert(strlen(other_yaml) == strlen(yaml));
+  write_test_input(other_yaml, "parse_cache_other.yaml");
+  mkdir("parse_cache_other", 0755);
+  setenv("SKYWALKER_CACHE_DIR", "parse_cache_other", 1);
+  sw_real_t other_parsed[48];
+  load_cached_ensemble("parse_cache_other.yaml", other_parsed);
+  assert(memcmp(parsed, other_parsed, sizeof(parsed)));
+  char other_path[512];
+  find_cache_file("parse_cache_other", other_path);
+  char *contents = malloc(1 << 16);
+  FILE *f_other = fopen(other_path, "rb");
+  assert(fread(contents, 1, 32, f_other) == 32); // magic, hash, text length
+  fclose(f_other);
+  FILE *f_first = fopen(path, "rb");
+  assert(fseek(f_first, 32, SEEK_SET) == 0);
+  size_t size = 32 + fread(&contents[32], 1, (1 << 16) - 32, f_first);
+  fclose(f_first);
+  f_other = fopen(other_path, "wb");
+  assert(fwrite(contents, 1, size, f_other) == size);
+  fclose(f_other);
+  free(contents);
+  load_cached_ensemble("parse_cache_other.yaml", cached);
+  assert(!memcmp(other_parsed, cached, sizeof(parsed)));
+
+  // An input with a long enumerated list (which is prescanned, modifying the
+  // text as it's parsed) is read from its cache file the second time it's
+  // loaded. Cache files are replaced when they're written, so the file must
+  // be the same one afterward.
+  char long_yaml[1024] = "settings:\n  a: hi\n\ninput:\n  enumerated:\n"
+                         "    x: [";
+  for (int i = 0; i < 100; ++i) {
+    char value[16];
+    snprintf(value, 16, (i < 99) ? "%d, " : "%d]\n", i);
+    strcat(long_yaml, value);
+  }
+  write_test_input(long_yaml, "parse_cache_long.yaml");
+  mkdir("parse_cache_long", 0755);
+  setenv("SKYWALKER_CACHE_DIR", "parse_cache_long", 1);
+  struct stat first_stat, second_stat;
+  for (int l = 0; l < 2; ++l) {
+    sw_ensemble_result_t load_result =
+      sw_load_ensemble("parse_cache_long.yaml", "settings");
+    assert(load_result.error_code == SW_SUCCESS);
+    sw_ensemble_t *ensemble = load_result.ensemble;
+    assert(sw_ensemble_size(ensemble) == 100);
+    sw_input_t *input;
+    sw_output_t *output;
+    int i = 0;
+    while (sw_ensemble_next(ensemble, &input, &output)) {
+      assert(sw_input_get(input, "x").value == i);
+      ++i;
+    }
+    sw_ensemble_free(ensemble);
+    find_cache_file("parse_cache_long", path);
+    assert(!stat(path, (l == 0) ? &first_stat : &second_stat));
+  }
+  assert(first_stat.st_ino == second_stat.st_ino);
+  unsetenv("SKYWALKER_CACHE_DIR");
+#endif
+}
+
 static void test_empty_ensemble() {
   const char* bad_yaml =
     "settings:\n  a: 1\n\n"
@@ -229,8 +586,13 @@ int main(int argc, char **argv) {
   test_missing_settings_block();
   test_invalid_param_name();
   test_duplicate_param();
-  test_too_many_lattice_params();
+  test_many_lattice_params();
+  test_sobol_sampling();
+  test_invalid_sampling();
   test_invalid_enumeration();
+  test_long_enumeration();
+  test_enumerated_files();
+  test_parse_cache();
   test_empty_ensemble();
   test_negative_values_issue_33();
   test_improper_input_indentation();
@@ -0,0 +1,92 @@
+//-------------------------------------------------------------------------
+// Copyright (c) 2021,
+// National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS, the U.S. Government
+// retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Sandia Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//-------------------------------------------------------------------------
+
+// This program merges and slices Skywalker NumPy archives (.npz files written
+// by sw_ensemble_write) without loading them into memory, so it works for
+// archives of any size. Merging archives written by separate runs over parts
+// of an ensemble produces the archive a single run would have written.
+
+#include <skywalker.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void usage(void) {
+  fprintf(stderr, "skywalker_archive: merges or slices Skywalker NumPy "
+                  "archives (.npz files).\n");
+  fprintf(stderr, "skywalker_archive: usage:\n");
+  fprintf(stderr, "skywalker_archive merge <merged.npz> <archive1.npz> "
+                  "<archive2.npz> [... <archiveN.npz>]\n");
+  fprintf(stderr, "  writes the members of all archives, in order, to "
+                  "merged.npz\n");
+  fprintf(stderr, "skywalker_archive slice <archive.npz> <begin> <end> "
+                  "<sliced.npz>\n");
+  fprintf(stderr, "  writes members [begin, end) (numbered from 0) of "
+                  "archive.npz to sliced.npz\n");
+  exit(-1);
+}
+
+// Parses a member index from the given command line argument, exiting on
+// failure.
+static size_t parse_index(const char *arg) {
+  char *end;
+  unsigned long long index = strtoull(arg, &end, 10);
+  if ((*arg == '\0') || (*arg == '-') || (*end != '\0')) {
+    fprintf(stderr, "skywalker_archive: invalid member index: %s\n", arg);
+    exit(-1);
+  }
+  return (size_t)index;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) usage();
+
+  sw_write_result_t result = {.error_code = SW_SUCCESS};
+  if (!strcmp(argv[1], "merge") && (argc >= 5)) {
+    result = sw_archive_merge((size_t)(argc - 3), (const char**)&argv[3],
+                              argv[2]);
+  } else if (!strcmp(argv[1], "slice") && (argc == 6)) {
+    result = sw_archive_slice(argv[2], parse_index(argv[3]),
+                              parse_index(argv[4]), argv[5]);
+  } else {
+    usage();
+  }
+  if (result.error_code != SW_SUCCESS) {
+    fprintf(stderr, "skywalker_archive: %s\n", result.error_message);
+    exit(-1);
+  }
+  return 0;
+}